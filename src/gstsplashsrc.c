@@ -0,0 +1,436 @@
+#include "gstsplashsrc.h"
+#include <stdlib.h>
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC(gst_splash_src_debug);
+#define GST_CAT_DEFAULT gst_splash_src_debug
+
+enum {
+  PROP_0,
+  PROP_LOCATION,
+  PROP_FPS,
+  PROP_SEQUENCES,
+  PROP_INDEX,
+  PROP_INDEX_PATH,
+  PROP_CACHE_BYTES,
+  PROP_CACHE_PIN,
+  PROP_PS_INTERVAL,
+  PROP_ACTIVE_SEQUENCE,
+  PROP_STATS,
+};
+
+enum {
+  SIGNAL_ENQUEUE,
+  SIGNAL_CLEAR,
+  N_SIGNALS
+};
+static guint signals[N_SIGNALS];
+
+#define DEFAULT_FPS         30.0
+#define DEFAULT_CACHE_PIN   2
+#define DEFAULT_PS_INTERVAL 1000
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE("src",
+  GST_PAD_SRC, GST_PAD_ALWAYS,
+  GST_STATIC_CAPS("video/x-h265, stream-format=(string)byte-stream, alignment=(string)au"));
+
+G_DEFINE_TYPE(GstSplashSrc, gst_splash_src, GST_TYPE_PUSH_SRC)
+
+#define GST_TYPE_SPLASH_SRC_INDEX (gst_splash_src_index_get_type())
+static GType gst_splash_src_index_get_type(void){
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    { SPLASH_INDEX_AUTO,   "Load or write the <location>.idx sidecar", "auto" },
+    { SPLASH_INDEX_MEMORY, "Scan the input, never touch the sidecar",  "memory" },
+    { 0, NULL, NULL }
+  };
+  if (g_once_init_enter(&id)) {
+    g_once_init_leave(&id, g_enum_register_static("GstSplashSrcIndex", values));
+  }
+  return (GType)id;
+}
+
+#define GST_TYPE_SPLASH_SRC_REPEAT (gst_splash_src_repeat_get_type())
+static GType gst_splash_src_repeat_get_type(void){
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    { SPLASH_REPEAT_NONE, "Keep looping whatever plays last", "none" },
+    { SPLASH_REPEAT_LAST, "Loop the last queued sequence",    "last" },
+    { SPLASH_REPEAT_FULL, "Loop the whole queued order",      "full" },
+    { 0, NULL, NULL }
+  };
+  if (g_once_init_enter(&id)) {
+    g_once_init_leave(&id, g_enum_register_static("GstSplashSrcRepeat", values));
+  }
+  return (GType)id;
+}
+
+// ---- sequences ----
+static void clear_sequences(GstSplashSrc *self){
+  g_strfreev(self->seq_names);
+  self->seq_names = NULL;
+  g_free(self->seqs);
+  self->seqs = NULL;
+  self->n_seqs = 0;
+}
+
+// Parses "name:start-end[,name:start-end...]". Caller holds self->lock.
+static gboolean parse_sequences_locked(GstSplashSrc *self, const gchar *desc){
+  clear_sequences(self);
+  if (!desc || !*desc) return TRUE;
+  gchar **items = g_strsplit(desc, ",", -1);
+  guint n = g_strv_length(items);
+  self->seq_names = g_new0(gchar*, n + 1);
+  self->seqs = g_new0(SplashSeq, n);
+  gboolean ok = TRUE;
+  for (guint i = 0; i < n && ok; ++i) {
+    gchar *item = g_strstrip(items[i]);
+    gchar *colon = strrchr(item, ':');
+    gchar *end = NULL;
+    ok = colon && colon != item;
+    if (ok) {
+      long first = strtol(colon + 1, &end, 10);
+      ok = end != colon + 1 && *end == '-' && first >= 0;
+      if (ok) {
+        gchar *dash = end;
+        long last = strtol(dash + 1, &end, 10);
+        ok = end != dash + 1 && *end == '\0' && last >= first;
+        if (ok) {
+          self->seq_names[i] = g_strndup(item, (gsize)(colon - item));
+          self->seqs[i].name = self->seq_names[i];
+          self->seqs[i].start_frame = (int)first;
+          self->seqs[i].end_frame = (int)last;
+          self->n_seqs = (gint)i + 1;
+        }
+      }
+    }
+  }
+  g_strfreev(items);
+  if (!ok) clear_sequences(self);
+  return ok;
+}
+
+// ---- events ----
+// Events arrive on the engine's dispatcher thread; switches are recorded here
+// and posted from create() so the message goes out with the streaming thread.
+static void on_splash_event(SplashEventType type, int a, int b, const char *msg, void *user){
+  GstSplashSrc *self = GST_SPLASH_SRC(user);
+  if (type == SPLASH_EVT_SWITCHED_AT_BOUNDARY) {
+    g_mutex_lock(&self->evt_lock);
+    self->switch_from = a;
+    self->switch_to = b;
+    g_mutex_unlock(&self->evt_lock);
+  } else if (type == SPLASH_EVT_ERROR) {
+    GST_WARNING_OBJECT(self, "splash error: %s", msg ? msg : "unknown");
+  }
+}
+
+static void post_pending_switch(GstSplashSrc *self){
+  g_mutex_lock(&self->evt_lock);
+  int a = self->switch_from, b = self->switch_to;
+  self->switch_from = self->switch_to = -1;
+  g_mutex_unlock(&self->evt_lock);
+  if (b < 0) return;
+  g_mutex_lock(&self->lock);
+  GstStructure *st = gst_structure_new("splash-switched",
+    "from", G_TYPE_STRING, (a >= 0 && a < self->n_seqs) ? self->seq_names[a] : NULL,
+    "to", G_TYPE_STRING, b < self->n_seqs ? self->seq_names[b] : NULL,
+    "from-index", G_TYPE_INT, a, "to-index", G_TYPE_INT, b, NULL);
+  g_mutex_unlock(&self->lock);
+  gst_element_post_message(GST_ELEMENT(self),
+                           gst_message_new_element(GST_OBJECT(self), st));
+}
+
+// ---- actions ----
+static gboolean gst_splash_src_enqueue(GstSplashSrc *self, const gchar *names, SplashRepeatMode repeat){
+  if (!names) return FALSE;
+  gchar **parts = g_strsplit(names, ",", -1);
+  guint n = g_strv_length(parts);
+  int *idx = g_new0(int, MAX(n, 1));
+  gboolean ok = n > 0;
+  for (guint i = 0; i < n && ok; ++i) {
+    idx[i] = splash_find_index_by_name(self->splash, g_strstrip(parts[i]));
+    ok = idx[i] >= 0;
+  }
+  if (ok) ok = splash_enqueue_with_repeat(self->splash, idx, (int)n, repeat);
+  if (!ok) GST_WARNING_OBJECT(self, "cannot enqueue '%s'", names);
+  g_free(idx);
+  g_strfreev(parts);
+  return ok;
+}
+
+static void gst_splash_src_clear(GstSplashSrc *self){
+  splash_clear_next(self->splash);
+}
+
+static GstStructure* stats_structure(GstSplashSrc *self){
+  SplashStats st;
+  splash_get_stats(self->splash, &st);
+  return gst_structure_new("splash-stats",
+    "frames-pushed",      G_TYPE_UINT64, st.frames_pushed,
+    "bytes-pushed",       G_TYPE_UINT64, st.bytes_pushed,
+    "cpu-us",             G_TYPE_INT64,  st.cpu_us,
+    "first-packet-us",    G_TYPE_INT64,  st.first_packet_us,
+    "index-frames",       G_TYPE_INT,    st.index_frames,
+    "index-from-sidecar", G_TYPE_BOOLEAN, (gboolean)st.index_from_sidecar,
+    "index-time-us",      G_TYPE_INT64,  st.index_time_us,
+    "decompress-us",      G_TYPE_INT64,  st.decompress_us,
+    "cache-hits",         G_TYPE_UINT64, st.cache_hits,
+    "cache-misses",       G_TYPE_UINT64, st.cache_misses,
+    "cache-evictions",    G_TYPE_UINT64, st.cache_evictions,
+    "cache-bytes-used",   G_TYPE_UINT64, st.cache_bytes_used,
+    "ps-bytes-stripped",  G_TYPE_UINT64, st.ps_bytes_stripped,
+    "ps-bytes-injected",  G_TYPE_UINT64, st.ps_bytes_injected,
+    "ps-injections",      G_TYPE_UINT64, st.ps_injections,
+    NULL);
+}
+
+// ---- GObject ----
+static void gst_splash_src_set_property(GObject *obj, guint id, const GValue *v, GParamSpec *ps){
+  GstSplashSrc *self = GST_SPLASH_SRC(obj);
+  g_mutex_lock(&self->lock);
+  switch (id) {
+    case PROP_LOCATION:
+      g_free(self->location);
+      self->location = g_value_dup_string(v);
+      break;
+    case PROP_FPS:
+      self->fps = g_value_get_double(v);
+      break;
+    case PROP_SEQUENCES:
+      g_free(self->sequences);
+      self->sequences = g_value_dup_string(v);
+      if (!parse_sequences_locked(self, self->sequences)) {
+        GST_WARNING_OBJECT(self, "invalid sequences '%s'", self->sequences);
+      } else if (self->n_seqs > 0) {
+        splash_set_sequences(self->splash, self->seqs, self->n_seqs);
+      }
+      break;
+    case PROP_INDEX:
+      self->index_mode = (SplashIndexMode)g_value_get_enum(v);
+      break;
+    case PROP_INDEX_PATH:
+      g_free(self->index_path);
+      self->index_path = g_value_dup_string(v);
+      break;
+    case PROP_CACHE_BYTES:
+      self->cache_bytes = g_value_get_uint64(v);
+      break;
+    case PROP_CACHE_PIN:
+      self->cache_pin = g_value_get_int(v);
+      break;
+    case PROP_PS_INTERVAL:
+      self->ps_interval = g_value_get_int(v);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, ps);
+      break;
+  }
+  g_mutex_unlock(&self->lock);
+}
+
+static void gst_splash_src_get_property(GObject *obj, guint id, GValue *v, GParamSpec *ps){
+  GstSplashSrc *self = GST_SPLASH_SRC(obj);
+  if (id == PROP_STATS) {
+    g_value_take_boxed(v, stats_structure(self));
+    return;
+  }
+  int active = id == PROP_ACTIVE_SEQUENCE ? splash_active_index(self->splash) : -1;
+  g_mutex_lock(&self->lock);
+  switch (id) {
+    case PROP_LOCATION:    g_value_set_string(v, self->location); break;
+    case PROP_FPS:         g_value_set_double(v, self->fps); break;
+    case PROP_SEQUENCES:   g_value_set_string(v, self->sequences); break;
+    case PROP_INDEX:       g_value_set_enum(v, self->index_mode); break;
+    case PROP_INDEX_PATH:  g_value_set_string(v, self->index_path); break;
+    case PROP_CACHE_BYTES: g_value_set_uint64(v, self->cache_bytes); break;
+    case PROP_CACHE_PIN:   g_value_set_int(v, self->cache_pin); break;
+    case PROP_PS_INTERVAL: g_value_set_int(v, self->ps_interval); break;
+    case PROP_ACTIVE_SEQUENCE:
+      g_value_set_string(v, (active >= 0 && active < self->n_seqs) ? self->seq_names[active] : NULL);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, ps);
+      break;
+  }
+  g_mutex_unlock(&self->lock);
+}
+
+static void gst_splash_src_finalize(GObject *obj){
+  GstSplashSrc *self = GST_SPLASH_SRC(obj);
+  splash_free(self->splash);
+  clear_sequences(self);
+  g_free(self->location);
+  g_free(self->sequences);
+  g_free(self->index_path);
+  g_mutex_clear(&self->lock);
+  g_mutex_clear(&self->evt_lock);
+  G_OBJECT_CLASS(gst_splash_src_parent_class)->finalize(obj);
+}
+
+// ---- GstBaseSrc ----
+static GstCaps* gst_splash_src_get_caps(GstBaseSrc *bsrc, GstCaps *filter){
+  GstSplashSrc *self = GST_SPLASH_SRC(bsrc);
+  gint num, den;
+  g_mutex_lock(&self->lock);
+  gst_util_double_to_fraction(self->fps, &num, &den);
+  g_mutex_unlock(&self->lock);
+  GstCaps *caps = gst_caps_new_simple("video/x-h265",
+    "stream-format", G_TYPE_STRING, "byte-stream",
+    "alignment", G_TYPE_STRING, "au",
+    "framerate", GST_TYPE_FRACTION, num, den,
+    NULL);
+  if (filter) {
+    GstCaps *tmp = gst_caps_intersect_full(filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref(caps);
+    caps = tmp;
+  }
+  return caps;
+}
+
+static gboolean gst_splash_src_start(GstBaseSrc *bsrc){
+  GstSplashSrc *self = GST_SPLASH_SRC(bsrc);
+  g_mutex_lock(&self->lock);
+  if (!self->location || self->n_seqs == 0) {
+    g_mutex_unlock(&self->lock);
+    GST_ELEMENT_ERROR(self, RESOURCE, SETTINGS, (NULL),
+                      ("both 'location' and 'sequences' must be set"));
+    return FALSE;
+  }
+  SplashConfig cfg = {0};
+  cfg.input_path = self->location;
+  cfg.fps = self->fps;
+  cfg.outputs = SPLASH_OUTPUT_PULL;
+  cfg.index_mode = self->index_mode;
+  cfg.index_path = self->index_path;
+  cfg.cache_bytes = self->cache_bytes;
+  cfg.cache_pin_frames = self->cache_pin;
+  cfg.ps_interval_ms = self->ps_interval;
+  gboolean ok = splash_set_sequences(self->splash, self->seqs, self->n_seqs) &&
+                splash_apply_config(self->splash, &cfg);
+  g_mutex_unlock(&self->lock);
+  if (ok) ok = splash_start(self->splash);
+  if (!ok) {
+    GST_ELEMENT_ERROR(self, RESOURCE, OPEN_READ, (NULL),
+                      ("cannot open or index '%s'", self->location));
+  }
+  return ok;
+}
+
+static gboolean gst_splash_src_stop(GstBaseSrc *bsrc){
+  splash_stop(GST_SPLASH_SRC(bsrc)->splash);
+  return TRUE;
+}
+
+static GstFlowReturn gst_splash_src_create(GstPushSrc *psrc, GstBuffer **outbuf){
+  GstSplashSrc *self = GST_SPLASH_SRC(psrc);
+  *outbuf = splash_pull_frame(self->splash);
+  if (!*outbuf) {
+    GST_ELEMENT_ERROR(self, RESOURCE, READ, (NULL), ("failed to read frame from input"));
+    return GST_FLOW_ERROR;
+  }
+  post_pending_switch(self);
+  return GST_FLOW_OK;
+}
+
+static void gst_splash_src_class_init(GstSplashSrcClass *klass){
+  GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+  GstBaseSrcClass *basesrc_class = GST_BASE_SRC_CLASS(klass);
+  GstPushSrcClass *pushsrc_class = GST_PUSH_SRC_CLASS(klass);
+
+  gobject_class->set_property = gst_splash_src_set_property;
+  gobject_class->get_property = gst_splash_src_get_property;
+  gobject_class->finalize = gst_splash_src_finalize;
+
+  GParamFlags rw = G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS;
+  GParamFlags rw_ready = rw | GST_PARAM_MUTABLE_READY;
+  g_object_class_install_property(gobject_class, PROP_LOCATION,
+    g_param_spec_string("location", "Location",
+      "Annex-B H.265 elementary stream (optionally gzip/zip/zstd compressed), "
+      "or embedded: for the asset linked into the library",
+      NULL, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_FPS,
+    g_param_spec_double("fps", "Frame rate", "Frame rate of the input material",
+      1.0, 240.0, DEFAULT_FPS, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_SEQUENCES,
+    g_param_spec_string("sequences", "Sequences",
+      "Comma-separated name:start-end frame ranges; the first one loops at start",
+      NULL, rw | GST_PARAM_MUTABLE_PLAYING));
+  g_object_class_install_property(gobject_class, PROP_INDEX,
+    g_param_spec_enum("index", "Index", "Frame index sidecar handling",
+      GST_TYPE_SPLASH_SRC_INDEX, SPLASH_INDEX_AUTO, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_INDEX_PATH,
+    g_param_spec_string("index-path", "Index path",
+      "Sidecar location (NULL = <location>.idx)", NULL, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_CACHE_BYTES,
+    g_param_spec_uint64("cache-bytes", "Cache bytes",
+      "Bounded frame cache budget instead of mapping the input (0 = map)",
+      0, G_MAXUINT64, 0, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_CACHE_PIN,
+    g_param_spec_int("cache-pin", "Cache pin",
+      "Frames pinned at the start and end of every sequence (cache mode)",
+      0, G_MAXINT, DEFAULT_CACHE_PIN, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_PS_INTERVAL,
+    g_param_spec_int("ps-interval", "Parameter-set interval",
+      "Min ms between VPS/SPS/PPS resends on IRAPs (0 = every IRAP, -1 = only on start/switch/join)",
+      -1, G_MAXINT, DEFAULT_PS_INTERVAL, rw_ready));
+  g_object_class_install_property(gobject_class, PROP_ACTIVE_SEQUENCE,
+    g_param_spec_string("active-sequence", "Active sequence",
+      "Name of the sequence currently looping", NULL,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property(gobject_class, PROP_STATS,
+    g_param_spec_boxed("stats", "Statistics", "Loop engine counters",
+      GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  // gboolean enqueue(names, repeat): names is a comma-separated list taking
+  // over at the next sequence boundary, in order.
+  signals[SIGNAL_ENQUEUE] = g_signal_new_class_handler("enqueue",
+    G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+    G_CALLBACK(gst_splash_src_enqueue), NULL, NULL, NULL,
+    G_TYPE_BOOLEAN, 2, G_TYPE_STRING, GST_TYPE_SPLASH_SRC_REPEAT);
+  signals[SIGNAL_CLEAR] = g_signal_new_class_handler("clear",
+    G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+    G_CALLBACK(gst_splash_src_clear), NULL, NULL, NULL,
+    G_TYPE_NONE, 0);
+
+  gst_element_class_add_static_pad_template(element_class, &src_template);
+  gst_element_class_set_static_metadata(element_class,
+    "Splash loop source", "Source/Video",
+    "Loops and switches named H.265 frame ranges at sequence boundaries",
+    "splashscreen");
+
+  basesrc_class->get_caps = gst_splash_src_get_caps;
+  basesrc_class->start = gst_splash_src_start;
+  basesrc_class->stop = gst_splash_src_stop;
+  pushsrc_class->create = gst_splash_src_create;
+}
+
+static void gst_splash_src_init(GstSplashSrc *self){
+  g_mutex_init(&self->lock);
+  g_mutex_init(&self->evt_lock);
+  self->switch_from = self->switch_to = -1;
+  self->splash = splash_new();
+  splash_set_event_cb(self->splash, on_splash_event, self);
+  self->fps = DEFAULT_FPS;
+  self->index_mode = SPLASH_INDEX_AUTO;
+  self->cache_pin = DEFAULT_CACHE_PIN;
+  self->ps_interval = DEFAULT_PS_INTERVAL;
+  gst_base_src_set_format(GST_BASE_SRC(self), GST_FORMAT_TIME);
+}
+
+static gboolean plugin_init(GstPlugin *plugin){
+  GST_DEBUG_CATEGORY_INIT(gst_splash_src_debug, "splashsrc", 0, "Splash loop source");
+  return gst_element_register(plugin, "splashsrc", GST_RANK_NONE, GST_TYPE_SPLASH_SRC);
+}
+
+#ifndef PACKAGE
+#define PACKAGE "splashscreen"
+#endif
+#ifndef VERSION
+#define VERSION "1.0"
+#endif
+
+GST_PLUGIN_DEFINE(GST_VERSION_MAJOR, GST_VERSION_MINOR, splashsrc,
+                  "Splash screen loop engine", plugin_init, VERSION,
+                  "unknown", PACKAGE, "splashscreen")
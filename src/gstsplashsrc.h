@@ -0,0 +1,43 @@
+#ifndef GST_SPLASH_SRC_H
+#define GST_SPLASH_SRC_H
+
+#include <gst/gst.h>
+#include <gst/base/gstpushsrc.h>
+#include "splashlib.h"
+
+G_BEGIN_DECLS
+
+// splashsrc: the splash loop/queue engine as a GStreamer source element.
+// Pushes timestamped H.265 access units straight from the frame index, so no
+// appsink/appsrc bridge or second pipeline is involved.
+//
+//   gst-launch-1.0 splashsrc location=spinner.h265 sequences="intro:0-59,loop:60-119" !
+//     rtph265pay config-interval=0 ! udpsink host=127.0.0.1 port=5600
+
+#define GST_TYPE_SPLASH_SRC (gst_splash_src_get_type())
+G_DECLARE_FINAL_TYPE(GstSplashSrc, gst_splash_src, GST, SPLASH_SRC, GstPushSrc)
+
+struct _GstSplashSrc {
+  GstPushSrc parent;
+
+  Splash *splash;
+  GMutex evt_lock;      // leaf lock for the pending switch (event dispatcher vs create)
+  int switch_from, switch_to;
+  GMutex lock;          // guards the properties below; taken before the engine lock
+
+  gchar *location;
+  gdouble fps;
+  gchar *sequences;     // "name:start-end,..."
+  SplashSeq *seqs;
+  gchar **seq_names;
+  gint n_seqs;
+  SplashIndexMode index_mode;
+  gchar *index_path;
+  guint64 cache_bytes;
+  gint cache_pin;
+  gint ps_interval;
+};
+
+G_END_DECLS
+
+#endif
@@ -1,3 +1,5 @@
+#include "splashconf.h"
+#include "splashfec.h"
 #include "splashlib.h"
 #include <errno.h>
 #include <fcntl.h>
@@ -7,23 +9,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
-typedef struct {
-  const char *name;
-  int *indices;
-  int count;
-  gboolean loop_at_end;
-} ComboSeq;
-
-static void free_combos(ComboSeq *combos, int count) {
-  if (!combos) return;
-  for (int i = 0; i < count; ++i) {
-    g_free(combos[i].indices);
-  }
-  g_free(combos);
-}
-
 typedef struct {
   Splash *splash;
   SplashSeq *sequences;
@@ -33,6 +21,24 @@ typedef struct {
   gboolean started;
   gboolean combo_loop_full;
   GMainLoop *loop;
+  double fps;
+  const char *config_path;
+  GPtrArray *owned_strings;
+  // Precomputed at config load, rebuilt on reload
+  gchar **seq_json;             // each sequence name as a JSON string literal
+  GString *list_response;       // complete /request/list reply
+  gint64 boot_us;
+  // HTTP handling cost (main loop thread CPU time per request)
+  guint64 http_requests;
+  gint64 http_cpu_us;
+  gint64 http_cpu_max_us;
+  // Startup phases (monotonic end times), reported with the first packet
+  gint64 t_main;
+  gint64 t_config;
+  gint64 t_init;
+  gint64 t_apply;
+  gboolean fast_init;
+  gint startup_reported;        // atomic
 } AppCtx;
 
 static gboolean set_stdin_nonblock(void) {
@@ -66,36 +72,72 @@ static gchar *json_escape(const char *in) {
   return g_string_free(out, FALSE);
 }
 
-static gboolean parse_stream_outputs(const char *value, SplashOutputMode *mode_out) {
-  if (!mode_out) return FALSE;
-  SplashOutputMode mode = SPLASH_OUTPUT_NONE;
-  if (!value || !*value) {
-    *mode_out = SPLASH_OUTPUT_UDP;
+// Parses a schedule time: "+SECONDS" from now, Unix time "SECONDS[.frac]", or
+// local wall-clock time "HH:MM[:SS[.frac]]" (the next occurrence).
+static gboolean parse_when(const char *value, gint64 *when_ns, SplashClockId *clock) {
+  if (!value || !*value) return FALSE;
+  gchar *end = NULL;
+  if (value[0] == '+') {
+    double secs = g_ascii_strtod(value + 1, &end);
+    if (end == value + 1 || *end != '\0' || secs < 0) return FALSE;
+    *when_ns = g_get_monotonic_time() * 1000 + (gint64)(secs * 1e9);
+    *clock = SPLASH_CLOCK_MONOTONIC;
     return TRUE;
   }
-  gchar **tokens = g_strsplit(value, ",", -1);
-  if (!tokens) {
-    *mode_out = SPLASH_OUTPUT_UDP;
+  if (!strchr(value, ':')) {
+    double secs = g_ascii_strtod(value, &end);
+    if (end == value || *end != '\0' || secs < 0) return FALSE;
+    *when_ns = (gint64)(secs * 1e9);
+    *clock = SPLASH_CLOCK_REALTIME;
     return TRUE;
   }
-  for (gint i = 0; tokens[i]; ++i) {
-    gchar *trimmed = g_strstrip(tokens[i]);
-    if (!trimmed || *trimmed == '\0') continue;
-    if (g_ascii_strcasecmp(trimmed, "udp") == 0) {
-      mode |= SPLASH_OUTPUT_UDP;
-    } else if (g_ascii_strcasecmp(trimmed, "appsrc") == 0) {
-      mode |= SPLASH_OUTPUT_APPSRC;
-    } else if (g_ascii_strcasecmp(trimmed, "both") == 0) {
-      mode |= (SplashOutputMode)(SPLASH_OUTPUT_UDP | SPLASH_OUTPUT_APPSRC);
-    } else {
-      g_strfreev(tokens);
-      return FALSE;
-    }
+  guint hh = 0, mm = 0;
+  double ss = 0;
+  int used = 0;
+  if (sscanf(value, "%u:%u%n", &hh, &mm, &used) != 2) return FALSE;
+  if (value[used] == ':') {
+    const char *sec = value + used + 1;
+    ss = g_ascii_strtod(sec, &end);
+    if (end == sec || *end != '\0') return FALSE;
+  } else if (value[used] != '\0') {
+    return FALSE;
   }
-  g_strfreev(tokens);
-  if (mode == SPLASH_OUTPUT_NONE) mode = SPLASH_OUTPUT_UDP;
-  *mode_out = mode;
-  return TRUE;
+  if (hh > 23 || mm > 59 || ss < 0 || ss >= 60) return FALSE;
+  GDateTime *now = g_date_time_new_now_local();
+  GDateTime *at = g_date_time_new_local(g_date_time_get_year(now),
+                                        g_date_time_get_month(now),
+                                        g_date_time_get_day_of_month(now),
+                                        (gint)hh, (gint)mm, ss);
+  if (at && g_date_time_compare(at, now) < 0) {
+    GDateTime *next = g_date_time_add_days(at, 1);
+    g_date_time_unref(at);
+    at = next;
+  }
+  gboolean ok = at != NULL;
+  if (ok) {
+    *when_ns = g_date_time_to_unix(at) * G_GINT64_CONSTANT(1000000000) +
+               (gint64)g_date_time_get_microsecond(at) * 1000;
+    *clock = SPLASH_CLOCK_REALTIME;
+    g_date_time_unref(at);
+  }
+  g_date_time_unref(now);
+  return ok;
+}
+
+// Schedules a switch to sequence `name` at `when` (see parse_when). Returns
+// the schedule id, 0 with *not_found set for unknown names, 0 for bad times.
+static guint schedule_by_name(AppCtx *ctx, const char *name, const char *when,
+                              gboolean *not_found) {
+  *not_found = FALSE;
+  gint64 when_ns = 0;
+  SplashClockId clock = SPLASH_CLOCK_MONOTONIC;
+  int idx = splash_find_index_by_name(ctx->splash, name);
+  if (idx < 0) {
+    *not_found = TRUE;
+    return 0;
+  }
+  if (!parse_when(when, &when_ns, &clock)) return 0;
+  return splash_schedule_at(ctx->splash, idx, when_ns, clock);
 }
 
 static ComboSeq *find_combo_by_name(AppCtx *ctx, const char *name) {
@@ -108,20 +150,23 @@ static ComboSeq *find_combo_by_name(AppCtx *ctx, const char *name) {
   return NULL;
 }
 
-static gboolean send_http_response(GOutputStream *out,
-                                   int status,
-                                   const char *reason,
-                                   const char *content_type,
-                                   const char *body) {
+static GString *build_http_response(int status,
+                                    const char *reason,
+                                    const char *content_type,
+                                    const char *body) {
   if (!content_type) content_type = "text/plain";
   if (!body) body = "";
   gsize body_len = strlen(body);
-  GString *resp = g_string_new(NULL);
+  GString *resp = g_string_sized_new(body_len + 128);
   g_string_append_printf(resp, "HTTP/1.1 %d %s\r\n", status, reason);
   g_string_append_printf(resp, "Content-Type: %s\r\n", content_type);
   g_string_append_printf(resp, "Content-Length: %" G_GSIZE_FORMAT "\r\n", body_len);
   g_string_append(resp, "Connection: close\r\n\r\n");
   g_string_append_len(resp, body, body_len);
+  return resp;
+}
+
+static gboolean write_http_response(GOutputStream *out, const GString *resp) {
   gsize written = 0;
   GError *error = NULL;
   gboolean ok = g_output_stream_write_all(out, resp->str, resp->len,
@@ -130,10 +175,143 @@ static gboolean send_http_response(GOutputStream *out,
     fprintf(stderr, "HTTP response write failed: %s\n", error->message);
     g_error_free(error);
   }
+  return ok;
+}
+
+static gboolean send_http_response(GOutputStream *out,
+                                   int status,
+                                   const char *reason,
+                                   const char *content_type,
+                                   const char *body) {
+  GString *resp = build_http_response(status, reason, content_type, body);
+  gboolean ok = write_http_response(out, resp);
   g_string_free(resp, TRUE);
   return ok;
 }
 
+static const char *seq_name_json(AppCtx *ctx, int idx) {
+  if (!ctx->seq_json || idx < 0 || idx >= ctx->sequence_count) return "null";
+  return ctx->seq_json[idx];
+}
+
+static void free_http_cache(AppCtx *ctx) {
+  g_strfreev(ctx->seq_json);
+  ctx->seq_json = NULL;
+  if (ctx->list_response) g_string_free(ctx->list_response, TRUE);
+  ctx->list_response = NULL;
+}
+
+// Responses that only depend on the configuration are built once here
+// instead of per request.
+static void build_http_cache(AppCtx *ctx) {
+  free_http_cache(ctx);
+  ctx->seq_json = g_new0(gchar *, ctx->sequence_count + 1);
+  for (int i = 0; i < ctx->sequence_count; ++i) {
+    gchar *escaped = json_escape(ctx->sequences[i].name);
+    ctx->seq_json[i] = g_strdup_printf("\"%s\"", escaped);
+    g_free(escaped);
+  }
+
+  GString *body = g_string_new("{\"sequences\":[");
+  for (int i = 0; i < ctx->sequence_count; ++i) {
+    if (i > 0) g_string_append_c(body, ',');
+    g_string_append(body, ctx->seq_json[i]);
+  }
+  g_string_append(body, "],\"combos\":[");
+  for (int i = 0; i < ctx->combo_count; ++i) {
+    if (i > 0) g_string_append_c(body, ',');
+    gchar *escaped = json_escape(ctx->combos[i].name);
+    g_string_append_printf(body, "{\"name\":\"%s\",\"order\":[", escaped);
+    g_free(escaped);
+    for (int j = 0; j < ctx->combos[i].count; ++j) {
+      if (j > 0) g_string_append_c(body, ',');
+      int idx = ctx->combos[i].indices[j];
+      g_string_append(body, idx >= 0 && idx < ctx->sequence_count ? ctx->seq_json[idx] : "\"\"");
+    }
+    g_string_append_printf(body, "],\"loop_at_end\":%s}",
+                           ctx->combos[i].loop_at_end ? "true" : "false");
+  }
+  g_string_append(body, "]}");
+  ctx->list_response = build_http_response(200, "OK", "application/json", body->str);
+  g_string_free(body, TRUE);
+}
+
+// Re-reads the configuration file and applies it, restarting playout if it
+// was running. The HTTP port is not rebound. On failure *why names the step.
+static gboolean reload_config(AppCtx *ctx, const char **why) {
+  SplashSeq *seqs = NULL;
+  int n_seqs = 0;
+  ComboSeq *combos = NULL;
+  int n_combos = 0;
+  GPtrArray *owned_strings = NULL;
+  SplashConfig cfg = {0};
+  gboolean combo_loop_full = FALSE;
+  if (!splash_conf_load(ctx->config_path, &cfg, &seqs, &n_seqs, &combos, &n_combos,
+                        &owned_strings, &combo_loop_full, NULL)) {
+    *why = "invalid_config";
+    return FALSE;
+  }
+  // Checked before anything is swapped, so a bad file leaves playout alone
+  if (!splash_check_config(&cfg)) {
+    g_free(seqs);
+    splash_conf_free_combos(combos, n_combos);
+    g_ptr_array_free(owned_strings, TRUE);
+    *why = "invalid_config";
+    return FALSE;
+  }
+  if (!splash_set_sequences(ctx->splash, seqs, n_seqs)) {
+    g_free(seqs);
+    splash_conf_free_combos(combos, n_combos);
+    g_ptr_array_free(owned_strings, TRUE);
+    *why = "invalid_sequences";
+    return FALSE;
+  }
+  // The library has the new sequences now; the old definitions go.
+  g_free(ctx->sequences);
+  splash_conf_free_combos(ctx->combos, ctx->combo_count);
+  g_ptr_array_free(ctx->owned_strings, TRUE);
+  ctx->sequences = seqs;
+  ctx->sequence_count = n_seqs;
+  ctx->combos = combos;
+  ctx->combo_count = n_combos;
+  ctx->owned_strings = owned_strings;
+  ctx->combo_loop_full = combo_loop_full;
+  ctx->fps = cfg.fps;
+  build_http_cache(ctx);
+
+  if (!splash_apply_config(ctx->splash, &cfg)) {
+    // The library is left stopped
+    ctx->started = FALSE;
+    *why = "apply_failed";
+    return FALSE;
+  }
+  if (ctx->started && !splash_start(ctx->splash)) {
+    ctx->started = FALSE;
+    *why = "restart_failed";
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gint64 thread_cpu_us(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+  return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static gchar *output_counters_json(const char *name, const SplashOutputCounters *c) {
+  return g_strdup_printf(
+    "\"%s\":{\"pushed\":%" G_GUINT64_FORMAT ",\"dropped\":%" G_GUINT64_FORMAT ","
+    "\"stall_us\":%" G_GINT64_FORMAT ",\"stall_max_us\":%" G_GINT64_FORMAT ","
+    "\"queue_depth\":%u,\"lag_us\":%" G_GINT64_FORMAT ",\"lag_max_us\":%" G_GINT64_FORMAT ","
+    "\"held\":%" G_GUINT64_FORMAT ",\"shed\":%" G_GUINT64_FORMAT ","
+    "\"decimated\":%" G_GUINT64_FORMAT ","
+    "\"bytes\":%" G_GUINT64_FORMAT ",\"bitrate_bps\":%" G_GUINT64_FORMAT "}",
+    name, c->frames_pushed, c->frames_dropped, c->stall_us, c->stall_max_us,
+    c->queue_depth, c->lag_us, c->lag_max_us,
+    c->frames_held, c->frames_shed, c->frames_decimated, c->bytes_pushed, c->bitrate_bps);
+}
+
 static gboolean handle_http_path(AppCtx *ctx,
                                  const char *path,
                                  GOutputStream *out) {
@@ -167,47 +345,188 @@ static gboolean handle_http_path(AppCtx *ctx,
                               "{\"status\":\"stopped\"}");
   }
 
+  if (!g_strcmp0(path, "/request/pause")) {
+    if (!splash_pause(ctx->splash)) {
+      return send_http_response(out, 409, "Conflict",
+                                "application/json",
+                                "{\"status\":\"not_running\"}");
+    }
+    return send_http_response(out, 200, "OK",
+                              "application/json",
+                              "{\"status\":\"paused\"}");
+  }
+
+  if (!g_strcmp0(path, "/request/resume") || !g_strcmp0(path, "/request/resume/restart")) {
+    gboolean restart = !g_strcmp0(path, "/request/resume/restart");
+    if (!splash_resume(ctx->splash, restart)) {
+      return send_http_response(out, 409, "Conflict",
+                                "application/json",
+                                "{\"status\":\"not_paused\"}");
+    }
+    return send_http_response(out, 200, "OK",
+                              "application/json",
+                              "{\"status\":\"resumed\"}");
+  }
+
+  if (!g_strcmp0(path, "/request/stats")) {
+    SplashStats st;
+    splash_get_stats(ctx->splash, &st);
+    // Per-frame CPU and bitrate over media time, for comparing reader modes
+    double cpu_per_frame = st.frames_pushed ? (double)st.cpu_us / st.frames_pushed : 0.0;
+    double bitrate = st.frames_pushed ? st.bytes_pushed * 8.0 * ctx->fps / st.frames_pushed : 0.0;
+    double packets_per_frame = st.frames_pushed ? (double)st.rtp_packets / st.frames_pushed : 0.0;
+    // Retransmissions per media packet sent
+    double rtx_rate = st.rtp_packets ? (double)st.rtx.sent / st.rtp_packets : 0.0;
+    // FEC bytes per media byte, and media bytes encoded per microsecond of GF math
+    double fec_overhead = st.fec.source_bytes ? (double)st.fec.repair_bytes / st.fec.source_bytes : 0.0;
+    double fec_mbps = st.fec.encode_us ? (double)st.fec.source_bytes / st.fec.encode_us : 0.0;
+    gchar *udp = output_counters_json("udp", &st.udp);
+    gchar *appsrc = output_counters_json("appsrc", &st.appsrc);
+    gchar *body = g_strdup_printf(
+      "{\"frames_pushed\":%" G_GUINT64_FORMAT ","
+      "\"bytes_pushed\":%" G_GUINT64_FORMAT ","
+      "\"bitrate_bps\":%.0f,"
+      "\"cpu_us\":%" G_GINT64_FORMAT ","
+      "\"cpu_us_per_frame\":%.1f,"
+      "\"first_packet_us\":%" G_GINT64_FORMAT ","
+      "\"gst_init_us\":%" G_GINT64_FORMAT ","
+      "\"rtp\":{\"mtu\":%u,\"packets\":%" G_GUINT64_FORMAT ",\"packets_per_frame\":%.2f},"
+      "\"rtx\":{\"nacks\":%" G_GUINT64_FORMAT ",\"requested\":%" G_GUINT64_FORMAT ","
+      "\"sent\":%" G_GUINT64_FORMAT ",\"missed\":%" G_GUINT64_FORMAT ",\"rate\":%.4f,"
+      "\"repair_us\":%" G_GINT64_FORMAT ",\"repair_max_us\":%" G_GINT64_FORMAT "},"
+      "\"fec\":{\"blocks\":%" G_GUINT64_FORMAT ",\"source_packets\":%" G_GUINT64_FORMAT ","
+      "\"repair_packets\":%" G_GUINT64_FORMAT ",\"overhead\":%.4f,"
+      "\"encode_us\":%" G_GINT64_FORMAT ",\"encode_mb_per_s\":%.1f,\"impl\":\"%s\"},"
+      "\"resume_latency_us\":%" G_GINT64_FORMAT ",\"resume_latency_max_us\":%" G_GINT64_FORMAT ","
+      "\"index\":{\"frames\":%d,\"from_sidecar\":%s,\"saved\":%s,"
+      "\"time_us\":%" G_GINT64_FORMAT ",\"decompress_us\":%" G_GINT64_FORMAT ","
+      "\"decompress_threads\":%u,\"scan_threads\":%u},"
+      "\"cache\":{\"hits\":%" G_GUINT64_FORMAT ",\"misses\":%" G_GUINT64_FORMAT ","
+      "\"evictions\":%" G_GUINT64_FORMAT ",\"bytes_used\":%" G_GUINT64_FORMAT ","
+      "\"bytes_pinned\":%" G_GUINT64_FORMAT ",\"frames_pinned\":%u},"
+      "\"param_sets\":{\"groups\":%u,\"bytes_stripped\":%" G_GUINT64_FORMAT ","
+      "\"bytes_injected\":%" G_GUINT64_FORMAT ",\"injections\":%" G_GUINT64_FORMAT "},"
+      "\"outputs\":{%s,%s},"
+      "\"sched\":{\"threads\":%u,\"failures\":%u},"
+      "\"schedules\":{\"pending\":%u,\"switches\":%" G_GUINT64_FORMAT ","
+      "\"error_us\":%" G_GINT64_FORMAT ",\"error_max_us\":%" G_GINT64_FORMAT "},"
+      "\"watchdog\":{\"stalls\":%u,\"recoveries\":%u,"
+      "\"recovery_us\":%" G_GINT64_FORMAT ",\"recovery_max_us\":%" G_GINT64_FORMAT "},"
+      "\"events_dropped\":%u,"
+      "\"http\":{\"requests\":%" G_GUINT64_FORMAT ",\"cpu_us\":%" G_GINT64_FORMAT ","
+      "\"cpu_us_per_request\":%.1f,\"cpu_us_max\":%" G_GINT64_FORMAT "}}",
+      st.frames_pushed, st.bytes_pushed, bitrate, st.cpu_us, cpu_per_frame,
+      st.first_packet_us, st.gst_init_us, st.rtp_mtu, st.rtp_packets, packets_per_frame,
+      st.rtx.nacks, st.rtx.requested, st.rtx.sent, st.rtx.missed, rtx_rate,
+      st.rtx.repair_us, st.rtx.repair_max_us,
+      st.fec.blocks, st.fec.source_packets, st.fec.repair_packets, fec_overhead,
+      st.fec.encode_us, fec_mbps, splash_fec_impl_name(splash_fec_get_impl()),
+      st.resume_latency_us, st.resume_latency_max_us,
+      st.index_frames, st.index_from_sidecar ? "true" : "false",
+      st.index_saved ? "true" : "false", st.index_time_us,
+      st.decompress_us, st.decompress_threads, st.index_threads,
+      st.cache_hits, st.cache_misses, st.cache_evictions,
+      st.cache_bytes_used, st.cache_bytes_pinned, st.cache_frames_pinned,
+      st.ps_groups, st.ps_bytes_stripped, st.ps_bytes_injected, st.ps_injections,
+      udp, appsrc, st.sched_threads, st.sched_failures,
+      st.sched_pending, st.sched_switches, st.sched_error_us, st.sched_error_max_us,
+      st.watchdog_stalls, st.watchdog_recoveries, st.recovery_us, st.recovery_max_us,
+      st.events_dropped, ctx->http_requests, ctx->http_cpu_us,
+      ctx->http_requests ? (double)ctx->http_cpu_us / ctx->http_requests : 0.0,
+      ctx->http_cpu_max_us);
+    g_free(udp);
+    g_free(appsrc);
+    gboolean ok = send_http_response(out, 200, "OK", "application/json", body);
+    g_free(body);
+    return ok;
+  }
+
   if (!g_strcmp0(path, "/request/list")) {
-    GString *body = g_string_new("{\"sequences\":[");
-    for (int i = 0; i < ctx->sequence_count; ++i) {
-      if (i > 0) g_string_append(body, ",");
-      gchar *escaped = json_escape(ctx->sequences[i].name);
-      g_string_append(body, "\"");
-      g_string_append(body, escaped);
-      g_string_append(body, "\"");
-      g_free(escaped);
+    return write_http_response(out, ctx->list_response);
+  }
+
+  if (!g_strcmp0(path, "/request/status")) {
+    SplashStatus st = {0};
+    splash_get_status(ctx->splash, &st);
+    gchar *body = g_strdup_printf(
+      "{\"state\":\"%s\",\"active\":%s,\"pending\":%s,\"queue_depth\":%d,"
+      "\"uptime_s\":%.3f,\"running_s\":%.3f,\"frames_pushed\":%" G_GUINT64_FORMAT "}",
+      !st.running ? "stopped" : st.paused ? "paused" : "running",
+      seq_name_json(ctx, st.active_idx), seq_name_json(ctx, st.pending_idx),
+      st.queue_depth, (g_get_monotonic_time() - ctx->boot_us) / 1e6,
+      st.running_us / 1e6, st.frames_pushed);
+    gboolean ok = send_http_response(out, 200, "OK", "application/json", body);
+    g_free(body);
+    return ok;
+  }
+
+  if (!g_strcmp0(path, "/request/reload")) {
+    const char *why = NULL;
+    if (!reload_config(ctx, &why)) {
+      gchar *body = g_strdup_printf("{\"status\":\"error\",\"message\":\"%s\"}", why);
+      gboolean ok = send_http_response(out, 500, "Internal Server Error",
+                                       "application/json", body);
+      g_free(body);
+      return ok;
     }
-    g_string_append(body, "],\"combos\":[");
-    for (int i = 0; i < ctx->combo_count; ++i) {
-      if (i > 0) g_string_append(body, ",");
-      gchar *escaped = json_escape(ctx->combos[i].name);
-      g_string_append(body, "{\"name\":\"");
-      g_string_append(body, escaped);
-      g_string_append(body, "\",\"order\":[");
+    return send_http_response(out, 200, "OK",
+                              "application/json",
+                              "{\"status\":\"reloaded\"}");
+  }
+
+  if (!g_strcmp0(path, "/request/schedule/clear")) {
+    splash_schedule_clear(ctx->splash);
+    return send_http_response(out, 200, "OK",
+                              "application/json",
+                              "{\"status\":\"cleared\"}");
+  }
+
+  const char *cancel_prefix = "/request/schedule/cancel/";
+  if (g_str_has_prefix(path, cancel_prefix)) {
+    const char *num = path + strlen(cancel_prefix);
+    gchar *endptr = NULL;
+    guint64 id = g_ascii_strtoull(num, &endptr, 10);
+    if (!num[0] || *endptr || id == 0 || id > G_MAXUINT ||
+        !splash_schedule_cancel(ctx->splash, (guint)id)) {
+      return send_http_response(out, 404, "Not Found",
+                                "application/json",
+                                "{\"status\":\"not_found\"}");
+    }
+    return send_http_response(out, 200, "OK",
+                              "application/json",
+                              "{\"status\":\"cancelled\"}");
+  }
+
+  const char *schedule_prefix = "/request/schedule/";
+  if (g_str_has_prefix(path, schedule_prefix)) {
+    gchar **parts = g_strsplit(path + strlen(schedule_prefix), "/", 2);
+    gchar *name = parts[0] ? g_uri_unescape_string(parts[0], NULL) : NULL;
+    gchar *when = parts[0] && parts[1] ? g_uri_unescape_string(parts[1], NULL) : NULL;
+    g_strfreev(parts);
+    gboolean ok = FALSE;
+    gboolean not_found = FALSE;
+    guint id = 0;
+    if (name && name[0] && when) id = schedule_by_name(ctx, name, when, &not_found);
+    if (id > 0) {
+      gchar *escaped = json_escape(name);
+      gchar *body = g_strdup_printf("{\"status\":\"scheduled\",\"name\":\"%s\",\"id\":%u}",
+                                    escaped, id);
+      ok = send_http_response(out, 200, "OK", "application/json", body);
+      g_free(body);
       g_free(escaped);
-      for (int j = 0; j < ctx->combos[i].count; ++j) {
-        if (j > 0) g_string_append(body, ",");
-        const char *part_name = NULL;
-        int idx = ctx->combos[i].indices[j];
-        if (idx >= 0 && idx < ctx->sequence_count) {
-          part_name = ctx->sequences[idx].name;
-        }
-        gchar *part_escaped = json_escape(part_name ? part_name : "");
-        g_string_append(body, "\"");
-        g_string_append(body, part_escaped);
-        g_string_append(body, "\"");
-        g_free(part_escaped);
-      }
-      g_string_append(body, "]");
-      g_string_append(body, ",\"loop_at_end\":");
-      g_string_append(body, ctx->combos[i].loop_at_end ? "true" : "false");
-      g_string_append(body, "}");
+    } else if (not_found) {
+      gchar *escaped = json_escape(name);
+      gchar *body = g_strdup_printf("{\"status\":\"not_found\",\"name\":\"%s\"}", escaped);
+      ok = send_http_response(out, 404, "Not Found", "application/json", body);
+      g_free(body);
+      g_free(escaped);
+    } else {
+      ok = send_http_response(out, 400, "Bad Request",
+                              "application/json",
+                              "{\"status\":\"invalid_schedule\"}");
     }
-    g_string_append(body, "]}");
-    gboolean ok = send_http_response(out, 200, "OK",
-                                     "application/json",
-                                     body->str);
-    g_string_free(body, TRUE);
+    g_free(name);
+    g_free(when);
     return ok;
   }
 
@@ -288,13 +607,7 @@ static gboolean handle_http_path(AppCtx *ctx,
                             "{\"status\":\"unknown_request\"}");
 }
 
-static gboolean on_http_client(GSocketService *service,
-                               GSocketConnection *connection,
-                               GObject *source_object,
-                               gpointer user_data) {
-  (void)service;
-  (void)source_object;
-  AppCtx *ctx = (AppCtx *)user_data;
+static void serve_http_client(AppCtx *ctx, GSocketConnection *connection) {
   GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
   GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
   char buffer[2048];
@@ -306,7 +619,7 @@ static gboolean on_http_client(GSocketService *service,
       g_error_free(error);
     }
     g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-    return TRUE;
+    return;
   }
   buffer[n] = '\0';
 
@@ -317,7 +630,7 @@ static gboolean on_http_client(GSocketService *service,
                        "application/json",
                        "{\"status\":\"bad_request\"}");
     g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-    return TRUE;
+    return;
   }
 
   if (g_strcmp0(method, "GET") != 0) {
@@ -325,7 +638,7 @@ static gboolean on_http_client(GSocketService *service,
                        "application/json",
                        "{\"status\":\"method_not_allowed\"}");
     g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
-    return TRUE;
+    return;
   }
 
   char *query = strchr(path, '?');
@@ -333,6 +646,23 @@ static gboolean on_http_client(GSocketService *service,
 
   handle_http_path(ctx, path, out);
   g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+}
+
+// Every request is timed in thread CPU time (parsing, handling and writing
+// the reply), so the cost of each route can be checked under load.
+static gboolean on_http_client(GSocketService *service,
+                               GSocketConnection *connection,
+                               GObject *source_object,
+                               gpointer user_data) {
+  (void)service;
+  (void)source_object;
+  AppCtx *ctx = (AppCtx *)user_data;
+  gint64 cpu0 = thread_cpu_us();
+  serve_http_client(ctx, connection);
+  gint64 cpu = thread_cpu_us() - cpu0;
+  ctx->http_requests++;
+  ctx->http_cpu_us += cpu;
+  if (cpu > ctx->http_cpu_max_us) ctx->http_cpu_max_us = cpu;
   return TRUE;
 }
 
@@ -358,6 +688,10 @@ static gboolean on_stdin_ready(GIOChannel *source, GIOCondition condition, gpoin
       if (!ctx->started && splash_start(ctx->splash)) {
         ctx->started = TRUE;
       }
+    } else if (ch == 'p') {
+      splash_pause(ctx->splash);
+    } else if (ch == 'r') {
+      splash_resume(ctx->splash, FALSE);
     } else if (ch == 'x') {
       if (ctx->started) {
         splash_stop(ctx->splash);
@@ -376,39 +710,228 @@ static gboolean on_stdin_ready(GIOChannel *source, GIOCondition condition, gpoin
   return G_SOURCE_CONTINUE;
 }
 
+static const char* stall_source_name(int which){
+  switch (which) {
+    case SPLASH_STALL_READER: return "reader";
+    case SPLASH_STALL_UDP:    return "udp sender";
+    case SPLASH_STALL_APPSRC: return "appsrc output";
+    default:                  return "?";
+  }
+}
+
+static gint64 boottime_us(void){
+  struct timespec ts;
+  if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0) return -1;
+  return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+// Boot-to-first-packet breakdown, once per process. first_us is the
+// library's splash_start() -> first frame pushed (t_apply is set before
+// splash_start(), so it is always in place when the event arrives).
+static void report_startup(AppCtx *ctx, gint64 first_us){
+  if (!ctx || !ctx->t_apply || !g_atomic_int_compare_and_exchange(&ctx->startup_reported, 0, 1)) {
+    return;
+  }
+  SplashStats st;
+  splash_get_stats(ctx->splash, &st);
+  gint64 now = g_get_monotonic_time();
+  gint64 boot = boottime_us();
+  fprintf(stderr,
+          "Startup: config %.1f ms, init %.1f ms (gst_init %.1f ms, %s), "
+          "apply %.1f ms (decompress %.1f, index %.1f), start -> first packet %.1f ms\n",
+          (ctx->t_config - ctx->t_main) / 1000.0,
+          (ctx->t_init - ctx->t_config) / 1000.0, st.gst_init_us / 1000.0,
+          ctx->fast_init ? "fast" : "default",
+          (ctx->t_apply - ctx->t_init) / 1000.0, st.decompress_us / 1000.0,
+          st.index_time_us / 1000.0, first_us / 1000.0);
+  if (boot >= 0) {
+    fprintf(stderr, "Startup: main -> first packet %.1f ms, boot -> first packet %.3f s\n",
+            (now - ctx->t_main) / 1000.0, boot / 1e6);
+  } else {
+    fprintf(stderr, "Startup: main -> first packet %.1f ms\n", (now - ctx->t_main) / 1000.0);
+  }
+}
+
+// Runs on the library's event dispatcher thread.
 static void on_evt(SplashEventType type, int a, int b, const char *msg, void *user){
   AppCtx *ctx = (AppCtx*)user;
   switch(type){
     case SPLASH_EVT_STARTED:
-      if (ctx) ctx->started = TRUE;
       fprintf(stderr, "[evt] started\n");
       break;
     case SPLASH_EVT_STOPPED:
-      if (ctx) ctx->started = FALSE;
       fprintf(stderr, "[evt] stopped\n");
       break;
     case SPLASH_EVT_SWITCHED_AT_BOUNDARY:
       fprintf(stderr, "[evt] switched at boundary: %d -> %d\n", a, b); break;
     case SPLASH_EVT_QUEUED_NEXT:
-      fprintf(stderr, "[evt] queued next idx=%d\n", a); break;
+      if (b > 1) fprintf(stderr, "[evt] queued next idx=%d (+%d more)\n", a, b - 1);
+      else fprintf(stderr, "[evt] queued next idx=%d\n", a);
+      break;
     case SPLASH_EVT_CLEARED_QUEUE:
       fprintf(stderr, "[evt] cleared next\n"); break;
     case SPLASH_EVT_ERROR:
       fprintf(stderr, "[evt] ERROR: %s\n", msg?msg:"?"); break;
+    case SPLASH_EVT_FIRST_PACKET:
+      fprintf(stderr, "[evt] first packet after %.3f ms\n", a / 1000.0);
+      report_startup(ctx, a);
+      break;
+    case SPLASH_EVT_PAUSED:
+      fprintf(stderr, "[evt] paused\n"); break;
+    case SPLASH_EVT_RESUMED:
+      fprintf(stderr, "[evt] resumed%s\n", a ? " (sequence restarted)" : ""); break;
+    case SPLASH_EVT_SCHEDULED_SWITCH:
+      fprintf(stderr, "[evt] scheduled switch: %d -> %d\n", a, b); break;
+    case SPLASH_EVT_STALLED:
+      fprintf(stderr, "[evt] watchdog: %s stalled\n", stall_source_name(a)); break;
+    case SPLASH_EVT_RECOVERED:
+      fprintf(stderr, "[evt] watchdog: %s recovered after %d ms\n", stall_source_name(a), b);
+      break;
+  }
+}
+
+// --render-at=FRAME:NAME|clear. NAME is a sequence or combo, enqueued like
+// /request/enqueue/<name>. Sequence indices are stored in *idx_store.
+static gboolean parse_render_step(AppCtx *ctx, const char *spec, SplashRenderStep *step,
+                                  int *idx_store) {
+  const char *colon = strchr(spec, ':');
+  if (!colon || colon == spec || !colon[1]) return FALSE;
+  gchar *endptr = NULL;
+  guint64 frame = g_ascii_strtoull(spec, &endptr, 10);
+  if (endptr != colon) return FALSE;
+  const char *name = colon + 1;
+  memset(step, 0, sizeof(*step));
+  step->frame = frame;
+  if (!strcmp(name, "clear")) {
+    step->op = SPLASH_RENDER_CLEAR;
+    return TRUE;
   }
+  step->op = SPLASH_RENDER_ENQUEUE;
+  int idx = splash_find_index_by_name(ctx->splash, name);
+  if (idx >= 0) {
+    *idx_store = idx;
+    step->indices = idx_store;
+    step->n_indices = 1;
+    step->repeat = SPLASH_REPEAT_NONE;
+    return TRUE;
+  }
+  ComboSeq *combo = find_combo_by_name(ctx, name);
+  if (!combo || combo->count <= 0) return FALSE;
+  step->indices = combo->indices;
+  step->n_indices = combo->count;
+  step->repeat = SPLASH_REPEAT_NONE;
+  if (combo->loop_at_end) {
+    step->repeat = ctx->combo_loop_full ? SPLASH_REPEAT_FULL : SPLASH_REPEAT_LAST;
+  }
+  return TRUE;
 }
 
-#define SEQ_GROUP_PREFIX "sequence"
+// Offline render: runs the --render-at script unpaced and writes the result.
+static int run_render(AppCtx *ctx, const char *path, const char *format, guint64 frames,
+                      GPtrArray *specs) {
+  SplashRenderFormat fmt = g_str_has_suffix(path, ".pcap") ? SPLASH_RENDER_RTP_PCAP
+                                                          : SPLASH_RENDER_ANNEXB;
+  if (format) {
+    if (!g_ascii_strcasecmp(format, "pcap")) fmt = SPLASH_RENDER_RTP_PCAP;
+    else if (!g_ascii_strcasecmp(format, "annexb")) fmt = SPLASH_RENDER_ANNEXB;
+    else {
+      fprintf(stderr, "Invalid --render-format value: %s\n", format);
+      return 2;
+    }
+  }
+  if (frames == 0) frames = (guint64)(ctx->fps * 10 + 0.5);
+
+  SplashRenderStep *steps = g_new0(SplashRenderStep, MAX(specs->len, 1));
+  int *indices = g_new0(int, MAX(specs->len, 1));
+  for (guint i = 0; i < specs->len; ++i) {
+    const char *spec = g_ptr_array_index(specs, i);
+    if (!parse_render_step(ctx, spec, &steps[i], &indices[i])) {
+      fprintf(stderr, "Invalid --render-at value: %s\n", spec);
+      g_free(indices);
+      g_free(steps);
+      return 2;
+    }
+    if (i > 0 && steps[i].frame < steps[i - 1].frame) {
+      fprintf(stderr, "--render-at steps must be in frame order: %s\n", spec);
+      g_free(indices);
+      g_free(steps);
+      return 2;
+    }
+  }
+
+  SplashRenderStats st;
+  gboolean ok = splash_render(ctx->splash, steps, (int)specs->len, frames, path, fmt, &st);
+  g_free(indices);
+  g_free(steps);
+  if (!ok) {
+    fprintf(stderr, "Render to '%s' failed after %" G_GUINT64_FORMAT " frames\n",
+            path, st.frames);
+    return 1;
+  }
+  fprintf(stderr, "Rendered %" G_GUINT64_FORMAT " frames (%" G_GUINT64_FORMAT " bytes",
+          st.frames, st.bytes);
+  if (fmt == SPLASH_RENDER_RTP_PCAP) {
+    fprintf(stderr, ", %" G_GUINT64_FORMAT " RTP packets", st.rtp_packets);
+    if (st.repair_packets) {
+      fprintf(stderr, " + %" G_GUINT64_FORMAT " FEC repair packets", st.repair_packets);
+    }
+  }
+  fprintf(stderr, ") to %s in %.3f ms: %.0f frames/s (%.1fx real time)\n",
+          path, st.elapsed_us / 1000.0, st.frames_per_sec,
+          ctx->fps > 0 ? st.frames_per_sec / ctx->fps : 0.0);
+  return 0;
+}
 
 static void usage(const char *p){
   fprintf(stderr,
     "Usage:\n"
-    "  %s [--cli] [--http-port=PORT] <config.ini>\n\n"
+    "  %s [--cli] [--fast-init] [--http-port=PORT] [--schedule=NAME@WHEN ...] <config.ini>\n"
+    "  %s --render-to=FILE [--render-frames=N] [--render-format=annexb|pcap]\n"
+    "     [--render-at=FRAME:NAME|clear ...] <config.ini>\n\n"
     "The configuration file must contain a [stream] group with keys:\n"
-    "  input=/path/to/file.h265\n"
+    "  input=/path/to/file.h265 (or embedded: for an asset linked in with make EMBED=FILE)\n"
     "  fps=30.0\n"
     "  host=127.0.0.1\n"
     "  port=5600\n"
+    "  mtu=BYTES|auto          (optional; RTP packet size incl. RTP header, default=1200;\n"
+    "                          auto sizes packets to the path MTU towards host)\n"
+    "  payload_type=96..127    (optional; RTP payload type, default=97)\n"
+    "  aggregate=zero-latency|none|max (optional; RTP aggregation packets, default=zero-latency)\n"
+    "  index=auto|memory|off   (optional; frame index sidecar handling, default=auto)\n"
+    "  index_path=FILE         (optional; defaults to <input>.idx)\n"
+    "  cache_bytes=SIZE        (optional; e.g. 8M, bounded frame cache instead of mapping the input)\n"
+    "  cache_pin=N             (optional; frames pinned at each sequence start/end, default=2)\n"
+    "  decompress_threads=N    (optional; workers for gzip/zip/zstd inputs, 0=one per CPU)\n"
+    "  index_threads=N         (optional; workers for the index start-code scan, 0=one per CPU)\n"
+    "  ps_interval=MS          (optional; min spacing of VPS/SPS/PPS resends on IRAPs, default=1000)\n"
+    "  timeline=reset|persistent (optional; keep PTS and RTP SSRC/seqnum/timestamps continuous\n"
+    "                          across stop/start and reloads, default=reset)\n"
+    "  udp_policy=block|leak-oldest|leak-newest (optional; sender backpressure, default=block)\n"
+    "  udp_max_bytes=SIZE, udp_max_time=MS      (optional; queue limits for udp_policy)\n"
+    "  udp_queue=N             (optional; frames queued ahead of the udp delivery thread, default=8)\n"
+    "  udp_max_bitrate=BITS    (optional; cap in bits/s, k/M/G suffixes, decimates frames to fit)\n"
+    "  udp_burst=SIZE          (optional; bucket size for udp_max_bitrate, default=250ms worth)\n"
+    "  appsrc_policy=..., appsrc_max_bytes=SIZE, appsrc_max_time=MS, appsrc_queue=N\n"
+    "  udp_fps=N               (optional; frame-rate cap, frames picked by timestamp, default=all)\n"
+    "  appsrc_max_bitrate=BITS, appsrc_burst=SIZE, appsrc_fps=N\n"
+    "                          (same for the appsrc output)\n"
+    "  media_sched=other|fifo|rr, media_priority=1..99, media_cpus=LIST\n"
+    "                          (optional; media thread scheduling, e.g. media_cpus=2-3)\n"
+    "  stream_sched=..., stream_priority=..., stream_cpus=... (same for streaming threads)\n"
+    "  watchdog_ms=MS          (optional; rebuild the udp sender or reader after MS without a\n"
+    "                          frame or on a pipeline error, keeping the stream going, 0=off)\n"
+    "  latency_sei=true|false  (optional; probe SEI with send time and frame counter in every\n"
+    "                          frame, measured by splash_rx)\n"
+    "  rtx_history=N           (optional; keep N sent RTP packets and retransmit them on RTCP\n"
+    "                          NACKs, RFC 4588, 0=off)\n"
+    "  rtx_payload_type=96..127 (optional; retransmission payload type, default=payload_type+1)\n"
+    "  rtcp_port=PORT          (optional; local port the sender sends from and takes NACKs on,\n"
+    "                          default=any)\n"
+    "  fec=off|xor|rs          (optional; repair packets after every frame for links without\n"
+    "                          NACKs: one XOR parity or fec_n-fec_k Reed-Solomon per block)\n"
+    "  fec_k=N, fec_n=N        (optional; N source packets per block, default=10, and block\n"
+    "                          size with repair for rs, default=fec_k+2)\n"
+    "  fec_payload_type=96..127 (optional; repair payload type, default=payload_type+2)\n"
     "and one or more [sequence NAME] groups. Define raw clips with:\n"
     "  start=BEGIN_FRAME\n"
     "  end=END_FRAME\n"
@@ -419,516 +942,66 @@ static void usage(const char *p){
     "  port=8081   (HTTP control port; defaults to 8081 if omitted)\n\n"
     "  combo_loop_mode=final|entire (default=final).\n\n"
     "Options:\n"
-    "  --cli           Enable interactive stdin controls (1-9 enqueue, c=clear, s=start, x=stop, q=quit).\n"
-    "  --http-port=NN  Override HTTP control port (default is config [control] port or 8081).\n",
-    p);
-}
-
-typedef struct {
-  gchar *name;
-  GPtrArray *parts; // array of gchar* (owned)
-  gboolean loop_at_end;
-} PendingCombo;
-
-static void pending_combo_free(PendingCombo *pc) {
-  if (!pc) return;
-  if (pc->parts) {
-    for (guint i = 0; i < pc->parts->len; ++i) {
-      g_free(g_ptr_array_index(pc->parts, i));
-    }
-    g_ptr_array_free(pc->parts, TRUE);
-  }
-  g_free(pc->name);
-  g_free(pc);
-}
-
-static gchar *extract_sequence_name(const gchar *group, GError **error) {
-  const gsize prefix_len = strlen(SEQ_GROUP_PREFIX);
-  const gchar *raw = group + prefix_len;
-  while (g_ascii_isspace(*raw)) raw++;
-
-  if (*raw == '\0') {
-    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                "Sequence group '%s' is missing a name", group);
-    return NULL;
-  }
-
-  gchar *name = g_strdup(raw);
-  g_strstrip(name);
-  gsize name_len = strlen(name);
-  if (name_len >= 2 && name[0] == '"' && name[name_len - 1] == '"') {
-    memmove(name, name + 1, name_len - 2);
-    name[name_len - 2] = '\0';
-  }
-  if (*name == '\0') {
-    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                "Sequence group '%s' resolved to an empty name", group);
-    g_free(name);
-    return NULL;
-  }
-  return name;
-}
-
-static gboolean parse_sequence_group(GKeyFile *kf, const gchar *group,
-                                     GPtrArray *owned_strings,
-                                     GArray *out_sequences,
-                                     GError **error) {
-  GError *local_error = NULL;
-  gchar *name = extract_sequence_name(group, &local_error);
-  if (!name) {
-    if (local_error) g_propagate_error(error, local_error);
-    return FALSE;
-  }
-
-  gint start = g_key_file_get_integer(kf, group, "start", &local_error);
-  if (local_error) {
-    g_propagate_error(error, local_error);
-    g_free(name);
-    return FALSE;
-  }
-  gint end = g_key_file_get_integer(kf, group, "end", &local_error);
-  if (local_error) {
-    g_propagate_error(error, local_error);
-    g_free(name);
-    return FALSE;
-  }
-  if (start > end) {
-    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                "Sequence '%s' has start (%d) after end (%d)", name, start, end);
-    g_free(name);
-    return FALSE;
-  }
-
-  SplashSeq seq = { name, start, end };
-  g_ptr_array_add(owned_strings, name);
-  g_array_append_val(out_sequences, seq);
-  return TRUE;
-}
-
-static gboolean parse_combo_group(GKeyFile *kf, const gchar *group,
-                                  PendingCombo **out_combo,
-                                  GError **error) {
-  GError *local_error = NULL;
-  gchar *name = extract_sequence_name(group, &local_error);
-  if (!name) {
-    if (local_error) g_propagate_error(error, local_error);
-    return FALSE;
-  }
-
-  gchar *order = g_key_file_get_string(kf, group, "order", &local_error);
-  if (local_error) {
-    g_propagate_error(error, local_error);
-    g_free(name);
-    return FALSE;
-  }
-  if (!order) {
-    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                "Combo sequence '%s' missing order", name);
-    g_free(name);
-    return FALSE;
-  }
-
-  gboolean loop_at_end = FALSE;
-  if (g_key_file_has_key(kf, group, "loop_at_end", NULL)) {
-    local_error = NULL;
-    loop_at_end = g_key_file_get_boolean(kf, group, "loop_at_end", &local_error);
-    if (local_error) {
-      g_propagate_error(error, local_error);
-      g_free(order);
-      g_free(name);
-      return FALSE;
-    }
-  }
-
-  gchar **parts = g_strsplit(order, ",", -1);
-  g_free(order);
-  if (!parts) {
-    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                "Combo sequence '%s' has invalid order", name);
-    g_free(name);
-    return FALSE;
-  }
-
-  GPtrArray *part_array = g_ptr_array_new();
-  for (gchar **p = parts; *p; ++p) {
-    gchar *trimmed = g_strdup(*p);
-    g_strstrip(trimmed);
-    if (trimmed[0] == '\0') {
-      g_free(trimmed);
-      g_strfreev(parts);
-      if (part_array) {
-        for (guint i = 0; i < part_array->len; ++i) {
-          g_free(g_ptr_array_index(part_array, i));
-        }
-        g_ptr_array_free(part_array, TRUE);
-      }
-      g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                  "Combo sequence '%s' contains an empty entry", name);
-      g_free(name);
-      return FALSE;
-    }
-    g_ptr_array_add(part_array, trimmed);
-  }
-  g_strfreev(parts);
-
-  if (part_array->len == 0) {
-    for (guint i = 0; i < part_array->len; ++i) {
-      g_free(g_ptr_array_index(part_array, i));
-    }
-    g_ptr_array_free(part_array, TRUE);
-    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
-                "Combo sequence '%s' has an empty order", name);
-    g_free(name);
-    return FALSE;
-  }
-
-  PendingCombo *combo = g_new0(PendingCombo, 1);
-  combo->name = name;
-  combo->parts = part_array;
-  combo->loop_at_end = loop_at_end;
-  *out_combo = combo;
-  return TRUE;
-}
-
-static gboolean load_config(const char *path,
-                            SplashConfig *cfg,
-                            SplashSeq **seqs_out,
-                            int *n_seqs_out,
-                            ComboSeq **combos_out,
-                            int *n_combos_out,
-                            GPtrArray **owned_strings_out,
-                            gboolean *combo_loop_full_out,
-                            guint16 *http_port_out) {
-  gboolean ok = FALSE;
-  GError *error = NULL;
-  ComboSeq *combo_array = NULL;
-  guint combo_count = 0;
-  GPtrArray *combo_defs = NULL;
-  gboolean combo_loop_full = FALSE;
-  GKeyFile *kf = g_key_file_new();
-  if (!kf) return FALSE;
-
-  if (combos_out) *combos_out = NULL;
-  if (n_combos_out) *n_combos_out = 0;
-  if (combo_loop_full_out) *combo_loop_full_out = FALSE;
-
-  gchar *config_abs = g_canonicalize_filename(path, NULL);
-  if (!config_abs) {
-    g_key_file_free(kf);
-    return FALSE;
-  }
-
-  gchar *config_dir = g_path_get_dirname(config_abs);
-  if (!config_dir) {
-    g_free(config_abs);
-    g_key_file_free(kf);
-    return FALSE;
-  }
-
-  if (!g_key_file_load_from_file(kf, config_abs, G_KEY_FILE_NONE, &error)) {
-    fprintf(stderr, "Failed to read config '%s': %s\n", path,
-            error ? error->message : "unknown error");
-    if (error) g_error_free(error);
-    g_free(config_abs);
-    g_free(config_dir);
-    g_key_file_free(kf);
-    return FALSE;
-  }
-
-  GPtrArray *owned_strings = g_ptr_array_new_with_free_func(g_free);
-  if (!owned_strings) {
-    g_free(config_abs);
-    g_free(config_dir);
-    g_key_file_free(kf);
-    return FALSE;
-  }
-
-  error = NULL;
-  gchar *input = g_key_file_get_string(kf, "stream", "input", &error);
-  if (error) {
-    fprintf(stderr, "Config missing stream.input: %s\n", error->message);
-    g_error_free(error);
-    goto done;
-  }
-  gchar *resolved_input = g_canonicalize_filename(input, config_dir);
-  if (!resolved_input) {
-    fprintf(stderr, "Failed to resolve stream.input path '%s'\n", input);
-    g_free(input);
-    goto done;
-  }
-  g_free(input);
-  if (!g_file_test(resolved_input, G_FILE_TEST_EXISTS)) {
-    fprintf(stderr, "Configured input file '%s' does not exist\n",
-            resolved_input);
-    g_free(resolved_input);
-    goto done;
-  }
-  g_ptr_array_add(owned_strings, resolved_input);
-  cfg->input_path = resolved_input;
-
-  error = NULL;
-  cfg->fps = g_key_file_get_double(kf, "stream", "fps", &error);
-  if (error) {
-    fprintf(stderr, "Config missing/invalid stream.fps: %s\n", error->message);
-    g_error_free(error);
-    goto done;
-  }
-
-  cfg->outputs = SPLASH_OUTPUT_UDP;
-  if (g_key_file_has_key(kf, "stream", "outputs", NULL)) {
-    error = NULL;
-    gchar *outputs = g_key_file_get_string(kf, "stream", "outputs", &error);
-    if (error) {
-      fprintf(stderr, "Invalid stream.outputs: %s\n", error->message);
-      g_error_free(error);
-      goto done;
-    }
-    if (!parse_stream_outputs(outputs, &cfg->outputs)) {
-      fprintf(stderr, "stream.outputs must contain only 'udp' and/or 'appsrc'\n");
-      g_free(outputs);
-      goto done;
-    }
-    g_free(outputs);
-  }
-
-  if (cfg->outputs & SPLASH_OUTPUT_UDP) {
-    error = NULL;
-    gchar *host = g_key_file_get_string(kf, "stream", "host", &error);
-    if (error) {
-      fprintf(stderr, "Config missing stream.host: %s\n", error->message);
-      g_error_free(error);
-      goto done;
-    }
-    g_ptr_array_add(owned_strings, host);
-    cfg->endpoint.host = host;
-
-    error = NULL;
-    cfg->endpoint.port = g_key_file_get_integer(kf, "stream", "port", &error);
-    if (error) {
-      fprintf(stderr, "Config missing/invalid stream.port: %s\n", error->message);
-      g_error_free(error);
-      goto done;
-    }
-  } else {
-    cfg->endpoint.host = NULL;
-    cfg->endpoint.port = 0;
-  }
-
-  guint16 control_port = 8081;
-  if (g_key_file_has_key(kf, "control", "port", NULL)) {
-    error = NULL;
-    gint configured_port = g_key_file_get_integer(kf, "control", "port", &error);
-    if (error) {
-      fprintf(stderr, "Invalid control.port: %s\n", error->message);
-      g_error_free(error);
-      goto done;
-    }
-    if (configured_port < 1 || configured_port > 65535) {
-      fprintf(stderr, "control.port must be between 1 and 65535 (got %d)\n", configured_port);
-      goto done;
-    }
-    control_port = (guint16)configured_port;
-  }
-
-  if (g_key_file_has_key(kf, "control", "combo_loop_mode", NULL)) {
-    error = NULL;
-    gchar *mode = g_key_file_get_string(kf, "control", "combo_loop_mode", &error);
-    if (error) {
-      fprintf(stderr, "Invalid control.combo_loop_mode: %s\n", error->message);
-      g_error_free(error);
-      goto done;
-    }
-    if (mode) {
-      if (g_ascii_strcasecmp(mode, "entire") == 0 ||
-          g_ascii_strcasecmp(mode, "full") == 0 ||
-          g_ascii_strcasecmp(mode, "all") == 0) {
-        combo_loop_full = TRUE;
-      } else if (g_ascii_strcasecmp(mode, "final") == 0 ||
-                 g_ascii_strcasecmp(mode, "last") == 0) {
-        combo_loop_full = FALSE;
-      } else {
-        fprintf(stderr,
-                "control.combo_loop_mode must be 'entire' or 'final' (got '%s')\n",
-                mode);
-        g_free(mode);
-        goto done;
-      }
-    }
-    g_free(mode);
-  }
-
-  GArray *seq_array = g_array_new(FALSE, FALSE, sizeof(SplashSeq));
-  if (!seq_array) goto done;
-  combo_defs = g_ptr_array_new_with_free_func((GDestroyNotify)pending_combo_free);
-  if (!combo_defs) {
-    g_array_free(seq_array, TRUE);
-    goto done;
-  }
-
-  gsize n_groups = 0;
-  gchar **groups = g_key_file_get_groups(kf, &n_groups);
-  for (gsize i = 0; i < n_groups; ++i) {
-    if (g_str_has_prefix(groups[i], SEQ_GROUP_PREFIX)) {
-      gboolean has_order = g_key_file_has_key(kf, groups[i], "order", NULL);
-      gboolean has_start = g_key_file_has_key(kf, groups[i], "start", NULL);
-      gboolean has_end = g_key_file_has_key(kf, groups[i], "end", NULL);
-      if (has_order) {
-        if (has_start || has_end) {
-          fprintf(stderr,
-                  "Sequence group '%s' cannot mix order with start/end\n",
-                  groups[i]);
-          g_strfreev(groups);
-          g_array_free(seq_array, TRUE);
-          goto done;
-        }
-        PendingCombo *combo = NULL;
-        if (!parse_combo_group(kf, groups[i], &combo, &error)) {
-          fprintf(stderr, "Invalid combo sequence config: %s\n",
-                  error ? error->message : "unknown error");
-          if (error) g_error_free(error);
-          error = NULL;
-          g_strfreev(groups);
-          g_array_free(seq_array, TRUE);
-          g_ptr_array_free(combo_defs, TRUE);
-          combo_defs = NULL;
-          goto done;
-        }
-        g_ptr_array_add(combo_defs, combo);
-      } else {
-        if (!parse_sequence_group(kf, groups[i], owned_strings, seq_array, &error)) {
-          fprintf(stderr, "Invalid sequence config: %s\n",
-                  error ? error->message : "unknown error");
-          if (error) g_error_free(error);
-          error = NULL;
-          g_strfreev(groups);
-          g_array_free(seq_array, TRUE);
-          g_ptr_array_free(combo_defs, TRUE);
-          combo_defs = NULL;
-          goto done;
-        }
-      }
-    }
-  }
-  g_strfreev(groups);
-
-  if (seq_array->len == 0) {
-    fprintf(stderr, "Config must define at least one [sequence NAME] group\n");
-    g_array_free(seq_array, TRUE);
-    g_ptr_array_free(combo_defs, TRUE);
-    combo_defs = NULL;
-    goto done;
-  }
-
-  guint seq_count = seq_array->len;
-  SplashSeq *seqs = g_new0(SplashSeq, seq_count);
-  if (!seqs) {
-    g_array_free(seq_array, TRUE);
-    goto done;
-  }
-
-  for (guint i = 0; i < seq_count; ++i) {
-    seqs[i] = g_array_index(seq_array, SplashSeq, i);
-  }
-  g_array_free(seq_array, TRUE);
-
-  combo_count = combo_defs->len;
-  if (combo_count > 0) {
-    combo_array = g_new0(ComboSeq, combo_count);
-    if (!combo_array) {
-      g_ptr_array_free(combo_defs, TRUE);
-      combo_defs = NULL;
-      g_free(seqs);
-      goto done;
-    }
-    for (guint i = 0; i < combo_count; ++i) {
-      PendingCombo *pc = g_ptr_array_index(combo_defs, i);
-      combo_array[i].count = (int)pc->parts->len;
-      combo_array[i].indices = g_new0(int, combo_array[i].count);
-      if (!combo_array[i].indices) {
-        g_ptr_array_free(combo_defs, TRUE);
-        combo_defs = NULL;
-        for (guint k = 0; k <= i; ++k) {
-          if (combo_array[k].indices) g_free(combo_array[k].indices);
-        }
-        g_free(combo_array);
-        g_free(seqs);
-        goto done;
-      }
-      combo_array[i].name = pc->name;
-      g_ptr_array_add(owned_strings, pc->name);
-      pc->name = NULL;
-      combo_array[i].loop_at_end = pc->loop_at_end;
-      for (guint j = 0; j < pc->parts->len; ++j) {
-        const char *part_name = g_ptr_array_index(pc->parts, j);
-        int found = -1;
-        for (guint sidx = 0; sidx < seq_count; ++sidx) {
-          if (g_strcmp0(seqs[sidx].name, part_name) == 0) {
-            found = (int)sidx;
-            break;
-          }
-        }
-        if (found < 0) {
-          fprintf(stderr,
-                  "Combo sequence '%s' references unknown sequence '%s'\n",
-                  combo_array[i].name ? combo_array[i].name : "?",
-                  part_name);
-          g_ptr_array_free(combo_defs, TRUE);
-          combo_defs = NULL;
-          for (guint k = 0; k <= i; ++k) {
-            g_free(combo_array[k].indices);
-          }
-          g_free(combo_array);
-          g_free(seqs);
-          goto done;
-        }
-        combo_array[i].indices[j] = found;
-      }
-    }
-  }
-  if (combo_defs) {
-    g_ptr_array_free(combo_defs, TRUE);
-    combo_defs = NULL;
-  }
-
-  *seqs_out = seqs;
-  *n_seqs_out = (int)seq_count;
-  if (combos_out) *combos_out = combo_array;
-  if (n_combos_out) *n_combos_out = (int)combo_count;
-  *owned_strings_out = owned_strings;
-  if (combo_loop_full_out) *combo_loop_full_out = combo_loop_full;
-  if (http_port_out) *http_port_out = control_port;
-  ok = TRUE;
-
-done:
-  if (!ok) {
-    if (combo_array) {
-      for (guint i = 0; i < combo_count; ++i) {
-        g_free(combo_array[i].indices);
-      }
-      g_free(combo_array);
-    }
-  }
-  if (combo_defs) {
-    g_ptr_array_free(combo_defs, TRUE);
-  }
-  if (!ok) {
-    g_ptr_array_free(owned_strings, TRUE);
-  }
-  g_free(config_abs);
-  g_free(config_dir);
-  g_key_file_free(kf);
-  return ok;
+    "  --cli           Enable interactive stdin controls (1-9 enqueue, c=clear, s=start, p=pause, r=resume, x=stop, q=quit).\n"
+    "  --fast-init     Initialise GStreamer without a plugin registry rescan (prints the\n"
+    "                  startup breakdown either way once the first packet is out).\n"
+    "  --http-port=NN  Override HTTP control port (default is config [control] port or 8081).\n"
+    "  --schedule=NAME@WHEN\n"
+    "                  Switch to sequence NAME at WHEN: +SECONDS from start, Unix time\n"
+    "                  SECONDS[.frac] or local time HH:MM[:SS]. May be repeated.\n"
+    "  --render-to=FILE\n"
+    "                  Render offline instead of streaming: run the loop engine unpaced\n"
+    "                  and write the stream as Annex-B, or as an RTP capture when FILE\n"
+    "                  ends in .pcap (or --render-format=pcap). Needs index=auto|memory.\n"
+    "  --render-frames=N  Frames to render (default: 10 seconds).\n"
+    "  --render-at=FRAME:NAME|clear\n"
+    "                  Enqueue sequence or combo NAME (or clear the queue) before output\n"
+    "                  frame FRAME. May be repeated, in frame order.\n",
+    p, p);
 }
 
 int main(int argc, char **argv){
+  gint64 t_main = g_get_monotonic_time();
   gboolean cli_mode = FALSE;
+  gboolean fast_init = FALSE;
   gboolean port_overridden = FALSE;
   guint16 http_port = 0;
   const char *config_path = NULL;
+  GPtrArray *schedules = g_ptr_array_new();
+  const char *render_path = NULL;
+  const char *render_format = NULL;
+  guint64 render_frames = 0;
+  GPtrArray *render_steps = g_ptr_array_new();
 
   for (int i = 1; i < argc; ++i) {
     if (!strcmp(argv[i], "--cli")) {
       cli_mode = TRUE;
+    } else if (!strcmp(argv[i], "--fast-init")) {
+      fast_init = TRUE;
+    } else if (g_str_has_prefix(argv[i], "--schedule=")) {
+      const char *spec = argv[i] + strlen("--schedule=");
+      const char *at = strrchr(spec, '@');
+      if (!at || at == spec || !at[1]) {
+        fprintf(stderr, "Invalid --schedule value: %s\n", spec);
+        usage(argv[0]);
+        return 2;
+      }
+      g_ptr_array_add(schedules, (gpointer)spec);
+    } else if (g_str_has_prefix(argv[i], "--render-to=") && argv[i][12]) {
+      render_path = argv[i] + strlen("--render-to=");
+    } else if (g_str_has_prefix(argv[i], "--render-format=")) {
+      render_format = argv[i] + strlen("--render-format=");
+    } else if (g_str_has_prefix(argv[i], "--render-frames=")) {
+      const char *num = argv[i] + strlen("--render-frames=");
+      gchar *endptr = NULL;
+      render_frames = g_ascii_strtoull(num, &endptr, 10);
+      if (!num[0] || *endptr || render_frames == 0) {
+        fprintf(stderr, "Invalid --render-frames value: %s\n", num);
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (g_str_has_prefix(argv[i], "--render-at=")) {
+      g_ptr_array_add(render_steps, argv[i] + strlen("--render-at="));
     } else if (g_str_has_prefix(argv[i], "--http-port=")) {
       const char *num = argv[i] + strlen("--http-port=");
       gchar *endptr = NULL;
@@ -961,9 +1034,9 @@ int main(int argc, char **argv){
   SplashConfig cfg = {0};
   guint16 config_http_port = 8081;
   gboolean combo_loop_full = FALSE;
-  if (!load_config(config_path, &cfg, &seqs, &n_seqs,
-                   &combos, &n_combos,
-                   &owned_strings, &combo_loop_full, &config_http_port)) {
+  if (!splash_conf_load(config_path, &cfg, &seqs, &n_seqs,
+                        &combos, &n_combos,
+                        &owned_strings, &combo_loop_full, &config_http_port)) {
     return 1;
   }
 
@@ -971,16 +1044,33 @@ int main(int argc, char **argv){
     http_port = config_http_port;
   }
 
+  gint64 t_config = g_get_monotonic_time();
+  splash_init(fast_init ? SPLASH_INIT_FAST : SPLASH_INIT_DEFAULT);
   Splash *S = splash_new();
+  if (!S) {
+    fprintf(stderr, "Failed to initialise GStreamer\n");
+    g_free(seqs);
+    splash_conf_free_combos(combos, n_combos);
+    g_ptr_array_free(owned_strings, TRUE);
+    return 1;
+  }
   AppCtx ctx = {0};
+  ctx.t_main = t_main;
+  ctx.t_config = t_config;
+  ctx.t_init = g_get_monotonic_time();
+  ctx.fast_init = fast_init;
   ctx.splash = S;
   ctx.sequences = seqs;
   ctx.sequence_count = n_seqs;
+  ctx.fps = cfg.fps;
   ctx.combos = combos;
   ctx.combo_count = n_combos;
   ctx.started = FALSE;
   ctx.combo_loop_full = combo_loop_full;
   ctx.loop = g_main_loop_new(NULL, FALSE);
+  ctx.config_path = config_path;
+  ctx.owned_strings = owned_strings;
+  ctx.boot_us = g_get_monotonic_time();
 
   splash_set_event_cb(S, on_evt, &ctx);
 
@@ -989,7 +1079,7 @@ int main(int argc, char **argv){
     if (ctx.loop) g_main_loop_unref(ctx.loop);
     splash_free(S);
     g_free(seqs);
-    free_combos(combos, n_combos);
+    splash_conf_free_combos(combos, n_combos);
     g_ptr_array_free(owned_strings, TRUE);
     return 1;
   }
@@ -999,21 +1089,75 @@ int main(int argc, char **argv){
     if (ctx.loop) g_main_loop_unref(ctx.loop);
     splash_free(S);
     g_free(seqs);
-    free_combos(combos, n_combos);
+    splash_conf_free_combos(combos, n_combos);
     g_ptr_array_free(owned_strings, TRUE);
     return 1;
   }
+  ctx.t_apply = g_get_monotonic_time();
+  if (render_path) {
+    if (schedules->len > 0) fprintf(stderr, "Ignoring --schedule options when rendering\n");
+    int rc = run_render(&ctx, render_path, render_format, render_frames, render_steps);
+    g_ptr_array_free(render_steps, TRUE);
+    g_ptr_array_free(schedules, TRUE);
+    if (ctx.loop) g_main_loop_unref(ctx.loop);
+    splash_free(S);
+    g_free(seqs);
+    splash_conf_free_combos(combos, n_combos);
+    g_ptr_array_free(owned_strings, TRUE);
+    return rc;
+  }
+  g_ptr_array_free(render_steps, TRUE);
+
   if (!splash_start(S)) {
     fprintf(stderr, "Failed to start\n");
     if (ctx.loop) g_main_loop_unref(ctx.loop);
     splash_free(S);
     g_free(seqs);
-    free_combos(combos, n_combos);
+    splash_conf_free_combos(combos, n_combos);
     g_ptr_array_free(owned_strings, TRUE);
     return 1;
   }
   ctx.started = TRUE;
 
+  for (guint i = 0; i < schedules->len; ++i) {
+    const char *spec = g_ptr_array_index(schedules, i);
+    const char *at = strrchr(spec, '@');
+    gchar *name = g_strndup(spec, (gsize)(at - spec));
+    gboolean not_found = FALSE;
+    guint id = schedule_by_name(&ctx, name, at + 1, &not_found);
+    if (id > 0) {
+      fprintf(stderr, "Scheduled '%s' at %s (id %u)\n", name, at + 1, id);
+    } else {
+      fprintf(stderr, "Ignoring --schedule=%s: %s\n", spec,
+              not_found ? "unknown sequence" : "invalid time");
+    }
+    g_free(name);
+  }
+  g_ptr_array_free(schedules, TRUE);
+
+  SplashStats boot_stats;
+  splash_get_stats(S, &boot_stats);
+  if (boot_stats.index_frames > 0) {
+    if (boot_stats.decompress_threads > 0) {
+      fprintf(stderr, "Input decompressed in %.3f ms using %u thread(s)\n",
+              boot_stats.decompress_us / 1000.0, boot_stats.decompress_threads);
+    }
+    fprintf(stderr, "Frame index: %d frames %s in %.3f ms%s\n",
+            boot_stats.index_frames,
+            boot_stats.index_from_sidecar ? "mapped from sidecar" : "scanned",
+            boot_stats.index_time_us / 1000.0,
+            boot_stats.index_saved ? " (sidecar written)" : "");
+    if (cfg.cache_bytes > 0) {
+      fprintf(stderr, "Frame cache: budget %" G_GUINT64_FORMAT " bytes, "
+              "%u frames pinned (%" G_GUINT64_FORMAT " bytes)\n",
+              cfg.cache_bytes, boot_stats.cache_frames_pinned,
+              boot_stats.cache_bytes_pinned);
+    }
+  } else {
+    fprintf(stderr, "Frame index disabled; using h265parse reader\n");
+  }
+
+  build_http_cache(&ctx);
   GSocketService *http_service = g_socket_service_new();
   g_signal_connect(http_service, "incoming", G_CALLBACK(on_http_client), &ctx);
   gboolean http_ok = FALSE;
@@ -1034,7 +1178,7 @@ int main(int argc, char **argv){
   if (http_ok) {
     g_socket_service_start(http_service);
     fprintf(stderr,
-            "HTTP control listening on http://127.0.0.1:%u/request/{start,stop,enqueue/<name>,list}\n",
+            "HTTP control listening on http://127.0.0.1:%u/request/{start,stop,pause,resume,enqueue/<name>,schedule/<name>/<when>,list,status,stats,reload}\n",
             bind_port);
   } else {
     fprintf(stderr, "HTTP control disabled (no available port).\n");
@@ -1066,7 +1210,7 @@ int main(int argc, char **argv){
   }
   if (cli_mode) {
     fprintf(stderr,
-            "Interactive CLI enabled. Press 1-%d to enqueue; c=clear; s=start; x=stop; q=quit\n",
+            "Interactive CLI enabled. Press 1-%d to enqueue; c=clear; s=start; p=pause; r=resume; x=stop; q=quit\n",
             n_seqs < 9 ? n_seqs : 9);
   }
 
@@ -1097,8 +1241,10 @@ int main(int argc, char **argv){
   }
   if (ctx.loop) g_main_loop_unref(ctx.loop);
   splash_free(S);
-  g_free(seqs);
-  free_combos(combos, n_combos);
-  g_ptr_array_free(owned_strings, TRUE);
+  // A reload may have replaced the definitions loaded above
+  free_http_cache(&ctx);
+  g_free(ctx.sequences);
+  splash_conf_free_combos(ctx.combos, ctx.combo_count);
+  g_ptr_array_free(ctx.owned_strings, TRUE);
   return 0;
 }
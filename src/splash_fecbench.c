@@ -0,0 +1,128 @@
+// FEC encoder micro-benchmark: MB/s of the GF(2^8) multiply-add of each
+// splashfec implementation, and of whole XOR / Reed-Solomon blocks of
+// MTU-sized RTP packets, checked against the scalar results.
+//
+//   ./splash_fecbench [--size=KB] [--k=N] [--n=N] [--reps=N]
+
+#include "splashfec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PACKET_BYTES 1200
+#define RTP_HEADER   12
+
+static guint8* synth(gsize len, guint32 seed){
+  guint8 *p = g_malloc(len);
+  GRand *r = g_rand_new_with_seed(seed);
+  for (gsize i = 0; i < len; ++i) p[i] = (guint8)g_rand_int(r);
+  g_rand_free(r);
+  return p;
+}
+
+// XOR-folds every repair packet's payload, to compare implementations.
+static void fold(const guint8 *pkt, gsize len, gpointer user){
+  guint8 *sum = user;
+  for (gsize i = RTP_HEADER; i < len; ++i) sum[(i - RTP_HEADER) % PACKET_BYTES] ^= pkt[i];
+}
+
+// One frame of `count` packets through a fresh encoder; returns microseconds.
+static gint64 encode_frame(SplashFecScheme scheme, guint k, guint n, const guint8 *data,
+                           guint count, guint8 *sum){
+  SplashFecEnc *e = splash_fec_enc_new(scheme, k, n, 98, 0x5eed, 0);
+  guint8 pkt[RTP_HEADER + PACKET_BYTES];
+  gint64 t0 = g_get_monotonic_time();
+  for (guint i = 0; i < count; ++i) {
+    memset(pkt, 0, RTP_HEADER);
+    pkt[0] = 0x80;
+    pkt[1] = (guint8)(96 | (i + 1 == count ? 0x80 : 0));
+    pkt[2] = (guint8)(i >> 8);
+    pkt[3] = (guint8)i;
+    pkt[11] = 1;
+    memcpy(pkt + RTP_HEADER, data + (gsize)i * PACKET_BYTES, PACKET_BYTES);
+    splash_fec_enc_push(e, pkt, sizeof(pkt), fold, sum);
+  }
+  gint64 us = g_get_monotonic_time() - t0;
+  splash_fec_enc_unref(e);
+  return us;
+}
+
+static void report(const char *name, const char *what, gsize len, gint64 best_us){
+  printf("%-8s %-10s %9.1f MB/s  %8.3f ms\n", name, what,
+         best_us > 0 ? (double)len / best_us : 0.0, best_us / 1000.0);
+}
+
+int main(int argc, char **argv){
+  gsize size_kb = 4096;
+  guint k = 10, n = 12, reps = 5;
+  for (int i = 1; i < argc; ++i) {
+    if (g_str_has_prefix(argv[i], "--size=")) size_kb = strtoul(argv[i] + 7, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--k=")) k = strtoul(argv[i] + 4, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--n=")) n = strtoul(argv[i] + 4, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--reps=")) reps = strtoul(argv[i] + 7, NULL, 10);
+    else {
+      fprintf(stderr, "Usage: %s [--size=KB] [--k=N] [--n=N] [--reps=N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (reps == 0) reps = 1;
+  k = CLAMP(k, 1, SPLASH_FEC_MAX_N - 1);
+  n = CLAMP(n, k + 1, SPLASH_FEC_MAX_N);
+
+  guint count = (guint)MAX(size_kb * 1024 / PACKET_BYTES, 1);
+  gsize len = (gsize)count * PACKET_BYTES;
+  guint8 *src = synth(len, 42);
+  guint8 *dst = synth(len, 7);
+  guint8 *ref = g_malloc(len);
+  guint8 ref_xor[PACKET_BYTES], ref_rs[PACKET_BYTES];
+  printf("%u packets of %d bytes, k=%u n=%u, best of %u\n", count, PACKET_BYTES, k, n, reps);
+
+  int rc = 0;
+  static const SplashFecImpl impls[] = {
+    SPLASH_FEC_IMPL_SCALAR, SPLASH_FEC_IMPL_SSSE3, SPLASH_FEC_IMPL_AVX2, SPLASH_FEC_IMPL_NEON,
+  };
+  for (gsize i = 0; i < G_N_ELEMENTS(impls); ++i) {
+    if (!splash_fec_set_impl(impls[i])) continue;
+    const char *name = splash_fec_impl_name(impls[i]);
+
+    gint64 best = G_MAXINT64;
+    guint8 *out = g_malloc(len);
+    for (guint r = 0; r < reps; ++r) {
+      memcpy(out, dst, len);
+      gint64 t0 = g_get_monotonic_time();
+      splash_fec_mul_add(out, src, (guint8)(0x53 + r), len);
+      best = MIN(best, g_get_monotonic_time() - t0);
+    }
+    report(name, "mul_add", len, best);
+    if (i == 0) memcpy(ref, out, len);
+    else if (memcmp(ref, out, len)) rc = 1;
+    g_free(out);
+
+    guint8 sum[PACKET_BYTES];
+    best = G_MAXINT64;
+    for (guint r = 0; r < reps; ++r) {
+      memset(sum, 0, sizeof(sum));
+      gint64 us = encode_frame(SPLASH_FEC_XOR, k, n, src, count, sum);
+      best = MIN(best, us);
+    }
+    report(name, "xor", len, best);
+    if (i == 0) memcpy(ref_xor, sum, sizeof(sum));
+    else if (memcmp(ref_xor, sum, sizeof(sum))) rc = 1;
+
+    best = G_MAXINT64;
+    for (guint r = 0; r < reps; ++r) {
+      memset(sum, 0, sizeof(sum));
+      gint64 us = encode_frame(SPLASH_FEC_RS, k, n, src, count, sum);
+      best = MIN(best, us);
+    }
+    report(name, "rs", len, best);
+    if (i == 0) memcpy(ref_rs, sum, sizeof(sum));
+    else if (memcmp(ref_rs, sum, sizeof(sum))) rc = 1;
+  }
+  if (rc) fprintf(stderr, "MISMATCH: an implementation disagrees with the scalar one\n");
+
+  g_free(ref);
+  g_free(dst);
+  g_free(src);
+  return rc;
+}
@@ -0,0 +1,162 @@
+// Load generator for the HTTP control port: fires GET requests at one route
+// from several connections at once and reports the request rate, the
+// client-side latency and the main-loop CPU time per request the server
+// measured (the http block of /request/stats, before and after).
+//
+//   ./splash_httpload [--port=N] [--host=ADDR] [--route=PATH] [--requests=N]
+//                     [--conns=N]
+//
+// splash_main must already be running; make bench-http measures the cached
+// routes /request/list and /request/status.
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_PORT     8081
+#define DEFAULT_REQUESTS 20000
+#define DEFAULT_CONNS    4
+#define REPLY_BYTES      65536
+
+typedef struct {
+  const char *host;
+  guint16 port;
+  const char *route;
+  guint requests;        // per connection
+  GArray *lat_us;        // gint64, this connection's
+  guint failed;
+} Worker;
+
+// One request on a fresh connection (the server closes after each reply).
+// Returns the reply, or NULL.
+static GString* get(const char *host, guint16 port, const char *route){
+  GSocketClient *client = g_socket_client_new();
+  GSocketConnection *conn = g_socket_client_connect_to_host(client, host, port, NULL, NULL);
+  g_object_unref(client);
+  if (!conn) return NULL;
+  gchar *req = g_strdup_printf("GET %s HTTP/1.0\r\nHost: %s\r\n\r\n", route, host);
+  GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+  GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(conn));
+  GString *reply = NULL;
+  if (g_output_stream_write_all(out, req, strlen(req), NULL, NULL, NULL)) {
+    reply = g_string_new(NULL);
+    gchar buf[4096];
+    gssize n;
+    while ((n = g_input_stream_read(in, buf, sizeof(buf), NULL, NULL)) > 0 &&
+           reply->len < REPLY_BYTES) {
+      g_string_append_len(reply, buf, n);
+    }
+    if (!g_str_has_prefix(reply->str, "HTTP/1.1 200") &&
+        !g_str_has_prefix(reply->str, "HTTP/1.0 200")) {
+      g_string_free(reply, TRUE);
+      reply = NULL;
+    }
+  }
+  g_free(req);
+  g_object_unref(conn);
+  return reply;
+}
+
+static gpointer run_worker(gpointer user){
+  Worker *w = (Worker*)user;
+  for (guint i = 0; i < w->requests; ++i) {
+    gint64 t0 = g_get_monotonic_time();
+    GString *reply = get(w->host, w->port, w->route);
+    gint64 us = g_get_monotonic_time() - t0;
+    if (!reply) {
+      w->failed++;
+      continue;
+    }
+    g_string_free(reply, TRUE);
+    g_array_append_val(w->lat_us, us);
+  }
+  return NULL;
+}
+
+// The server's http counters from /request/stats.
+static gboolean http_counters(const char *host, guint16 port, guint64 *requests, gint64 *cpu_us){
+  GString *reply = get(host, port, "/request/stats");
+  if (!reply) return FALSE;
+  const char *p = strstr(reply->str, "\"http\":{\"requests\":");
+  gboolean ok = p && sscanf(p, "\"http\":{\"requests\":%" G_GUINT64_FORMAT ",\"cpu_us\":%" G_GINT64_FORMAT,
+                            requests, cpu_us) == 2;
+  g_string_free(reply, TRUE);
+  return ok;
+}
+
+static int cmp_i64(gconstpointer a, gconstpointer b){
+  gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+  return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv){
+  const char *host = "127.0.0.1", *route = "/request/status";
+  guint port = DEFAULT_PORT, requests = DEFAULT_REQUESTS, conns = DEFAULT_CONNS;
+  for (int i = 1; i < argc; ++i) {
+    if (g_str_has_prefix(argv[i], "--port=")) port = strtoul(argv[i] + 7, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--host=")) host = argv[i] + 7;
+    else if (g_str_has_prefix(argv[i], "--route=")) route = argv[i] + 8;
+    else if (g_str_has_prefix(argv[i], "--requests=")) requests = strtoul(argv[i] + 11, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--conns=")) conns = strtoul(argv[i] + 8, NULL, 10);
+    else {
+      fprintf(stderr, "Usage: %s [--port=N] [--host=ADDR] [--route=PATH] [--requests=N]"
+              " [--conns=N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (port == 0 || port > 65535 || route[0] != '/') {
+    fprintf(stderr, "Invalid --port or --route\n");
+    return 2;
+  }
+  conns = CLAMP(conns, 1, 256);
+  requests = MAX(requests, conns);
+
+  guint64 req0 = 0, req1 = 0;
+  gint64 cpu0 = 0, cpu1 = 0;
+  if (!http_counters(host, (guint16)port, &req0, &cpu0)) {
+    fprintf(stderr, "No /request/stats on %s:%u; is splash_main running?\n", host, port);
+    return 1;
+  }
+
+  Worker *w = g_new0(Worker, conns);
+  GThread **threads = g_new0(GThread*, conns);
+  gint64 t0 = g_get_monotonic_time();
+  for (guint i = 0; i < conns; ++i) {
+    w[i].host = host;
+    w[i].port = (guint16)port;
+    w[i].route = route;
+    w[i].requests = requests / conns;
+    w[i].lat_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+    threads[i] = g_thread_new("httpload", run_worker, &w[i]);
+  }
+  GArray *lat = g_array_new(FALSE, FALSE, sizeof(gint64));
+  guint failed = 0;
+  for (guint i = 0; i < conns; ++i) {
+    g_thread_join(threads[i]);
+    g_array_append_vals(lat, w[i].lat_us->data, w[i].lat_us->len);
+    g_array_free(w[i].lat_us, TRUE);
+    failed += w[i].failed;
+  }
+  gint64 wall_us = g_get_monotonic_time() - t0;
+  gboolean have_after = http_counters(host, (guint16)port, &req1, &cpu1);
+
+  g_array_sort(lat, cmp_i64);
+  double avg = 0;
+  for (guint i = 0; i < lat->len; ++i) avg += g_array_index(lat, gint64, i);
+  if (lat->len) avg /= lat->len;
+  gint64 p99 = lat->len ? g_array_index(lat, gint64, (lat->len - 1) * 99 / 100) : 0;
+  printf("%s: %u requests on %u connection(s), %u failed, %.0f req/s\n",
+         route, lat->len, conns, failed, wall_us > 0 ? lat->len * 1e6 / wall_us : 0.0);
+  printf("latency: avg %.1f us, p99 %" G_GINT64_FORMAT " us\n", avg, p99);
+  // The stats request before counts in the difference, the one after does not
+  if (have_after && req1 > req0) {
+    printf("server main-loop CPU: %.2f us per request (%" G_GUINT64_FORMAT " requests)\n",
+           (double)(cpu1 - cpu0) / (double)(req1 - req0), req1 - req0);
+  }
+
+  g_array_free(lat, TRUE);
+  g_free(threads);
+  g_free(w);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,44 @@
+// Writes the frame index sidecar of an Annex-B H.265 file, as splash_main
+// would on its first start with index=auto. The Makefile uses it to build
+// the index linked in next to an embedded asset (make EMBED=FILE).
+//
+//   ./splash_mkindex INPUT [OUTPUT]     (OUTPUT defaults to INPUT.idx)
+
+#include "splashindex.h"
+#include <stdio.h>
+
+int main(int argc, char **argv){
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: %s INPUT [OUTPUT]\n", argv[0]);
+    return 2;
+  }
+  const char *input = argv[1];
+  gchar *output = argc > 2 ? g_strdup(argv[2]) : g_strdup_printf("%s.idx", input);
+  int rc = 1;
+  GError *error = NULL;
+  SplashIndex *idx = NULL;
+  GMappedFile *map = g_mapped_file_new(input, FALSE, &error);
+  if (!map) {
+    fprintf(stderr, "Failed to map '%s': %s\n", input, error->message);
+    goto out;
+  }
+  const guint8 *data = (const guint8*)g_mapped_file_get_contents(map);
+  gsize len = g_mapped_file_get_length(map);
+  idx = splash_index_build(data, len, 0, NULL);
+  if (!idx) {
+    fprintf(stderr, "No H.265 access units found in '%s'\n", input);
+    goto out;
+  }
+  if (!splash_index_save(idx, output, input, data, len, &error)) {
+    fprintf(stderr, "Failed to write '%s': %s\n", output, error->message);
+    goto out;
+  }
+  printf("%s: %u access units, %u parameter sets\n", output, idx->n_aus, idx->n_ps);
+  rc = 0;
+out:
+  g_clear_error(&error);
+  splash_index_free(idx);
+  if (map) g_mapped_file_unref(map);
+  g_free(output);
+  return rc;
+}
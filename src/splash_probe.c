@@ -0,0 +1,295 @@
+// Asset analysis for a splash_main configuration: per-sequence frame sizes,
+// bitrate and RTP packet counts, parameter-set placement, and validation of
+// the [sequence] ranges against the input's frame index.
+//
+//   ./splash_probe [--mtu=BYTES] [--aggregate=MODE] [--frames] <config.ini>
+//
+// Exits with 1 when a sequence is out of range or does not start on an IRAP
+// frame, so it can gate deployments.
+
+#include "splashconf.h"
+#include "splashdecomp.h"
+#include "splashembed.h"
+#include "splashindex.h"
+#include "splashrtp.h"
+#include "splashscan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MTU 1200 // the sender's default (stream.mtu)
+
+typedef struct {
+  guint nals;
+  guint packets;
+} AuPackets;
+
+// Packets the sender emits for one AU, counted with the packetizer that
+// offline renders use (it follows rtph265pay's layout).
+static AuPackets au_packets(SplashRtp *rtp, const guint8 *au, gsize len){
+  AuPackets r = { 0, 0 };
+  r.packets = splash_rtp_packetize(rtp, au, len, 0, NULL, NULL, &r.nals);
+  return r;
+}
+
+static const char* aggregate_name(SplashAggregateMode mode){
+  switch (mode) {
+    case SPLASH_AGGREGATE_NONE: return "none";
+    case SPLASH_AGGREGATE_MAX:  return "max";
+    default:                    return "zero-latency";
+  }
+}
+
+static const char* vcl_name(guint8 t){
+  switch (t) {
+    case 16: case 17: case 18: return "BLA";
+    case 19: case 20:          return "IDR";
+    case 21:                   return "CRA";
+    case 0xff:                 return "-";
+  }
+  return t < 16 ? "P/B" : "RSV";
+}
+
+static void ps_flags(guint16 flags, char out[4]){
+  out[0] = (flags & SPLASH_AU_HAS_VPS) ? 'V' : '-';
+  out[1] = (flags & SPLASH_AU_HAS_SPS) ? 'S' : '-';
+  out[2] = (flags & SPLASH_AU_HAS_PPS) ? 'P' : '-';
+  out[3] = '\0';
+}
+
+static void usage(const char *p){
+  fprintf(stderr,
+    "Usage:\n"
+    "  %s [--mtu=BYTES] [--aggregate=MODE] [--frames] <config.ini>\n\n"
+    "Reads the same configuration as splash_main and reports, per [sequence],\n"
+    "frame counts and sizes, mean and peak bitrate and RTP packets per frame,\n"
+    "plus parameter-set placement in the input. Fails when a sequence lies\n"
+    "outside the input or does not start on an IRAP frame.\n\n"
+    "Options:\n"
+    "  --mtu=BYTES       RTP packet size for packet counts (default: stream.mtu,\n"
+    "                    or %d when unset or auto).\n"
+    "  --aggregate=MODE  zero-latency, none or max (default: stream.aggregate).\n"
+    "  --frames          Also list every frame of every sequence.\n",
+    p, DEFAULT_MTU);
+}
+
+int main(int argc, char **argv){
+  guint mtu = 0;
+  const char *aggregate = NULL;
+  gboolean list_frames = FALSE;
+  const char *config_path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (g_str_has_prefix(argv[i], "--mtu=")) {
+      const char *num = argv[i] + strlen("--mtu=");
+      gchar *endptr = NULL;
+      guint64 v = g_ascii_strtoull(num, &endptr, 10);
+      if (!num[0] || *endptr || v < 64 || v > 65507) {
+        fprintf(stderr, "Invalid --mtu value: %s\n", num);
+        return 2;
+      }
+      mtu = (guint)v;
+    } else if (g_str_has_prefix(argv[i], "--aggregate=")) {
+      aggregate = argv[i] + strlen("--aggregate=");
+    } else if (!strcmp(argv[i], "--frames")) {
+      list_frames = TRUE;
+    } else if (argv[i][0] == '-' || config_path) {
+      usage(argv[0]);
+      return 2;
+    } else {
+      config_path = argv[i];
+    }
+  }
+  if (!config_path) { usage(argv[0]); return 2; }
+
+  SplashConfig cfg = {0};
+  SplashSeq *seqs = NULL;
+  int n_seqs = 0;
+  ComboSeq *combos = NULL;
+  int n_combos = 0;
+  GPtrArray *owned_strings = NULL;
+  if (!splash_conf_load(config_path, &cfg, &seqs, &n_seqs, &combos, &n_combos,
+                        &owned_strings, NULL, NULL)) {
+    return 1;
+  }
+  if (aggregate) {
+    if (!g_ascii_strcasecmp(aggregate, "none")) cfg.aggregate = SPLASH_AGGREGATE_NONE;
+    else if (!g_ascii_strcasecmp(aggregate, "max")) cfg.aggregate = SPLASH_AGGREGATE_MAX;
+    else if (!g_ascii_strcasecmp(aggregate, "zero-latency")) cfg.aggregate = SPLASH_AGGREGATE_ZERO_LATENCY;
+    else {
+      fprintf(stderr, "Invalid --aggregate value: %s\n", aggregate);
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (mtu == 0) mtu = cfg.mtu > 0 ? (guint)cfg.mtu : DEFAULT_MTU;
+  SplashRtp *rtp = splash_rtp_new(mtu, (guint8)cfg.payload_type, cfg.aggregate, 0, 0, 0);
+
+  int rc = 1;
+  GError *error = NULL;
+  GBytes *plain = NULL;
+  SplashIndex *idx = NULL;
+  GMappedFile *map = NULL;
+  const guint8 *data, *blob;
+  gsize len, blob_len;
+  if (g_str_has_prefix(cfg.input_path, SPLASH_EMBEDDED_PREFIX)) {
+    if (!splash_embedded_asset(&data, &len, &blob, &blob_len)) {
+      fprintf(stderr, "No asset embedded in this build\n");
+      goto out;
+    }
+  } else {
+    map = g_mapped_file_new(cfg.input_path, FALSE, &error);
+    if (!map) {
+      fprintf(stderr, "Failed to map '%s': %s\n", cfg.input_path, error->message);
+      g_error_free(error);
+      goto out;
+    }
+    data = (const guint8*)g_mapped_file_get_contents(map);
+    len = g_mapped_file_get_length(map);
+  }
+  gsize file_len = len;
+  SplashCompression kind = splash_detect_compression(data, len);
+  if (kind != SPLASH_COMPRESSION_NONE) {
+    plain = splash_decompress(data, len, kind, (guint)cfg.decompress_threads, NULL, &error);
+    if (!plain) {
+      fprintf(stderr, "Failed to decompress '%s': %s\n", cfg.input_path,
+              error ? error->message : "unknown error");
+      g_clear_error(&error);
+      goto out;
+    }
+    data = g_bytes_get_data(plain, &len);
+  }
+
+  gint64 t0 = g_get_monotonic_time();
+  guint scan_threads = 0;
+  idx = splash_index_build(data, len, (guint)cfg.index_threads, &scan_threads);
+  gint64 scan_us = g_get_monotonic_time() - t0;
+  if (!idx) {
+    fprintf(stderr, "No H.265 access units found in '%s'\n", cfg.input_path);
+    goto out;
+  }
+
+  // ---- Input summary and parameter-set placement ----
+  guint irap = 0, ps_aus = 0, irap_without_ps = 0, ps_gap_max = 0;
+  gint last_ps = -1;
+  for (guint i = 0; i < idx->n_aus; ++i) {
+    const SplashAuEntry *au = &idx->aus[i];
+    if (au->flags & SPLASH_AU_IRAP) irap++;
+    if (au->ps_count > 0) {
+      if (last_ps >= 0) ps_gap_max = MAX(ps_gap_max, i - (guint)last_ps);
+      last_ps = (gint)i;
+      ps_aus++;
+    } else if (au->flags & SPLASH_AU_IRAP) {
+      irap_without_ps++;
+    }
+  }
+  printf("Input: %s\n", cfg.input_path);
+  printf("  %" G_GSIZE_FORMAT " bytes", file_len);
+  if (plain) printf(" (%" G_GSIZE_FORMAT " decompressed)", len);
+  printf(", %u frames at %.3f fps = %.2f s, scanned in %.1f ms (%s, %u thread(s))\n",
+         idx->n_aus, cfg.fps, cfg.fps > 0 ? idx->n_aus / cfg.fps : 0.0,
+         scan_us / 1000.0, splash_scan_impl_name(splash_scan_get_impl()), scan_threads);
+  printf("  IRAP frames: %u, parameter sets: %u NALs in %u frames",
+         irap, idx->n_ps, ps_aus);
+  if (ps_aus > 1) printf(" (largest gap %u frames)", ps_gap_max);
+  printf("\n");
+  if (irap_without_ps > 0) {
+    printf("  %u IRAP frame(s) carry no VPS/SPS/PPS%s\n", irap_without_ps,
+           cfg.index_mode == SPLASH_INDEX_OFF ? "" : " (injected from the index at runtime)");
+  }
+  printf("  Packets counted at mtu=%u, aggregate=%s\n\n", mtu, aggregate_name(cfg.aggregate));
+
+  // ---- Per sequence ----
+  guint window = MAX(1, (guint)(cfg.fps + 0.5));
+  int errors = 0;
+  printf("%-16s %11s %6s %8s %8s %8s %9s %9s %10s %5s %5s %s\n",
+         "sequence", "frames", "count", "min B", "mean B", "max B",
+         "mean kbps", "peak kbps", "burst kbps", "pkt/f", "max", "start");
+  for (int s = 0; s < n_seqs; ++s) {
+    const SplashSeq *sq = &seqs[s];
+    gchar *range = g_strdup_printf("%d-%d", sq->start_frame, sq->end_frame);
+    if (sq->start_frame < 0 || (guint)sq->end_frame >= idx->n_aus) {
+      printf("%-16s %11s  ERROR: outside the input (frames 0-%u)\n",
+             sq->name, range, idx->n_aus - 1);
+      g_free(range);
+      errors++;
+      continue;
+    }
+    guint first = (guint)sq->start_frame, last = (guint)sq->end_frame;
+    guint count = last - first + 1;
+    guint64 total = 0, win = 0, win_max = 0;
+    guint32 min_b = G_MAXUINT32, max_b = 0;
+    guint64 packets = 0;
+    guint max_packets = 0;
+    for (guint f = first; f <= last; ++f) {
+      const SplashAuEntry *au = &idx->aus[f];
+      total += au->size;
+      min_b = MIN(min_b, au->size);
+      max_b = MAX(max_b, au->size);
+      win += au->size;
+      if (f >= first + window) win -= idx->aus[f - window].size;
+      if (f + 1 >= first + window) win_max = MAX(win_max, win);
+      AuPackets ap = au_packets(rtp, data + au->offset, au->size);
+      packets += ap.packets;
+      max_packets = MAX(max_packets, ap.packets);
+    }
+    if (count < window) win_max = total * window / count; // shorter than a second
+    const SplashAuEntry *head = &idx->aus[first];
+    char ps[4];
+    ps_flags(head->flags, ps);
+    printf("%-16s %11s %6u %8u %8" G_GUINT64_FORMAT " %8u %9.0f %9.0f %10.0f %5.1f %5u %s %s",
+           sq->name, range, count, min_b, total / count, max_b,
+           total * 8.0 * cfg.fps / count / 1000.0,
+           win_max * 8.0 * cfg.fps / window / 1000.0,
+           max_b * 8.0 * cfg.fps / 1000.0,
+           (double)packets / count, max_packets, vcl_name(head->vcl_type), ps);
+    if (!(head->flags & SPLASH_AU_IRAP)) {
+      printf("  ERROR: does not start on an IRAP frame");
+      errors++;
+    } else if (head->ps_count == 0 && cfg.index_mode == SPLASH_INDEX_OFF) {
+      printf("  WARNING: no parameter sets at the start (index=off does not inject them)");
+    }
+    printf("\n");
+    g_free(range);
+  }
+
+  for (int c = 0; c < n_combos; ++c) {
+    guint frames = 0;
+    for (int k = 0; k < combos[c].count; ++k) {
+      const SplashSeq *sq = &seqs[combos[c].indices[k]];
+      frames += (guint)(sq->end_frame - sq->start_frame + 1);
+    }
+    printf("combo %-10s %u parts, %u frames = %.2f s%s\n", combos[c].name,
+           combos[c].count, frames, cfg.fps > 0 ? frames / cfg.fps : 0.0,
+           combos[c].loop_at_end ? ", loops" : "");
+  }
+
+  if (list_frames) {
+    for (int s = 0; s < n_seqs; ++s) {
+      const SplashSeq *sq = &seqs[s];
+      if (sq->start_frame < 0 || (guint)sq->end_frame >= idx->n_aus) continue;
+      printf("\n[%s]\n%8s %12s %8s %5s %7s %-4s %s\n", sq->name,
+             "frame", "offset", "bytes", "nals", "packets", "type", "ps");
+      for (guint f = (guint)sq->start_frame; f <= (guint)sq->end_frame; ++f) {
+        const SplashAuEntry *au = &idx->aus[f];
+        AuPackets ap = au_packets(rtp, data + au->offset, au->size);
+        char ps[4];
+        ps_flags(au->flags, ps);
+        printf("%8u %12" G_GUINT64_FORMAT " %8u %5u %7u %-4s %s\n", f, au->offset,
+               au->size, ap.nals, ap.packets, vcl_name(au->vcl_type), ps);
+      }
+    }
+  }
+
+  if (errors) fprintf(stderr, "\n%d sequence error(s)\n", errors);
+  rc = errors ? 1 : 0;
+
+out:
+  splash_rtp_free(rtp);
+  splash_index_free(idx);
+  if (plain) g_bytes_unref(plain);
+  if (map) g_mapped_file_unref(map);
+  g_free(seqs);
+  splash_conf_free_combos(combos, n_combos);
+  g_ptr_array_free(owned_strings, TRUE);
+  return rc;
+}
@@ -0,0 +1,781 @@
+// Loopback receiver for the UDP output: depacketizes the RTP stream and
+// reports latency (from the latency_sei probes), interarrival jitter, packet
+// loss and frame continuity, including across sequence switches. With --nack
+// it asks the sender (stream.rtx_history) to retransmit lost packets and
+// reports how many came back and how fast; with --fec it rebuilds lost
+// packets from the sender's repair packets (stream.fec). --loss drops
+// received packets on purpose to exercise both.
+//
+//   ./splash_rx [--port=N] [--bind=ADDR] [--interval=MS] [--duration=S]
+//               [--max-latency=MS] [--pt=N] [--nack] [--rtx-pt=N] [--rtx-wait=MS]
+//               [--fec] [--fec-pt=N] [--loss=PCT] [--json]
+//
+// Exits with 1 when packets or frames went missing, no probe arrived, or the
+// worst latency exceeded --max-latency, so it can gate latency work.
+
+#include "splashfec.h"
+#include "splashrtp.h"
+#include "splashsei.h"
+#include <gio/gio.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#define DEFAULT_PORT        5600 // the sender's default (stream.port)
+#define DEFAULT_INTERVAL_MS 1000
+#define RTP_CLOCK_HZ        90000
+#define RCVBUF_BYTES        (4 << 20)
+#define MAX_DATAGRAM        65536
+#define DEFAULT_RTX_WAIT_MS 50
+#define REORDER_SLOTS       1024 // packets held while waiting for retransmissions
+#define EXPIRE_TICK_MS      5
+#define RTCP_PT_RR          201
+#define RTCP_PT_RTPFB       205
+#define RTCP_FMT_NACK       1
+#define OSN_BYTES           2
+#define SENDER_PT           97   // the sender's default (stream.payload_type)
+#define LATCH_PATIENCE      64   // packets on a default RTX/FEC type before taking it as media
+
+typedef struct {
+  GArray *lat_us;        // gint64 latency samples
+  guint64 frames;        // AUs received
+  guint64 incomplete;    // AUs with lost packets
+  guint64 no_probe;      // AUs without a latency probe
+  guint64 missing;       // frames the probe counter skipped
+} Window;
+
+// A reorder-buffer slot: a packet held until the ones before it arrived or
+// were given up, or a packet noticed missing.
+typedef struct {
+  guint8 *data;
+  gsize len;
+  gsize alloc;
+  gboolean held;
+  gint64 missing_us;     // when its absence was noticed and NACKed, 0 = not missing
+} Pending;
+
+// Where a packet handed to the reorder buffer came from.
+typedef enum {
+  FROM_MEDIA,
+  FROM_RTX,              // a retransmission, restored
+  FROM_FEC,              // rebuilt from repair packets
+} Origin;
+
+typedef struct {
+  GMainLoop *loop;
+  SplashRtpDepay *depay;
+  gboolean json;
+  gint64 t0_us;
+
+  // RTP (RFC 3550 A.1 / A.8)
+  gboolean have_ssrc;
+  guint32 ssrc;
+  guint32 base_seq;
+  guint32 cycles;
+  guint16 max_seq;
+  guint64 ssrc_packets;  // received from the current SSRC
+  guint64 lost_before;   // lost from earlier SSRCs
+  guint64 packets;
+  guint64 ssrc_changes;
+  double jitter;         // in RTP clock units
+  gboolean have_transit;
+  gint64 transit;
+
+  // Frames
+  gboolean have_probe;
+  SplashLatencyProbe last;
+  gint64 last_au_us;     // monotonic arrival of the previous AU
+  guint64 restarts;      // probe counter went back (sender restarted)
+  guint64 reordered;
+  guint64 switches;
+  gint64 switch_gap_max_us;
+  Window total;
+  Window win;
+
+  // Retransmission (RFC 4588 / RFC 4585 generic NACK)
+  gboolean nack;
+  guint rtx_pt;          // 0 = media payload type + 1
+  gint64 rtx_wait_us;    // how long a missing packet holds back the ones after it
+  double loss;           // injected loss probability
+  GSocket *sock;
+  GSocketAddress *source; // where the RTP packets come from, NACKs go back there
+  guint32 rtcp_ssrc;
+  gboolean have_media_pt;
+  guint8 media_pt;       // --pt, or latched from the stream
+  guint latch_skipped;   // packets passed over while latching media_pt
+  Pending pending[REORDER_SLOTS];
+  gboolean have_next;
+  guint16 next_seq;      // next packet for the depayloader
+  guint16 end_seq;       // one past the highest packet seen
+  guint held;
+  GHashTable *repaired_ts; // RTP timestamps of AUs with a retransmitted or rebuilt packet
+  GArray *repair_us;     // NACK to retransmission arrival
+  guint64 injected;      // packets dropped by --loss
+  guint64 nacked;
+  guint64 recovered;
+  guint64 unrepaired;    // given up after --rtx-wait
+  guint64 rtx_late;      // retransmissions of packets already released
+  guint64 repaired_frames;
+
+  // Forward error correction
+  gboolean fec;
+  guint fec_pt;          // 0 = media payload type + 2
+  SplashFecDec *fec_dec;
+  guint64 fec_packets;   // repair packets received
+  guint64 fec_recovered;
+} Rx;
+
+static void window_init(Window *w){
+  memset(w, 0, sizeof(*w));
+  w->lat_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+}
+
+static void window_clear(Window *w){
+  g_array_set_size(w->lat_us, 0);
+  w->frames = w->incomplete = w->no_probe = w->missing = 0;
+}
+
+static int cmp_i64(gconstpointer a, gconstpointer b){
+  gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+  return x < y ? -1 : x > y;
+}
+
+typedef struct {
+  double avg, p50, p95, p99, min, max;  // ms
+} LatencySummary;
+
+static LatencySummary summarize(GArray *lat_us){
+  LatencySummary s = { 0 };
+  guint n = lat_us->len;
+  if (n == 0) return s;
+  g_array_sort(lat_us, cmp_i64);
+  gint64 *v = (gint64*)(void*)lat_us->data;
+  double sum = 0;
+  for (guint i = 0; i < n; ++i) sum += (double)v[i];
+  s.avg = sum / n / 1000.0;
+  s.p50 = v[(n - 1) * 50 / 100] / 1000.0;
+  s.p95 = v[(n - 1) * 95 / 100] / 1000.0;
+  s.p99 = v[(n - 1) * 99 / 100] / 1000.0;
+  s.min = v[0] / 1000.0;
+  s.max = v[n - 1] / 1000.0;
+  return s;
+}
+
+static guint64 packets_expected(const Rx *rx){
+  if (!rx->have_ssrc) return 0;
+  return (guint64)rx->cycles + rx->max_seq - rx->base_seq + 1;
+}
+
+static guint64 packets_lost(const Rx *rx){
+  guint64 expected = packets_expected(rx);
+  return rx->lost_before + (expected > rx->ssrc_packets ? expected - rx->ssrc_packets : 0);
+}
+
+static void count_packet(Rx *rx, const SplashRtpHeader *h, gboolean retransmitted,
+                         gint64 now_us){
+  if (!rx->have_ssrc || h->ssrc != rx->ssrc) {
+    if (rx->have_ssrc) {
+      rx->ssrc_changes++;
+      printf("new SSRC %08x (was %08x): sender restarted\n", h->ssrc, rx->ssrc);
+      rx->lost_before = packets_lost(rx);
+    }
+    rx->have_ssrc = TRUE;
+    rx->ssrc = h->ssrc;
+    rx->base_seq = h->seq;
+    rx->max_seq = h->seq;
+    rx->cycles = 0;
+    rx->ssrc_packets = 0;
+    rx->have_transit = FALSE;
+  } else {
+    guint16 delta = (guint16)(h->seq - rx->max_seq);
+    if (delta > 0 && delta < 0x8000) {
+      if (h->seq < rx->max_seq) rx->cycles += 1u << 16;
+      rx->max_seq = h->seq;
+    }
+  }
+  rx->ssrc_packets++;
+  rx->packets++;
+  if (retransmitted) return;
+
+  gint64 arrival = now_us * RTP_CLOCK_HZ / G_USEC_PER_SEC;
+  gint64 transit = arrival - (gint64)h->ts;
+  if (rx->have_transit) {
+    gint64 d = ABS(transit - rx->transit);
+    rx->jitter += ((double)d - rx->jitter) / 16.0;
+  }
+  rx->transit = transit;
+  rx->have_transit = TRUE;
+}
+
+static void on_au(const guint8 *au, gsize len, guint32 rtp_ts, gboolean complete, gpointer user){
+  Rx *rx = (Rx*)user;
+  if (g_hash_table_remove(rx->repaired_ts, GUINT_TO_POINTER(rtp_ts)) && complete) {
+    rx->repaired_frames++;
+  }
+  gint64 now_real = g_get_real_time();
+  gint64 now_us = g_get_monotonic_time();
+  Window *ws[2] = { &rx->total, &rx->win };
+  for (int i = 0; i < 2; ++i) {
+    ws[i]->frames++;
+    if (!complete) ws[i]->incomplete++;
+  }
+
+  SplashLatencyProbe p;
+  if (!splash_sei_find_probe(au, len, &p)) {
+    for (int i = 0; i < 2; ++i) ws[i]->no_probe++;
+    rx->last_au_us = now_us;
+    return;
+  }
+  gint64 lat = now_real - p.send_us;
+  for (int i = 0; i < 2; ++i) g_array_append_val(ws[i]->lat_us, lat);
+
+  if (rx->have_probe) {
+    guint64 skipped = 0;
+    if (p.frame > rx->last.frame) {
+      skipped = p.frame - rx->last.frame - 1;
+    } else if (p.frame == 0 || p.switches < rx->last.switches) {
+      rx->restarts++;
+      printf("frame counter restarted at sequence %u: sender restarted\n", p.seq);
+    } else {
+      rx->reordered++;
+    }
+    for (int i = 0; i < 2; ++i) ws[i]->missing += skipped;
+    if (p.switches != rx->last.switches && p.frame > rx->last.frame) {
+      gint64 gap = now_us - rx->last_au_us;
+      double pts_step = ((gint64)p.pts - (gint64)rx->last.pts) / 1e6;
+      rx->switches++;
+      if (gap > rx->switch_gap_max_us) rx->switch_gap_max_us = gap;
+      printf("switch: sequence %u -> %u at frame %" G_GUINT64_FORMAT
+             " (arrival gap %.1f ms, pts step %.1f ms, %" G_GUINT64_FORMAT " frame(s) missing)\n",
+             rx->last.seq, p.seq, p.frame, gap / 1000.0, pts_step, skipped);
+    } else if (skipped > 0) {
+      printf("gap: %" G_GUINT64_FORMAT " frame(s) missing before frame %" G_GUINT64_FORMAT "\n",
+             skipped, p.frame);
+    }
+  }
+  rx->last = p;
+  rx->have_probe = TRUE;
+  rx->last_au_us = now_us;
+}
+
+static void put_be32(guint8 *p, guint32 v){
+  p[0] = (guint8)(v >> 24);
+  p[1] = (guint8)(v >> 16);
+  p[2] = (guint8)(v >> 8);
+  p[3] = (guint8)v;
+}
+
+// Sends an empty receiver report and a generic NACK for seqs (ascending,
+// within 1024 of each other), one PID + BLP entry per 17 packets at most.
+static void send_nack(Rx *rx, const guint16 *seqs, guint n){
+  if (n == 0 || !rx->nack || !rx->source) return;
+  guint8 pkt[8 + 12 + 4 * REORDER_SLOTS];
+  guint8 *q = pkt;
+  q[0] = 0x80;
+  q[1] = RTCP_PT_RR;
+  q[2] = 0;
+  q[3] = 1;
+  put_be32(q + 4, rx->rtcp_ssrc);
+  q += 8;
+  guint8 *fb = q;
+  fb[0] = 0x80 | RTCP_FMT_NACK;
+  fb[1] = RTCP_PT_RTPFB;
+  put_be32(fb + 4, rx->rtcp_ssrc);
+  put_be32(fb + 8, rx->ssrc);
+  q += 12;
+  for (guint i = 0; i < n;) {
+    guint16 pid = seqs[i++];
+    guint16 blp = 0;
+    while (i < n && (guint16)(seqs[i] - pid) <= 16) {
+      blp |= (guint16)(1u << ((guint16)(seqs[i] - pid) - 1));
+      i++;
+    }
+    q[0] = (guint8)(pid >> 8);
+    q[1] = (guint8)pid;
+    q[2] = (guint8)(blp >> 8);
+    q[3] = (guint8)blp;
+    q += 4;
+  }
+  gsize words = (gsize)(q - fb) / 4 - 1;
+  fb[2] = (guint8)(words >> 8);
+  fb[3] = (guint8)words;
+  g_socket_send_to(rx->sock, rx->source, (const gchar*)pkt, (gsize)(q - pkt), NULL, NULL);
+  rx->nacked += n;
+}
+
+static Pending* pending_at(Rx *rx, guint16 seq){
+  return &rx->pending[seq & (REORDER_SLOTS - 1)];
+}
+
+// Hands held packets to the depayloader in sequence order, up to the first
+// one still missing.
+static void drain(Rx *rx){
+  for (Pending *p = pending_at(rx, rx->next_seq); p->held; p = pending_at(rx, rx->next_seq)) {
+    splash_rtp_depay_push(rx->depay, p->data, p->len);
+    p->held = FALSE;
+    rx->held--;
+    rx->next_seq++;
+  }
+}
+
+// Moves past next_seq: released when held, otherwise given up on, so the
+// depayloader sees the gap.
+static void advance(Rx *rx){
+  Pending *p = pending_at(rx, rx->next_seq);
+  if (p->held) {
+    splash_rtp_depay_push(rx->depay, p->data, p->len);
+    p->held = FALSE;
+    rx->held--;
+  } else if (p->missing_us) {
+    rx->unrepaired++;
+  }
+  p->missing_us = 0;
+  rx->next_seq++;
+}
+
+static void flush_pending(Rx *rx){
+  while (rx->held > 0) advance(rx);
+  for (guint i = 0; i < REORDER_SLOTS; ++i) rx->pending[i].missing_us = 0;
+  rx->have_next = FALSE;
+}
+
+// Gives up on missing packets that waited --rtx-wait.
+static void expire(Rx *rx, gint64 now_us){
+  while (rx->held > 0) {
+    Pending *p = pending_at(rx, rx->next_seq);
+    if (p->missing_us && now_us - p->missing_us < rx->rtx_wait_us) break;
+    advance(rx);
+    drain(rx);
+  }
+}
+
+// Reorder buffer in front of the depayloader: packets after a gap wait for
+// its retransmission or FEC repair, and the gap is NACKed as soon as it is seen.
+static void reorder_push(Rx *rx, const guint8 *pkt, gsize len, const SplashRtpHeader *h,
+                         Origin origin, gint64 now_us){
+  gboolean retransmitted = origin == FROM_RTX;
+  guint16 seq = h->seq;
+  if (!rx->have_next) {
+    rx->next_seq = rx->end_seq = seq;
+    rx->have_next = TRUE;
+  }
+  if ((guint16)(seq - rx->next_seq) >= 0x8000) {
+    if (retransmitted) rx->rtx_late++;
+    return;
+  }
+  while ((guint16)(seq - rx->next_seq) >= REORDER_SLOTS) advance(rx);
+  if ((guint16)(rx->end_seq - rx->next_seq) >= 0x8000) rx->end_seq = rx->next_seq;
+
+  Pending *p = pending_at(rx, seq);
+  if (p->held) {
+    if (retransmitted) rx->rtx_late++;
+    return;
+  }
+  if (retransmitted && p->missing_us) {
+    gint64 repair = now_us - p->missing_us;
+    g_array_append_val(rx->repair_us, repair);
+    rx->recovered++;
+    g_hash_table_add(rx->repaired_ts, GUINT_TO_POINTER(h->ts));
+  } else if (origin == FROM_FEC) {
+    rx->fec_recovered++;
+    g_hash_table_add(rx->repaired_ts, GUINT_TO_POINTER(h->ts));
+  }
+  if (p->alloc < len) {
+    p->data = g_realloc(p->data, len);
+    p->alloc = len;
+  }
+  memcpy(p->data, pkt, len);
+  p->len = len;
+  p->held = TRUE;
+  p->missing_us = 0;
+  rx->held++;
+
+  guint16 lost[REORDER_SLOTS];
+  guint n = 0;
+  if ((guint16)(seq - rx->end_seq) < 0x8000) {
+    for (guint16 s = rx->end_seq; s != seq; ++s) {
+      pending_at(rx, s)->missing_us = now_us;
+      lost[n++] = s;
+    }
+    rx->end_seq = (guint16)(seq + 1);
+  }
+  drain(rx);
+  send_nack(rx, lost, n);
+  expire(rx, now_us);
+}
+
+// Turns a retransmission back into the packet it repairs (RFC 4588 section 4):
+// sequence number from the OSN, media payload type and SSRC. Returns its
+// length, or 0 when pkt is too short.
+static gsize restore_rtx(Rx *rx, guint8 *pkt, const SplashRtpHeader *h){
+  if (h->payload_len < OSN_BYTES) return 0;
+  guint8 *payload = pkt + h->payload;
+  guint8 osn[OSN_BYTES] = { payload[0], payload[1] };
+  memmove(payload, payload + OSN_BYTES, h->payload_len - OSN_BYTES);
+  pkt[0] &= ~0x20;  // padding dropped
+  pkt[1] = (guint8)((pkt[1] & 0x80) | rx->media_pt);
+  pkt[2] = osn[0];
+  pkt[3] = osn[1];
+  put_be32(pkt + 8, rx->ssrc);
+  return h->payload + h->payload_len - OSN_BYTES;
+}
+
+static void on_fec_packet(const guint8 *pkt, gsize len, gpointer user){
+  Rx *rx = (Rx*)user;
+  SplashRtpHeader h;
+  if (!splash_rtp_parse_header(pkt, len, &h) || !rx->have_ssrc || h.ssrc != rx->ssrc) return;
+  gint64 now_us = g_get_monotonic_time();
+  count_packet(rx, &h, TRUE, now_us);
+  reorder_push(rx, pkt, len, &h, FROM_FEC, now_us);
+}
+
+// Same defaults as the sender: the next dynamic payload types, wrapping to 96
+static guint default_rtx_pt(guint media_pt){
+  return media_pt < 127 ? media_pt + 1u : 96u;
+}
+
+static guint default_fec_pt(guint media_pt){
+  return media_pt < 126 ? media_pt + 2u : media_pt - 30u;
+}
+
+// Takes the media payload type from the first packet that is not on the
+// retransmission or repair type, so joining right before a repair packet
+// does not mistake its SSRC for the media. Without --rtx-pt/--fec-pt those
+// are the sender's defaults; a sender using one of them for media is still
+// picked up after LATCH_PATIENCE packets carrying nothing else.
+static gboolean latch_media_pt(Rx *rx, const SplashRtpHeader *h){
+  if ((rx->rtx_pt && h->pt == rx->rtx_pt) || (rx->fec_pt && h->pt == rx->fec_pt)) return FALSE;
+  gboolean defaults = (!rx->rtx_pt && h->pt == default_rtx_pt(SENDER_PT)) ||
+                      (!rx->fec_pt && h->pt == default_fec_pt(SENDER_PT));
+  if (defaults && ++rx->latch_skipped < LATCH_PATIENCE) return FALSE;
+  rx->media_pt = h->pt;
+  rx->have_media_pt = TRUE;
+  return TRUE;
+}
+
+static gboolean on_readable(GSocket *sock, GIOCondition cond, gpointer user){
+  (void)cond;
+  Rx *rx = (Rx*)user;
+  guint8 buf[MAX_DATAGRAM];
+  for (;;) {
+    GError *err = NULL;
+    GSocketAddress *from = NULL;
+    gssize n = g_socket_receive_from(sock, rx->nack ? &from : NULL, (gchar*)buf, sizeof(buf),
+                                     NULL, &err);
+    if (n < 0) {
+      gboolean again = g_error_matches(err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+      if (!again) fprintf(stderr, "receive failed: %s\n", err->message);
+      g_error_free(err);
+      return again ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+    }
+    SplashRtpHeader h;
+    gboolean drop = !splash_rtp_parse_header(buf, (gsize)n, &h);
+    if (!drop && rx->loss > 0 && g_random_double() < rx->loss) {
+      rx->injected++;
+      drop = TRUE;
+    }
+    if (!drop && !rx->have_media_pt) drop = !latch_media_pt(rx, &h);
+    if (drop) {
+      if (from) g_object_unref(from);
+      continue;
+    }
+    guint rtx_pt = rx->rtx_pt ? rx->rtx_pt : default_rtx_pt(rx->media_pt);
+    guint fec_pt = rx->fec_pt ? rx->fec_pt : default_fec_pt(rx->media_pt);
+    gboolean other_ssrc = h.pt != rx->media_pt && (!rx->have_ssrc || h.ssrc != rx->ssrc);
+    gboolean retransmitted = other_ssrc && h.pt == rtx_pt;
+    if (other_ssrc && h.pt == fec_pt) {
+      if (from) g_object_unref(from);
+      if (rx->fec) {
+        rx->fec_packets++;
+        splash_fec_dec_add_repair(rx->fec_dec, buf, (gsize)n, on_fec_packet, rx);
+      }
+      continue;
+    }
+    if (retransmitted) {
+      gsize len = rx->nack ? restore_rtx(rx, buf, &h) : 0;
+      if (from) g_object_unref(from);
+      if (len == 0 || !splash_rtp_parse_header(buf, len, &h)) continue;
+      n = (gssize)len;
+    } else if (from) {
+      if (rx->source) g_object_unref(rx->source);
+      rx->source = from;
+    }
+    gint64 now_us = g_get_monotonic_time();
+    gboolean reorder = rx->nack || rx->fec;
+    if (reorder && rx->have_ssrc && h.ssrc != rx->ssrc) flush_pending(rx);
+    count_packet(rx, &h, retransmitted, now_us);
+    if (rx->fec) splash_fec_dec_add_source(rx->fec_dec, buf, (gsize)n);
+    if (reorder) {
+      reorder_push(rx, buf, (gsize)n, &h, retransmitted ? FROM_RTX : FROM_MEDIA, now_us);
+    } else {
+      splash_rtp_depay_push(rx->depay, buf, (gsize)n);
+    }
+  }
+}
+
+static gboolean on_expire(gpointer user){
+  Rx *rx = (Rx*)user;
+  expire(rx, g_get_monotonic_time());
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_interval(gpointer user){
+  Rx *rx = (Rx*)user;
+  LatencySummary l = summarize(rx->win.lat_us);
+  printf("t=%.1fs frames=%" G_GUINT64_FORMAT " latency avg %.2f p95 %.2f max %.2f ms"
+         " | jitter %.2f ms | lost %" G_GUINT64_FORMAT " pkts | missing %" G_GUINT64_FORMAT
+         " | incomplete %" G_GUINT64_FORMAT "%s\n",
+         (g_get_monotonic_time() - rx->t0_us) / 1e6, rx->win.frames, l.avg, l.p95, l.max,
+         rx->jitter * 1000.0 / RTP_CLOCK_HZ, packets_lost(rx), rx->win.missing,
+         rx->win.incomplete, rx->win.no_probe ? " (frames without probe)" : "");
+  if (rx->nack) {
+    printf("  rtx: %" G_GUINT64_FORMAT " nacked, %" G_GUINT64_FORMAT " recovered, %" G_GUINT64_FORMAT
+           " given up, %" G_GUINT64_FORMAT " frame(s) repaired\n",
+           rx->nacked, rx->recovered, rx->unrepaired, rx->repaired_frames);
+  }
+  if (rx->fec) {
+    printf("  fec: %" G_GUINT64_FORMAT " repair packets, %" G_GUINT64_FORMAT " recovered, %"
+           G_GUINT64_FORMAT " given up, %" G_GUINT64_FORMAT " frame(s) repaired\n",
+           rx->fec_packets, rx->fec_recovered, rx->unrepaired, rx->repaired_frames);
+  }
+  fflush(stdout);
+  window_clear(&rx->win);
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_quit(gpointer user){
+  g_main_loop_quit(((Rx*)user)->loop);
+  return G_SOURCE_REMOVE;
+}
+
+static void report(Rx *rx){
+  LatencySummary l = summarize(rx->total.lat_us);
+  LatencySummary r = summarize(rx->repair_us);
+  double jitter_ms = rx->jitter * 1000.0 / RTP_CLOCK_HZ;
+  if (rx->json) {
+    printf("{\"frames\":%" G_GUINT64_FORMAT ",\"probed\":%u,"
+           "\"latency_ms\":{\"avg\":%.3f,\"min\":%.3f,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"max\":%.3f},"
+           "\"jitter_ms\":%.3f,\"packets\":%" G_GUINT64_FORMAT ",\"lost\":%" G_GUINT64_FORMAT ","
+           "\"incomplete\":%" G_GUINT64_FORMAT ",\"missing\":%" G_GUINT64_FORMAT ","
+           "\"reordered\":%" G_GUINT64_FORMAT ",\"switches\":%" G_GUINT64_FORMAT ","
+           "\"switch_gap_max_ms\":%.3f,\"restarts\":%" G_GUINT64_FORMAT ","
+           "\"injected_loss\":%" G_GUINT64_FORMAT ","
+           "\"rtx\":{\"nacked\":%" G_GUINT64_FORMAT ",\"recovered\":%" G_GUINT64_FORMAT ","
+           "\"given_up\":%" G_GUINT64_FORMAT ",\"late\":%" G_GUINT64_FORMAT ","
+           "\"frames_repaired\":%" G_GUINT64_FORMAT ","
+           "\"repair_ms\":{\"avg\":%.3f,\"p95\":%.3f,\"max\":%.3f}},"
+           "\"fec\":{\"repair_packets\":%" G_GUINT64_FORMAT ",\"recovered\":%" G_GUINT64_FORMAT "}}\n",
+           rx->total.frames, rx->total.lat_us->len,
+           l.avg, l.min, l.p50, l.p95, l.p99, l.max, jitter_ms,
+           rx->packets, packets_lost(rx), rx->total.incomplete, rx->total.missing,
+           rx->reordered, rx->switches, rx->switch_gap_max_us / 1000.0,
+           rx->restarts + rx->ssrc_changes, rx->injected,
+           rx->nacked, rx->recovered, rx->unrepaired, rx->rtx_late, rx->repaired_frames,
+           r.avg, r.p95, r.max, rx->fec_packets, rx->fec_recovered);
+    return;
+  }
+  printf("\nFrames: %" G_GUINT64_FORMAT " (%u with a probe, %" G_GUINT64_FORMAT " incomplete)\n",
+         rx->total.frames, rx->total.lat_us->len, rx->total.incomplete);
+  printf("Latency: avg %.2f ms, min %.2f, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f\n",
+         l.avg, l.min, l.p50, l.p95, l.p99, l.max);
+  printf("Jitter: %.2f ms\n", jitter_ms);
+  printf("Packets: %" G_GUINT64_FORMAT " received, %" G_GUINT64_FORMAT " lost",
+         rx->packets, packets_lost(rx));
+  if (rx->injected) printf(" (%" G_GUINT64_FORMAT " dropped by --loss)", rx->injected);
+  printf("\n");
+  if (rx->nack) {
+    printf("Retransmission: %" G_GUINT64_FORMAT " packet(s) NACKed, %" G_GUINT64_FORMAT
+           " recovered (%.1f%%), %" G_GUINT64_FORMAT " given up, %" G_GUINT64_FORMAT " late;"
+           " %" G_GUINT64_FORMAT " frame(s) repaired\n",
+           rx->nacked, rx->recovered, rx->nacked ? 100.0 * rx->recovered / rx->nacked : 0.0,
+           rx->unrepaired, rx->rtx_late, rx->repaired_frames);
+    printf("Repair time: avg %.2f ms, p95 %.2f, max %.2f\n", r.avg, r.p95, r.max);
+  }
+  if (rx->fec) {
+    printf("FEC: %" G_GUINT64_FORMAT " repair packet(s), %" G_GUINT64_FORMAT " packet(s) recovered,"
+           " %" G_GUINT64_FORMAT " given up; %" G_GUINT64_FORMAT " frame(s) repaired\n",
+           rx->fec_packets, rx->fec_recovered, rx->unrepaired, rx->repaired_frames);
+  }
+  printf("Continuity: %" G_GUINT64_FORMAT " frame(s) missing, %" G_GUINT64_FORMAT
+         " reordered, %" G_GUINT64_FORMAT " switch(es) (largest gap %.1f ms), %" G_GUINT64_FORMAT
+         " restart(s)\n",
+         rx->total.missing, rx->reordered, rx->switches, rx->switch_gap_max_us / 1000.0,
+         rx->restarts + rx->ssrc_changes);
+}
+
+static void usage(const char *p){
+  fprintf(stderr,
+    "Usage:\n"
+    "  %s [--port=N] [--bind=ADDR] [--interval=MS] [--duration=S]\n"
+    "     [--max-latency=MS] [--pt=N] [--nack] [--rtx-pt=N] [--rtx-wait=MS] [--fec]\n"
+    "     [--fec-pt=N] [--loss=PCT] [--json]\n\n"
+    "Receives splash_main's RTP stream and reports latency, jitter, packet loss\n"
+    "and frame continuity. Latency needs stream.latency_sei=true on the sender\n"
+    "and, across hosts, synchronized wall clocks.\n\n"
+    "Options:\n"
+    "  --port=N          UDP port to listen on (default %d).\n"
+    "  --bind=ADDR       Local address, or a multicast group to join (default any).\n"
+    "  --interval=MS     Progress line period (default %d, 0 = summary only).\n"
+    "  --duration=S      Stop after S seconds (default: until interrupted).\n"
+    "  --max-latency=MS  Fail when the worst latency exceeds MS.\n"
+    "  --pt=N            Media payload type (default: the first type received that\n"
+    "                    is not the retransmission or repair type).\n"
+    "  --nack            Request lost packets with RTCP generic NACKs, sent back to\n"
+    "                    the packets' source (needs stream.rtx_history on the sender).\n"
+    "  --rtx-pt=N        Retransmission payload type (default: media type + 1).\n"
+    "  --rtx-wait=MS     How long a lost packet may hold back the next ones (default %d).\n"
+    "  --fec             Rebuild lost packets from the sender's repair packets\n"
+    "                    (stream.fec on the sender).\n"
+    "  --fec-pt=N        Repair payload type (default: media type + 2).\n"
+    "  --loss=PCT        Drop PCT%% of the received packets, to test recovery.\n"
+    "  --json            Print the summary as one JSON object.\n",
+    p, DEFAULT_PORT, DEFAULT_INTERVAL_MS, DEFAULT_RTX_WAIT_MS);
+}
+
+static gboolean parse_uint(const char *arg, const char *prefix, guint64 max, guint64 *out){
+  const char *num = arg + strlen(prefix);
+  gchar *endptr = NULL;
+  guint64 v = g_ascii_strtoull(num, &endptr, 10);
+  if (!num[0] || *endptr || v > max) {
+    fprintf(stderr, "Invalid %.*s value: %s\n", (int)strlen(prefix) - 1, prefix, num);
+    return FALSE;
+  }
+  *out = v;
+  return TRUE;
+}
+
+int main(int argc, char **argv){
+  guint64 port = DEFAULT_PORT, interval_ms = DEFAULT_INTERVAL_MS, duration_s = 0, max_latency_ms = 0;
+  guint64 media_pt = 0, rtx_pt = 0, rtx_wait_ms = DEFAULT_RTX_WAIT_MS, fec_pt = 0;
+  double loss_pct = 0;
+  const char *bind_addr = NULL;
+  gboolean json = FALSE, nack = FALSE, fec = FALSE;
+  for (int i = 1; i < argc; ++i) {
+    gboolean ok = TRUE;
+    if (g_str_has_prefix(argv[i], "--port=")) {
+      ok = parse_uint(argv[i], "--port=", 65535, &port) && port > 0;
+    } else if (g_str_has_prefix(argv[i], "--bind=")) {
+      bind_addr = argv[i] + strlen("--bind=");
+    } else if (g_str_has_prefix(argv[i], "--interval=")) {
+      ok = parse_uint(argv[i], "--interval=", G_MAXUINT, &interval_ms);
+    } else if (g_str_has_prefix(argv[i], "--duration=")) {
+      ok = parse_uint(argv[i], "--duration=", G_MAXUINT / 1000, &duration_s);
+    } else if (g_str_has_prefix(argv[i], "--max-latency=")) {
+      ok = parse_uint(argv[i], "--max-latency=", G_MAXUINT, &max_latency_ms);
+    } else if (g_str_has_prefix(argv[i], "--pt=")) {
+      ok = parse_uint(argv[i], "--pt=", 127, &media_pt);
+    } else if (!strcmp(argv[i], "--nack")) {
+      nack = TRUE;
+    } else if (g_str_has_prefix(argv[i], "--rtx-pt=")) {
+      ok = parse_uint(argv[i], "--rtx-pt=", 127, &rtx_pt);
+    } else if (g_str_has_prefix(argv[i], "--rtx-wait=")) {
+      ok = parse_uint(argv[i], "--rtx-wait=", 10000, &rtx_wait_ms);
+    } else if (!strcmp(argv[i], "--fec")) {
+      fec = TRUE;
+    } else if (g_str_has_prefix(argv[i], "--fec-pt=")) {
+      ok = parse_uint(argv[i], "--fec-pt=", 127, &fec_pt);
+    } else if (g_str_has_prefix(argv[i], "--loss=")) {
+      const char *num = argv[i] + strlen("--loss=");
+      gchar *endptr = NULL;
+      loss_pct = g_ascii_strtod(num, &endptr);
+      ok = num[0] && !*endptr && loss_pct >= 0 && loss_pct <= 100;
+      if (!ok) fprintf(stderr, "Invalid --loss value: %s\n", num);
+    } else if (!strcmp(argv[i], "--json")) {
+      json = TRUE;
+    } else {
+      ok = FALSE;
+    }
+    if (!ok) { usage(argv[0]); return 2; }
+  }
+
+  GError *err = NULL;
+  GInetAddress *addr = bind_addr ? g_inet_address_new_from_string(bind_addr)
+                                 : g_inet_address_new_any(G_SOCKET_FAMILY_IPV4);
+  if (!addr) {
+    fprintf(stderr, "Invalid --bind address: %s\n", bind_addr);
+    return 2;
+  }
+  gboolean multicast = g_inet_address_get_is_multicast(addr);
+  GSocket *sock = g_socket_new(g_inet_address_get_family(addr), G_SOCKET_TYPE_DATAGRAM,
+                               G_SOCKET_PROTOCOL_UDP, &err);
+  if (sock) {
+    g_socket_set_blocking(sock, FALSE);
+    g_socket_set_option(sock, SOL_SOCKET, SO_RCVBUF, RCVBUF_BYTES, NULL);
+    GInetAddress *local = multicast ? g_inet_address_new_any(g_inet_address_get_family(addr))
+                                    : g_object_ref(addr);
+    GSocketAddress *sa = g_inet_socket_address_new(local, (guint16)port);
+    if (!g_socket_bind(sock, sa, TRUE, &err) ||
+        (multicast && !g_socket_join_multicast_group(sock, addr, FALSE, NULL, &err))) {
+      g_clear_object(&sock);
+    }
+    g_object_unref(sa);
+    g_object_unref(local);
+  }
+  g_object_unref(addr);
+  if (!sock) {
+    fprintf(stderr, "Cannot listen on port %u: %s\n", (guint)port, err->message);
+    g_error_free(err);
+    return 1;
+  }
+
+  Rx rx = { 0 };
+  rx.loop = g_main_loop_new(NULL, FALSE);
+  rx.depay = splash_rtp_depay_new(on_au, &rx);
+  rx.json = json;
+  rx.t0_us = g_get_monotonic_time();
+  window_init(&rx.total);
+  window_init(&rx.win);
+  rx.media_pt = (guint8)media_pt;
+  rx.have_media_pt = media_pt > 0;
+  rx.nack = nack;
+  rx.rtx_pt = (guint)rtx_pt;
+  rx.rtx_wait_us = (gint64)rtx_wait_ms * 1000;
+  rx.loss = loss_pct / 100.0;
+  rx.sock = sock;
+  rx.rtcp_ssrc = g_random_int();
+  rx.repaired_ts = g_hash_table_new(NULL, NULL);
+  rx.repair_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+  rx.fec = fec;
+  rx.fec_pt = (guint)fec_pt;
+  if (fec) rx.fec_dec = splash_fec_dec_new();
+
+  GSource *src = g_socket_create_source(sock, G_IO_IN, NULL);
+  g_source_set_callback(src, (GSourceFunc)(void (*)(void))on_readable, &rx, NULL);
+  g_source_attach(src, NULL);
+  if (interval_ms > 0) g_timeout_add((guint)interval_ms, on_interval, &rx);
+  if (nack || fec) g_timeout_add(EXPIRE_TICK_MS, on_expire, &rx);
+  if (duration_s > 0) g_timeout_add_seconds((guint)duration_s, on_quit, &rx);
+  g_unix_signal_add(SIGINT, on_quit, &rx);
+  g_unix_signal_add(SIGTERM, on_quit, &rx);
+  if (!json) printf("Listening on port %u\n", (guint)port);
+  fflush(stdout);
+
+  g_main_loop_run(rx.loop);
+
+  if (nack || fec) flush_pending(&rx);
+  splash_rtp_depay_flush(rx.depay);
+  report(&rx);
+  LatencySummary l = summarize(rx.total.lat_us);
+  int rc = 0;
+  if (rx.total.lat_us->len == 0 || packets_lost(&rx) > 0 || rx.total.missing > 0 ||
+      rx.total.incomplete > 0 || (max_latency_ms > 0 && l.max > (double)max_latency_ms)) {
+    rc = 1;
+  }
+
+  g_source_destroy(src);
+  g_source_unref(src);
+  g_object_unref(sock);
+  splash_rtp_depay_free(rx.depay);
+  for (guint i = 0; i < REORDER_SLOTS; ++i) g_free(rx.pending[i].data);
+  g_hash_table_destroy(rx.repaired_ts);
+  g_array_free(rx.repair_us, TRUE);
+  splash_fec_dec_free(rx.fec_dec);
+  if (rx.source) g_object_unref(rx.source);
+  g_array_free(rx.total.lat_us, TRUE);
+  g_array_free(rx.win.lat_us, TRUE);
+  g_main_loop_unref(rx.loop);
+  return rc;
+}
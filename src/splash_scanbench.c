@@ -0,0 +1,128 @@
+// Start-code scanner micro-benchmark: GB/s of each splashscan implementation
+// against a plain byte loop, single-threaded and split across threads.
+//
+//   ./splash_scanbench [--size=MB] [--threads=N] [--reps=N] [FILE]
+//
+// Without FILE a synthetic buffer is used: random bytes with a start code
+// every 1-64 KB, roughly the NAL density of a 1080p all-intra stream.
+
+#include "splashscan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void byte_loop(const guint8 *p, gsize len, GArray *out){
+  for (gsize i = 0; i + 3 <= len; ++i) {
+    if (p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1) {
+      guint64 off = i;
+      g_array_append_val(out, off);
+    }
+  }
+}
+
+static guint8* synth(gsize len){
+  guint8 *p = g_malloc(len);
+  GRand *r = g_rand_new_with_seed(42);
+  for (gsize i = 0; i < len; i += 4) {
+    guint32 v = g_rand_int(r);
+    memcpy(p + i, &v, MIN(4, len - i));
+  }
+  for (gsize i = 0; i + 4 < len; i += (gsize)g_rand_int_range(r, 1024, 65536)) {
+    p[i] = 0; p[i + 1] = 0; p[i + 2] = 0; p[i + 3] = 1;
+  }
+  g_rand_free(r);
+  return p;
+}
+
+static gboolean same(const GArray *a, const GArray *b){
+  return a->len == b->len && !memcmp(a->data, b->data, (gsize)a->len * sizeof(guint64));
+}
+
+static void report(const char *name, guint threads, gsize len, gint64 best_us, guint hits){
+  printf("%-8s %3u thread(s)  %8.2f GB/s  %8.3f ms  %u start codes\n",
+         name, threads, best_us > 0 ? (double)len / best_us / 1000.0 : 0.0,
+         best_us / 1000.0, hits);
+}
+
+int main(int argc, char **argv){
+  gsize size_mb = 256;
+  guint threads = 0, reps = 5;
+  const char *path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (g_str_has_prefix(argv[i], "--size=")) size_mb = strtoul(argv[i] + 7, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--threads=")) threads = strtoul(argv[i] + 10, NULL, 10);
+    else if (g_str_has_prefix(argv[i], "--reps=")) reps = strtoul(argv[i] + 7, NULL, 10);
+    else if (argv[i][0] != '-' && !path) path = argv[i];
+    else {
+      fprintf(stderr, "Usage: %s [--size=MB] [--threads=N] [--reps=N] [FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (reps == 0) reps = 1;
+
+  GMappedFile *map = NULL;
+  guint8 *owned = NULL;
+  const guint8 *data;
+  gsize len;
+  if (path) {
+    GError *err = NULL;
+    map = g_mapped_file_new(path, FALSE, &err);
+    if (!map) {
+      fprintf(stderr, "%s\n", err->message);
+      g_error_free(err);
+      return 1;
+    }
+    data = (const guint8*)g_mapped_file_get_contents(map);
+    len = g_mapped_file_get_length(map);
+  } else {
+    len = MAX(size_mb, 1) << 20;
+    data = owned = synth(len);
+  }
+  printf("%s: %" G_GSIZE_FORMAT " bytes, best of %u\n", path ? path : "synthetic", len, reps);
+
+  GArray *ref = g_array_new(FALSE, FALSE, sizeof(guint64));
+  GArray *out = g_array_new(FALSE, FALSE, sizeof(guint64));
+  gint64 best = G_MAXINT64;
+  for (guint r = 0; r < reps; ++r) {
+    g_array_set_size(ref, 0);
+    gint64 t0 = g_get_monotonic_time();
+    byte_loop(data, len, ref);
+    best = MIN(best, g_get_monotonic_time() - t0);
+  }
+  report("byte", 1, len, best, ref->len);
+
+  int rc = 0;
+  static const SplashScanImpl impls[] = {
+    SPLASH_SCAN_SCALAR, SPLASH_SCAN_SSE2, SPLASH_SCAN_AVX2, SPLASH_SCAN_NEON,
+  };
+  for (gsize i = 0; i < G_N_ELEMENTS(impls); ++i) {
+    if (!splash_scan_set_impl(impls[i])) continue;
+    guint used = 1;
+    best = G_MAXINT64;
+    for (guint r = 0; r < reps; ++r) {
+      g_array_set_size(out, 0);
+      gint64 t0 = g_get_monotonic_time();
+      splash_scan_all(data, len, 1, out);
+      best = MIN(best, g_get_monotonic_time() - t0);
+    }
+    report(splash_scan_impl_name(impls[i]), 1, len, best, out->len);
+    if (!same(out, ref)) rc = 1;
+
+    best = G_MAXINT64;
+    for (guint r = 0; r < reps; ++r) {
+      g_array_set_size(out, 0);
+      gint64 t0 = g_get_monotonic_time();
+      used = splash_scan_all(data, len, threads, out);
+      best = MIN(best, g_get_monotonic_time() - t0);
+    }
+    if (used > 1) report(splash_scan_impl_name(impls[i]), used, len, best, out->len);
+    if (!same(out, ref)) rc = 1;
+  }
+  if (rc) fprintf(stderr, "MISMATCH: an implementation disagrees with the byte loop\n");
+
+  g_array_free(out, TRUE);
+  g_array_free(ref, TRUE);
+  g_free(owned);
+  if (map) g_mapped_file_unref(map);
+  return rc;
+}
@@ -0,0 +1,181 @@
+#include "splashcache.h"
+#include <errno.h>
+#include <unistd.h>
+
+typedef struct {
+  GstBuffer *buf;
+  GList link;        // node in the LRU queue while cached and unpinned
+  gboolean pinned;
+} Slot;
+
+struct SplashCache {
+  GMutex lock;
+  int fd;
+  const SplashIndex *idx;
+  guint64 budget;
+  Slot *slots;
+  GQueue lru;        // unpinned cached frames, most recently used at the head
+  SplashCacheCounters ctr;
+};
+
+SplashCache* splash_cache_new(int fd, const SplashIndex *idx, guint64 budget){
+  if (fd < 0 || !idx || idx->n_aus == 0) return NULL;
+  SplashCache *c = g_new0(SplashCache, 1);
+  g_mutex_init(&c->lock);
+  c->fd = fd;
+  c->idx = idx;
+  c->budget = budget;
+  c->slots = g_new0(Slot, idx->n_aus);
+  for (guint i = 0; i < idx->n_aus; ++i) c->slots[i].link.data = &c->slots[i];
+  g_queue_init(&c->lru);
+  return c;
+}
+
+void splash_cache_free(SplashCache *c){
+  if (!c) return;
+  for (guint i = 0; i < c->idx->n_aus; ++i) {
+    if (c->slots[i].buf) gst_buffer_unref(c->slots[i].buf);
+  }
+  g_free(c->slots);
+  close(c->fd);
+  g_mutex_clear(&c->lock);
+  g_free(c);
+}
+
+static GstBuffer* read_frame(SplashCache *c, guint frame){
+  const SplashAuEntry *au = &c->idx->aus[frame];
+  GstBuffer *buf = gst_buffer_new_allocate(NULL, au->size, NULL);
+  if (!buf) return NULL;
+  GstMapInfo mi;
+  if (!gst_buffer_map(buf, &mi, GST_MAP_WRITE)) {
+    gst_buffer_unref(buf);
+    return NULL;
+  }
+  gsize done = 0;
+  while (done < au->size) {
+    ssize_t r = pread(c->fd, mi.data + done, au->size - done, (off_t)(au->offset + done));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) break;
+    done += (gsize)r;
+  }
+  gst_buffer_unmap(buf, &mi);
+  if (done != au->size) {
+    gst_buffer_unref(buf);
+    return NULL;
+  }
+  return buf;
+}
+
+static void evict_locked(SplashCache *c, guint64 need){
+  while (c->ctr.bytes_used + need > c->budget && c->lru.tail) {
+    Slot *victim = (Slot*)c->lru.tail->data;
+    g_queue_unlink(&c->lru, &victim->link);
+    c->ctr.bytes_used -= gst_buffer_get_size(victim->buf);
+    gst_buffer_unref(victim->buf);
+    victim->buf = NULL;
+    c->ctr.evictions++;
+  }
+}
+
+// Stores buf in slot `frame` unless another thread got there first.
+static gboolean insert_locked(SplashCache *c, guint frame, GstBuffer *buf, gboolean pin){
+  Slot *slot = &c->slots[frame];
+  if (slot->buf) return TRUE;
+  guint64 size = gst_buffer_get_size(buf);
+  if (pin && c->ctr.bytes_pinned + size > c->budget) return FALSE;
+  evict_locked(c, size);
+  if (!pin && c->ctr.bytes_used + size > c->budget) return FALSE;
+  slot->buf = gst_buffer_ref(buf);
+  c->ctr.bytes_used += size;
+  if (pin) {
+    slot->pinned = TRUE;
+    c->ctr.bytes_pinned += size;
+    c->ctr.frames_pinned++;
+  } else {
+    g_queue_push_head_link(&c->lru, &slot->link);
+  }
+  return TRUE;
+}
+
+void splash_cache_unpin_all(SplashCache *c){
+  if (!c) return;
+  g_mutex_lock(&c->lock);
+  for (guint i = 0; i < c->idx->n_aus; ++i) {
+    Slot *slot = &c->slots[i];
+    if (!slot->pinned) continue;
+    slot->pinned = FALSE;
+    if (slot->buf) g_queue_push_tail_link(&c->lru, &slot->link);
+  }
+  c->ctr.bytes_pinned = 0;
+  c->ctr.frames_pinned = 0;
+  evict_locked(c, 0);
+  g_mutex_unlock(&c->lock);
+}
+
+gboolean splash_cache_pin(SplashCache *c, guint frame){
+  if (!c || frame >= c->idx->n_aus) return FALSE;
+  Slot *slot = &c->slots[frame];
+  g_mutex_lock(&c->lock);
+  if (slot->pinned) {
+    g_mutex_unlock(&c->lock);
+    return TRUE;
+  }
+  if (slot->buf) {
+    guint64 size = gst_buffer_get_size(slot->buf);
+    gboolean ok = c->ctr.bytes_pinned + size <= c->budget;
+    if (ok) {
+      g_queue_unlink(&c->lru, &slot->link);
+      slot->pinned = TRUE;
+      c->ctr.bytes_pinned += size;
+      c->ctr.frames_pinned++;
+    }
+    g_mutex_unlock(&c->lock);
+    return ok;
+  }
+  if (c->ctr.bytes_pinned + c->idx->aus[frame].size > c->budget) {
+    g_mutex_unlock(&c->lock);
+    return FALSE;
+  }
+  g_mutex_unlock(&c->lock);
+
+  GstBuffer *buf = read_frame(c, frame);
+  if (!buf) return FALSE;
+  g_mutex_lock(&c->lock);
+  gboolean ok = insert_locked(c, frame, buf, TRUE);
+  g_mutex_unlock(&c->lock);
+  gst_buffer_unref(buf);
+  return ok;
+}
+
+GstBuffer* splash_cache_get(SplashCache *c, guint frame){
+  if (!c || frame >= c->idx->n_aus) return NULL;
+  Slot *slot = &c->slots[frame];
+  g_mutex_lock(&c->lock);
+  if (slot->buf) {
+    c->ctr.hits++;
+    if (!slot->pinned) {
+      g_queue_unlink(&c->lru, &slot->link);
+      g_queue_push_head_link(&c->lru, &slot->link);
+    }
+    GstBuffer *buf = gst_buffer_ref(slot->buf);
+    g_mutex_unlock(&c->lock);
+    return buf;
+  }
+  c->ctr.misses++;
+  g_mutex_unlock(&c->lock);
+
+  // Read outside the lock so counters stay cheap to query during I/O
+  GstBuffer *buf = read_frame(c, frame);
+  if (!buf) return NULL;
+  g_mutex_lock(&c->lock);
+  insert_locked(c, frame, buf, FALSE);
+  g_mutex_unlock(&c->lock);
+  return buf;
+}
+
+void splash_cache_get_counters(SplashCache *c, SplashCacheCounters *out){
+  if (!c || !out) return;
+  g_mutex_lock(&c->lock);
+  *out = c->ctr;
+  g_mutex_unlock(&c->lock);
+}
@@ -0,0 +1,45 @@
+#ifndef SPLASHCACHE_H
+#define SPLASHCACHE_H
+
+#include <gst/gst.h>
+#include "splashindex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bounded-memory frame cache in front of an indexed input file. Frames are
+// read with pread() on a miss and kept until the byte budget is exceeded, at
+// which point the least recently used unpinned frame is dropped. Pinned
+// frames are loaded eagerly and never evicted; pinning stops once pinned
+// frames alone would exceed the budget. All calls are thread-safe.
+
+typedef struct SplashCache SplashCache;
+
+typedef struct {
+  guint64 hits;
+  guint64 misses;
+  guint64 evictions;
+  guint64 bytes_used;    // cached bytes, pinned frames included
+  guint64 bytes_pinned;
+  guint   frames_pinned;
+} SplashCacheCounters;
+
+// Takes ownership of fd. idx must outlive the cache.
+SplashCache* splash_cache_new(int fd, const SplashIndex *idx, guint64 budget);
+void         splash_cache_free(SplashCache *c);
+
+// Drops every pin (pinned frames become ordinary LRU entries).
+void     splash_cache_unpin_all(SplashCache *c);
+// Pins and preloads a frame. Returns FALSE when the budget is exhausted.
+gboolean splash_cache_pin(SplashCache *c, guint frame);
+
+// Returns a new reference to the frame's data, or NULL on read errors.
+GstBuffer* splash_cache_get(SplashCache *c, guint frame);
+
+void splash_cache_get_counters(SplashCache *c, SplashCacheCounters *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
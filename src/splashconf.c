@@ -0,0 +1,1093 @@
+#include "splashconf.h"
+#include "splashembed.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SEQ_GROUP_PREFIX "sequence"
+
+void splash_conf_free_combos(ComboSeq *combos, int count) {
+  if (!combos) return;
+  for (int i = 0; i < count; ++i) {
+    g_free(combos[i].indices);
+  }
+  g_free(combos);
+}
+
+static gboolean parse_stream_outputs(const char *value, SplashOutputMode *mode_out) {
+  if (!mode_out) return FALSE;
+  SplashOutputMode mode = SPLASH_OUTPUT_NONE;
+  if (!value || !*value) {
+    *mode_out = SPLASH_OUTPUT_UDP;
+    return TRUE;
+  }
+  gchar **tokens = g_strsplit(value, ",", -1);
+  if (!tokens) {
+    *mode_out = SPLASH_OUTPUT_UDP;
+    return TRUE;
+  }
+  for (gint i = 0; tokens[i]; ++i) {
+    gchar *trimmed = g_strstrip(tokens[i]);
+    if (!trimmed || *trimmed == '\0') continue;
+    if (g_ascii_strcasecmp(trimmed, "udp") == 0) {
+      mode |= SPLASH_OUTPUT_UDP;
+    } else if (g_ascii_strcasecmp(trimmed, "appsrc") == 0) {
+      mode |= SPLASH_OUTPUT_APPSRC;
+    } else if (g_ascii_strcasecmp(trimmed, "both") == 0) {
+      mode |= (SplashOutputMode)(SPLASH_OUTPUT_UDP | SPLASH_OUTPUT_APPSRC);
+    } else {
+      g_strfreev(tokens);
+      return FALSE;
+    }
+  }
+  g_strfreev(tokens);
+  if (mode == SPLASH_OUTPUT_NONE) mode = SPLASH_OUTPUT_UDP;
+  *mode_out = mode;
+  return TRUE;
+}
+
+static gboolean parse_index_mode(const char *value, SplashIndexMode *mode_out) {
+  if (!mode_out) return FALSE;
+  if (!value || !*value || g_ascii_strcasecmp(value, "auto") == 0) {
+    *mode_out = SPLASH_INDEX_AUTO;
+  } else if (g_ascii_strcasecmp(value, "memory") == 0) {
+    *mode_out = SPLASH_INDEX_MEMORY;
+  } else if (g_ascii_strcasecmp(value, "off") == 0) {
+    *mode_out = SPLASH_INDEX_OFF;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Parses a byte count with an optional K/M/G (binary) suffix.
+static gboolean parse_byte_size(const char *value, guint64 *out) {
+  if (!value || !out) return FALSE;
+  gchar *end = NULL;
+  guint64 v = g_ascii_strtoull(value, &end, 10);
+  if (end == value) return FALSE;
+  while (g_ascii_isspace(*end)) end++;
+  guint64 mul = 1;
+  switch (*end) {
+    case '\0': break;
+    case 'k': case 'K': mul = 1024ull; end++; break;
+    case 'm': case 'M': mul = 1024ull * 1024; end++; break;
+    case 'g': case 'G': mul = 1024ull * 1024 * 1024; end++; break;
+    default: return FALSE;
+  }
+  if (*end == 'b' || *end == 'B') end++;
+  if (*end != '\0') return FALSE;
+  *out = v * mul;
+  return TRUE;
+}
+
+// Bits per second with optional decimal k/M/G suffix ("4M", "2.5M").
+static gboolean parse_bitrate(const char *value, guint64 *out) {
+  if (!value || !out) return FALSE;
+  gchar *end = NULL;
+  double v = g_ascii_strtod(value, &end);
+  if (end == value || v < 0) return FALSE;
+  while (g_ascii_isspace(*end)) end++;
+  switch (*end) {
+    case '\0': break;
+    case 'k': case 'K': v *= 1e3; end++; break;
+    case 'm': case 'M': v *= 1e6; end++; break;
+    case 'g': case 'G': v *= 1e9; end++; break;
+    default: return FALSE;
+  }
+  if (*end != '\0') return FALSE;
+  *out = (guint64)(v + 0.5);
+  return TRUE;
+}
+
+static gboolean parse_backpressure(const char *value, SplashBackpressure *out) {
+  if (!value || !out) return FALSE;
+  if (g_ascii_strcasecmp(value, "block") == 0) {
+    *out = SPLASH_BACKPRESSURE_BLOCK;
+  } else if (g_ascii_strcasecmp(value, "leak-oldest") == 0) {
+    *out = SPLASH_BACKPRESSURE_LEAK_OLDEST;
+  } else if (g_ascii_strcasecmp(value, "leak-newest") == 0) {
+    *out = SPLASH_BACKPRESSURE_LEAK_NEWEST;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean parse_fec(const char *value, SplashFecScheme *out) {
+  if (!value || !out) return FALSE;
+  if (g_ascii_strcasecmp(value, "off") == 0) {
+    *out = SPLASH_FEC_OFF;
+  } else if (g_ascii_strcasecmp(value, "xor") == 0) {
+    *out = SPLASH_FEC_XOR;
+  } else if (g_ascii_strcasecmp(value, "rs") == 0) {
+    *out = SPLASH_FEC_RS;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean parse_aggregate(const char *value, SplashAggregateMode *out) {
+  if (!value || !out) return FALSE;
+  if (g_ascii_strcasecmp(value, "zero-latency") == 0) {
+    *out = SPLASH_AGGREGATE_ZERO_LATENCY;
+  } else if (g_ascii_strcasecmp(value, "none") == 0) {
+    *out = SPLASH_AGGREGATE_NONE;
+  } else if (g_ascii_strcasecmp(value, "max") == 0) {
+    *out = SPLASH_AGGREGATE_MAX;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Parses an RTP packet size in bytes, or "auto" for SPLASH_MTU_AUTO.
+static gboolean parse_mtu(const char *value, int *out) {
+  if (!value || !out) return FALSE;
+  if (g_ascii_strcasecmp(value, "auto") == 0) {
+    *out = SPLASH_MTU_AUTO;
+    return TRUE;
+  }
+  gchar *end = NULL;
+  guint64 v = g_ascii_strtoull(value, &end, 10);
+  if (end == value || *end != '\0' || v < 64 || v > 65507) return FALSE;
+  *out = (int)v;
+  return TRUE;
+}
+
+static gboolean parse_timeline(const char *value, SplashTimelineMode *out) {
+  if (!value || !out) return FALSE;
+  if (g_ascii_strcasecmp(value, "reset") == 0) {
+    *out = SPLASH_TIMELINE_RESET;
+  } else if (g_ascii_strcasecmp(value, "persistent") == 0) {
+    *out = SPLASH_TIMELINE_PERSISTENT;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean parse_sched_policy(const char *value, SplashSchedPolicy *out) {
+  if (!value || !out) return FALSE;
+  if (g_ascii_strcasecmp(value, "other") == 0) {
+    *out = SPLASH_SCHED_OTHER;
+  } else if (g_ascii_strcasecmp(value, "fifo") == 0) {
+    *out = SPLASH_SCHED_FIFO;
+  } else if (g_ascii_strcasecmp(value, "rr") == 0) {
+    *out = SPLASH_SCHED_RR;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Parses a CPU list such as "0-3,6" into an affinity mask (CPUs 0..63).
+static gboolean parse_cpu_list(const char *value, guint64 *out) {
+  if (!value || !out) return FALSE;
+  guint64 mask = 0;
+  gboolean ok = TRUE;
+  gchar **parts = g_strsplit(value, ",", -1);
+  for (gchar **p = parts; ok && *p; ++p) {
+    gchar *item = g_strstrip(*p);
+    gchar *end = NULL;
+    guint64 first = g_ascii_strtoull(item, &end, 10), last = first;
+    if (end == item) { ok = FALSE; break; }
+    if (*end == '-') {
+      gchar *rest = end + 1;
+      last = g_ascii_strtoull(rest, &end, 10);
+      if (end == rest) { ok = FALSE; break; }
+    }
+    if (*end != '\0' || last < first || last > 63) { ok = FALSE; break; }
+    for (guint64 cpu = first; cpu <= last; ++cpu) mask |= G_GUINT64_CONSTANT(1) << cpu;
+  }
+  g_strfreev(parts);
+  if (!ok || mask == 0) return FALSE;
+  *out = mask;
+  return TRUE;
+}
+
+// Reads <prefix>_sched, <prefix>_priority and <prefix>_cpus from [stream].
+static gboolean load_thread_sched(GKeyFile *kf, const char *prefix, SplashThreadSched *out) {
+  memset(out, 0, sizeof(*out));
+  gboolean ok = TRUE;
+  gchar *key = g_strdup_printf("%s_sched", prefix);
+  if (g_key_file_has_key(kf, "stream", key, NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", key, NULL);
+    if (!v || !parse_sched_policy(g_strstrip(v), &out->policy)) {
+      fprintf(stderr, "stream.%s must be other, fifo or rr\n", key);
+      ok = FALSE;
+    }
+    g_free(v);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_priority", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    GError *error = NULL;
+    gint v = g_key_file_get_integer(kf, "stream", key, &error);
+    if (error || v < 1 || v > 99) {
+      fprintf(stderr, "Invalid stream.%s: %s\n", key, error ? error->message : "must be 1..99");
+      ok = FALSE;
+    } else {
+      out->priority = v;
+    }
+    g_clear_error(&error);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_cpus", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", key, NULL);
+    if (!v || !parse_cpu_list(g_strstrip(v), &out->cpus)) {
+      fprintf(stderr, "stream.%s must be a CPU list such as 2-3 or 0,4\n", key);
+      ok = FALSE;
+    }
+    g_free(v);
+  }
+  g_free(key);
+  return ok;
+}
+
+// Reads <prefix>_policy, <prefix>_max_bytes, <prefix>_max_time, <prefix>_queue,
+// <prefix>_max_bitrate and <prefix>_burst from [stream].
+static gboolean load_output_policy(GKeyFile *kf, const char *prefix, SplashOutputPolicy *out) {
+  memset(out, 0, sizeof(*out));
+  gboolean ok = TRUE;
+  gchar *key = g_strdup_printf("%s_policy", prefix);
+  if (g_key_file_has_key(kf, "stream", key, NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", key, NULL);
+    if (!v || !parse_backpressure(g_strstrip(v), &out->policy)) {
+      fprintf(stderr, "stream.%s must be block, leak-oldest or leak-newest\n", key);
+      ok = FALSE;
+    }
+    g_free(v);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_max_bytes", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", key, NULL);
+    if (!v || !parse_byte_size(g_strstrip(v), &out->max_bytes)) {
+      fprintf(stderr, "stream.%s must be a byte count such as 262144 or 256K\n", key);
+      ok = FALSE;
+    }
+    g_free(v);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_max_time", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    GError *error = NULL;
+    gint v = g_key_file_get_integer(kf, "stream", key, &error);
+    if (error || v < 0) {
+      fprintf(stderr, "Invalid stream.%s: %s\n", key, error ? error->message : "must be >= 0");
+      ok = FALSE;
+    } else {
+      out->max_time_ms = (guint64)v;
+    }
+    g_clear_error(&error);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_queue", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    GError *error = NULL;
+    gint v = g_key_file_get_integer(kf, "stream", key, &error);
+    if (error || v < 0) {
+      fprintf(stderr, "Invalid stream.%s: %s\n", key, error ? error->message : "must be >= 0");
+      ok = FALSE;
+    } else {
+      out->queue_frames = (guint)v;
+    }
+    g_clear_error(&error);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_max_bitrate", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", key, NULL);
+    if (!v || !parse_bitrate(g_strstrip(v), &out->max_bitrate)) {
+      fprintf(stderr, "stream.%s must be bits per second such as 4000000 or 4M\n", key);
+      ok = FALSE;
+    }
+    g_free(v);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_burst", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", key, NULL);
+    if (!v || !parse_byte_size(g_strstrip(v), &out->burst_bytes)) {
+      fprintf(stderr, "stream.%s must be a byte count such as 131072 or 128K\n", key);
+      ok = FALSE;
+    }
+    g_free(v);
+  }
+  g_free(key);
+
+  key = g_strdup_printf("%s_fps", prefix);
+  if (ok && g_key_file_has_key(kf, "stream", key, NULL)) {
+    GError *error = NULL;
+    gint v = g_key_file_get_integer(kf, "stream", key, &error);
+    if (error || v < 0) {
+      fprintf(stderr, "Invalid stream.%s: %s\n", key, error ? error->message : "must be >= 0");
+      ok = FALSE;
+    } else {
+      out->max_fps = (guint)v;
+    }
+    g_clear_error(&error);
+  }
+  g_free(key);
+  return ok;
+}
+
+typedef struct {
+  gchar *name;
+  GPtrArray *parts; // array of gchar* (owned)
+  gboolean loop_at_end;
+} PendingCombo;
+
+static void pending_combo_free(PendingCombo *pc) {
+  if (!pc) return;
+  if (pc->parts) {
+    for (guint i = 0; i < pc->parts->len; ++i) {
+      g_free(g_ptr_array_index(pc->parts, i));
+    }
+    g_ptr_array_free(pc->parts, TRUE);
+  }
+  g_free(pc->name);
+  g_free(pc);
+}
+
+static gchar *extract_sequence_name(const gchar *group, GError **error) {
+  const gsize prefix_len = strlen(SEQ_GROUP_PREFIX);
+  const gchar *raw = group + prefix_len;
+  while (g_ascii_isspace(*raw)) raw++;
+
+  if (*raw == '\0') {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "Sequence group '%s' is missing a name", group);
+    return NULL;
+  }
+
+  gchar *name = g_strdup(raw);
+  g_strstrip(name);
+  gsize name_len = strlen(name);
+  if (name_len >= 2 && name[0] == '"' && name[name_len - 1] == '"') {
+    memmove(name, name + 1, name_len - 2);
+    name[name_len - 2] = '\0';
+  }
+  if (*name == '\0') {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "Sequence group '%s' resolved to an empty name", group);
+    g_free(name);
+    return NULL;
+  }
+  return name;
+}
+
+static gboolean parse_sequence_group(GKeyFile *kf, const gchar *group,
+                                     GPtrArray *owned_strings,
+                                     GArray *out_sequences,
+                                     GError **error) {
+  GError *local_error = NULL;
+  gchar *name = extract_sequence_name(group, &local_error);
+  if (!name) {
+    if (local_error) g_propagate_error(error, local_error);
+    return FALSE;
+  }
+
+  gint start = g_key_file_get_integer(kf, group, "start", &local_error);
+  if (local_error) {
+    g_propagate_error(error, local_error);
+    g_free(name);
+    return FALSE;
+  }
+  gint end = g_key_file_get_integer(kf, group, "end", &local_error);
+  if (local_error) {
+    g_propagate_error(error, local_error);
+    g_free(name);
+    return FALSE;
+  }
+  if (start > end) {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "Sequence '%s' has start (%d) after end (%d)", name, start, end);
+    g_free(name);
+    return FALSE;
+  }
+
+  SplashSeq seq = { name, start, end };
+  g_ptr_array_add(owned_strings, name);
+  g_array_append_val(out_sequences, seq);
+  return TRUE;
+}
+
+static gboolean parse_combo_group(GKeyFile *kf, const gchar *group,
+                                  PendingCombo **out_combo,
+                                  GError **error) {
+  GError *local_error = NULL;
+  gchar *name = extract_sequence_name(group, &local_error);
+  if (!name) {
+    if (local_error) g_propagate_error(error, local_error);
+    return FALSE;
+  }
+
+  gchar *order = g_key_file_get_string(kf, group, "order", &local_error);
+  if (local_error) {
+    g_propagate_error(error, local_error);
+    g_free(name);
+    return FALSE;
+  }
+  if (!order) {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "Combo sequence '%s' missing order", name);
+    g_free(name);
+    return FALSE;
+  }
+
+  gboolean loop_at_end = FALSE;
+  if (g_key_file_has_key(kf, group, "loop_at_end", NULL)) {
+    local_error = NULL;
+    loop_at_end = g_key_file_get_boolean(kf, group, "loop_at_end", &local_error);
+    if (local_error) {
+      g_propagate_error(error, local_error);
+      g_free(order);
+      g_free(name);
+      return FALSE;
+    }
+  }
+
+  gchar **parts = g_strsplit(order, ",", -1);
+  g_free(order);
+  if (!parts) {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "Combo sequence '%s' has invalid order", name);
+    g_free(name);
+    return FALSE;
+  }
+
+  GPtrArray *part_array = g_ptr_array_new();
+  for (gchar **p = parts; *p; ++p) {
+    gchar *trimmed = g_strdup(*p);
+    g_strstrip(trimmed);
+    if (trimmed[0] == '\0') {
+      g_free(trimmed);
+      g_strfreev(parts);
+      if (part_array) {
+        for (guint i = 0; i < part_array->len; ++i) {
+          g_free(g_ptr_array_index(part_array, i));
+        }
+        g_ptr_array_free(part_array, TRUE);
+      }
+      g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                  "Combo sequence '%s' contains an empty entry", name);
+      g_free(name);
+      return FALSE;
+    }
+    g_ptr_array_add(part_array, trimmed);
+  }
+  g_strfreev(parts);
+
+  if (part_array->len == 0) {
+    for (guint i = 0; i < part_array->len; ++i) {
+      g_free(g_ptr_array_index(part_array, i));
+    }
+    g_ptr_array_free(part_array, TRUE);
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "Combo sequence '%s' has an empty order", name);
+    g_free(name);
+    return FALSE;
+  }
+
+  PendingCombo *combo = g_new0(PendingCombo, 1);
+  combo->name = name;
+  combo->parts = part_array;
+  combo->loop_at_end = loop_at_end;
+  *out_combo = combo;
+  return TRUE;
+}
+
+gboolean splash_conf_load(const char *path,
+                          SplashConfig *cfg,
+                          SplashSeq **seqs_out,
+                          int *n_seqs_out,
+                          ComboSeq **combos_out,
+                          int *n_combos_out,
+                          GPtrArray **owned_strings_out,
+                          gboolean *combo_loop_full_out,
+                          guint16 *http_port_out) {
+  gboolean ok = FALSE;
+  GError *error = NULL;
+  ComboSeq *combo_array = NULL;
+  guint combo_count = 0;
+  GPtrArray *combo_defs = NULL;
+  gboolean combo_loop_full = FALSE;
+  GKeyFile *kf = g_key_file_new();
+  if (!kf) return FALSE;
+
+  if (combos_out) *combos_out = NULL;
+  if (n_combos_out) *n_combos_out = 0;
+  if (combo_loop_full_out) *combo_loop_full_out = FALSE;
+
+  gchar *config_abs = g_canonicalize_filename(path, NULL);
+  if (!config_abs) {
+    g_key_file_free(kf);
+    return FALSE;
+  }
+
+  gchar *config_dir = g_path_get_dirname(config_abs);
+  if (!config_dir) {
+    g_free(config_abs);
+    g_key_file_free(kf);
+    return FALSE;
+  }
+
+  if (!g_key_file_load_from_file(kf, config_abs, G_KEY_FILE_NONE, &error)) {
+    fprintf(stderr, "Failed to read config '%s': %s\n", path,
+            error ? error->message : "unknown error");
+    if (error) g_error_free(error);
+    g_free(config_abs);
+    g_free(config_dir);
+    g_key_file_free(kf);
+    return FALSE;
+  }
+
+  GPtrArray *owned_strings = g_ptr_array_new_with_free_func(g_free);
+  if (!owned_strings) {
+    g_free(config_abs);
+    g_free(config_dir);
+    g_key_file_free(kf);
+    return FALSE;
+  }
+
+  error = NULL;
+  gchar *input = g_key_file_get_string(kf, "stream", "input", &error);
+  if (error) {
+    fprintf(stderr, "Config missing stream.input: %s\n", error->message);
+    g_error_free(error);
+    goto done;
+  }
+  // embedded: names the asset linked into the binary, not a file
+  gchar *resolved_input = g_str_has_prefix(input, SPLASH_EMBEDDED_PREFIX)
+                            ? g_strdup(input) : g_canonicalize_filename(input, config_dir);
+  if (!resolved_input) {
+    fprintf(stderr, "Failed to resolve stream.input path '%s'\n", input);
+    g_free(input);
+    goto done;
+  }
+  g_free(input);
+  if (!g_str_has_prefix(resolved_input, SPLASH_EMBEDDED_PREFIX) &&
+      !g_file_test(resolved_input, G_FILE_TEST_EXISTS)) {
+    fprintf(stderr, "Configured input file '%s' does not exist\n",
+            resolved_input);
+    g_free(resolved_input);
+    goto done;
+  }
+  g_ptr_array_add(owned_strings, resolved_input);
+  cfg->input_path = resolved_input;
+
+  error = NULL;
+  cfg->fps = g_key_file_get_double(kf, "stream", "fps", &error);
+  if (error) {
+    fprintf(stderr, "Config missing/invalid stream.fps: %s\n", error->message);
+    g_error_free(error);
+    goto done;
+  }
+
+  cfg->index_mode = SPLASH_INDEX_AUTO;
+  if (g_key_file_has_key(kf, "stream", "index", NULL)) {
+    error = NULL;
+    gchar *mode = g_key_file_get_string(kf, "stream", "index", &error);
+    if (error) {
+      fprintf(stderr, "Invalid stream.index: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    if (!parse_index_mode(g_strstrip(mode), &cfg->index_mode)) {
+      fprintf(stderr, "stream.index must be 'auto', 'memory' or 'off' (got '%s')\n", mode);
+      g_free(mode);
+      goto done;
+    }
+    g_free(mode);
+  }
+
+  cfg->index_path = NULL;
+  if (g_key_file_has_key(kf, "stream", "index_path", NULL)) {
+    error = NULL;
+    gchar *idx = g_key_file_get_string(kf, "stream", "index_path", &error);
+    if (error) {
+      fprintf(stderr, "Invalid stream.index_path: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    gchar *resolved_idx = g_canonicalize_filename(idx, config_dir);
+    g_free(idx);
+    g_ptr_array_add(owned_strings, resolved_idx);
+    cfg->index_path = resolved_idx;
+  }
+
+  cfg->cache_bytes = 0;
+  if (g_key_file_has_key(kf, "stream", "cache_bytes", NULL)) {
+    gchar *size = g_key_file_get_string(kf, "stream", "cache_bytes", NULL);
+    if (!size || !parse_byte_size(g_strstrip(size), &cfg->cache_bytes)) {
+      fprintf(stderr, "stream.cache_bytes must be a byte count such as 4194304 or 4M\n");
+      g_free(size);
+      goto done;
+    }
+    g_free(size);
+  }
+
+  cfg->cache_pin_frames = 2;
+  if (g_key_file_has_key(kf, "stream", "cache_pin", NULL)) {
+    error = NULL;
+    cfg->cache_pin_frames = g_key_file_get_integer(kf, "stream", "cache_pin", &error);
+    if (error || cfg->cache_pin_frames < 0) {
+      fprintf(stderr, "Invalid stream.cache_pin: %s\n",
+              error ? error->message : "must be >= 0");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->decompress_threads = 0;
+  if (g_key_file_has_key(kf, "stream", "decompress_threads", NULL)) {
+    error = NULL;
+    cfg->decompress_threads = g_key_file_get_integer(kf, "stream", "decompress_threads", &error);
+    if (error || cfg->decompress_threads < 0) {
+      fprintf(stderr, "Invalid stream.decompress_threads: %s\n",
+              error ? error->message : "must be >= 0");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->index_threads = 0;
+  if (g_key_file_has_key(kf, "stream", "index_threads", NULL)) {
+    error = NULL;
+    cfg->index_threads = g_key_file_get_integer(kf, "stream", "index_threads", &error);
+    if (error || cfg->index_threads < 0) {
+      fprintf(stderr, "Invalid stream.index_threads: %s\n",
+              error ? error->message : "must be >= 0");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  if (!load_output_policy(kf, "udp", &cfg->udp_policy) ||
+      !load_output_policy(kf, "appsrc", &cfg->appsrc_policy) ||
+      !load_thread_sched(kf, "media", &cfg->media_sched) ||
+      !load_thread_sched(kf, "stream", &cfg->stream_sched)) {
+    goto done;
+  }
+
+  cfg->ps_interval_ms = 1000;
+  if (g_key_file_has_key(kf, "stream", "ps_interval", NULL)) {
+    error = NULL;
+    cfg->ps_interval_ms = g_key_file_get_integer(kf, "stream", "ps_interval", &error);
+    if (error) {
+      fprintf(stderr, "Invalid stream.ps_interval: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->watchdog_ms = 0;
+  if (g_key_file_has_key(kf, "stream", "watchdog_ms", NULL)) {
+    error = NULL;
+    cfg->watchdog_ms = g_key_file_get_integer(kf, "stream", "watchdog_ms", &error);
+    if (error || cfg->watchdog_ms < 0) {
+      fprintf(stderr, "Invalid stream.watchdog_ms: %s\n",
+              error ? error->message : "must be >= 0");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->latency_sei = false;
+  if (g_key_file_has_key(kf, "stream", "latency_sei", NULL)) {
+    error = NULL;
+    cfg->latency_sei = g_key_file_get_boolean(kf, "stream", "latency_sei", &error);
+    if (error) {
+      fprintf(stderr, "Invalid stream.latency_sei: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->rtx_history = 0;
+  if (g_key_file_has_key(kf, "stream", "rtx_history", NULL)) {
+    error = NULL;
+    cfg->rtx_history = g_key_file_get_integer(kf, "stream", "rtx_history", &error);
+    if (error || cfg->rtx_history < 0 || cfg->rtx_history > 32768) {
+      fprintf(stderr, "Invalid stream.rtx_history: %s\n",
+              error ? error->message : "must be 0..32768 packets");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->rtx_payload_type = 0;
+  if (g_key_file_has_key(kf, "stream", "rtx_payload_type", NULL)) {
+    error = NULL;
+    cfg->rtx_payload_type = g_key_file_get_integer(kf, "stream", "rtx_payload_type", &error);
+    if (error || cfg->rtx_payload_type < 96 || cfg->rtx_payload_type > 127) {
+      fprintf(stderr, "Invalid stream.rtx_payload_type: %s\n",
+              error ? error->message : "must be a dynamic payload type (96..127)");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->rtcp_port = 0;
+  if (g_key_file_has_key(kf, "stream", "rtcp_port", NULL)) {
+    error = NULL;
+    cfg->rtcp_port = g_key_file_get_integer(kf, "stream", "rtcp_port", &error);
+    if (error || cfg->rtcp_port < 0 || cfg->rtcp_port > 65535) {
+      fprintf(stderr, "Invalid stream.rtcp_port: %s\n",
+              error ? error->message : "must be 0..65535");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->fec = SPLASH_FEC_OFF;
+  if (g_key_file_has_key(kf, "stream", "fec", NULL)) {
+    gchar *v = g_key_file_get_string(kf, "stream", "fec", NULL);
+    if (!v || !parse_fec(g_strstrip(v), &cfg->fec)) {
+      fprintf(stderr, "stream.fec must be off, xor or rs\n");
+      g_free(v);
+      goto done;
+    }
+    g_free(v);
+  }
+
+  cfg->fec_k = 0;
+  if (g_key_file_has_key(kf, "stream", "fec_k", NULL)) {
+    error = NULL;
+    cfg->fec_k = g_key_file_get_integer(kf, "stream", "fec_k", &error);
+    if (error || cfg->fec_k < 1 || cfg->fec_k > 254) {
+      fprintf(stderr, "Invalid stream.fec_k: %s\n",
+              error ? error->message : "must be 1..254 packets");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->fec_n = 0;
+  if (g_key_file_has_key(kf, "stream", "fec_n", NULL)) {
+    error = NULL;
+    cfg->fec_n = g_key_file_get_integer(kf, "stream", "fec_n", &error);
+    int k = cfg->fec_k > 0 ? cfg->fec_k : 10;
+    if (error || cfg->fec_n <= k || cfg->fec_n > 255) {
+      fprintf(stderr, "Invalid stream.fec_n: %s\n",
+              error ? error->message : "must be above fec_k and at most 255");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->fec_payload_type = 0;
+  if (g_key_file_has_key(kf, "stream", "fec_payload_type", NULL)) {
+    error = NULL;
+    cfg->fec_payload_type = g_key_file_get_integer(kf, "stream", "fec_payload_type", &error);
+    if (error || cfg->fec_payload_type < 96 || cfg->fec_payload_type > 127) {
+      fprintf(stderr, "Invalid stream.fec_payload_type: %s\n",
+              error ? error->message : "must be a dynamic payload type (96..127)");
+      if (error) g_error_free(error);
+      goto done;
+    }
+  }
+
+  cfg->timeline = SPLASH_TIMELINE_RESET;
+  if (g_key_file_has_key(kf, "stream", "timeline", NULL)) {
+    error = NULL;
+    gchar *mode = g_key_file_get_string(kf, "stream", "timeline", &error);
+    if (error) {
+      fprintf(stderr, "Invalid stream.timeline: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    if (!parse_timeline(g_strstrip(mode), &cfg->timeline)) {
+      fprintf(stderr, "stream.timeline must be 'reset' or 'persistent' (got '%s')\n", mode);
+      g_free(mode);
+      goto done;
+    }
+    g_free(mode);
+  }
+
+  cfg->outputs = SPLASH_OUTPUT_UDP;
+  if (g_key_file_has_key(kf, "stream", "outputs", NULL)) {
+    error = NULL;
+    gchar *outputs = g_key_file_get_string(kf, "stream", "outputs", &error);
+    if (error) {
+      fprintf(stderr, "Invalid stream.outputs: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    if (!parse_stream_outputs(outputs, &cfg->outputs)) {
+      fprintf(stderr, "stream.outputs must contain only 'udp' and/or 'appsrc'\n");
+      g_free(outputs);
+      goto done;
+    }
+    g_free(outputs);
+  }
+
+  if (cfg->outputs & SPLASH_OUTPUT_UDP) {
+    error = NULL;
+    gchar *host = g_key_file_get_string(kf, "stream", "host", &error);
+    if (error) {
+      fprintf(stderr, "Config missing stream.host: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    g_ptr_array_add(owned_strings, host);
+    cfg->endpoint.host = host;
+
+    error = NULL;
+    cfg->endpoint.port = g_key_file_get_integer(kf, "stream", "port", &error);
+    if (error) {
+      fprintf(stderr, "Config missing/invalid stream.port: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+
+    if (g_key_file_has_key(kf, "stream", "mtu", NULL)) {
+      gchar *v = g_key_file_get_string(kf, "stream", "mtu", NULL);
+      if (!v || !parse_mtu(g_strstrip(v), &cfg->mtu)) {
+        fprintf(stderr, "stream.mtu must be 'auto' or a packet size of 64..65507 bytes\n");
+        g_free(v);
+        goto done;
+      }
+      g_free(v);
+    }
+
+    if (g_key_file_has_key(kf, "stream", "payload_type", NULL)) {
+      error = NULL;
+      cfg->payload_type = g_key_file_get_integer(kf, "stream", "payload_type", &error);
+      if (error || cfg->payload_type < 96 || cfg->payload_type > 127) {
+        fprintf(stderr, "Invalid stream.payload_type: %s\n",
+                error ? error->message : "must be a dynamic payload type (96..127)");
+        if (error) g_error_free(error);
+        goto done;
+      }
+    }
+
+    if (g_key_file_has_key(kf, "stream", "aggregate", NULL)) {
+      gchar *v = g_key_file_get_string(kf, "stream", "aggregate", NULL);
+      if (!v || !parse_aggregate(g_strstrip(v), &cfg->aggregate)) {
+        fprintf(stderr, "stream.aggregate must be zero-latency, none or max\n");
+        g_free(v);
+        goto done;
+      }
+      g_free(v);
+    }
+  } else {
+    cfg->endpoint.host = NULL;
+    cfg->endpoint.port = 0;
+  }
+
+  guint16 control_port = 8081;
+  if (g_key_file_has_key(kf, "control", "port", NULL)) {
+    error = NULL;
+    gint configured_port = g_key_file_get_integer(kf, "control", "port", &error);
+    if (error) {
+      fprintf(stderr, "Invalid control.port: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    if (configured_port < 1 || configured_port > 65535) {
+      fprintf(stderr, "control.port must be between 1 and 65535 (got %d)\n", configured_port);
+      goto done;
+    }
+    control_port = (guint16)configured_port;
+  }
+
+  if (g_key_file_has_key(kf, "control", "combo_loop_mode", NULL)) {
+    error = NULL;
+    gchar *mode = g_key_file_get_string(kf, "control", "combo_loop_mode", &error);
+    if (error) {
+      fprintf(stderr, "Invalid control.combo_loop_mode: %s\n", error->message);
+      g_error_free(error);
+      goto done;
+    }
+    if (mode) {
+      if (g_ascii_strcasecmp(mode, "entire") == 0 ||
+          g_ascii_strcasecmp(mode, "full") == 0 ||
+          g_ascii_strcasecmp(mode, "all") == 0) {
+        combo_loop_full = TRUE;
+      } else if (g_ascii_strcasecmp(mode, "final") == 0 ||
+                 g_ascii_strcasecmp(mode, "last") == 0) {
+        combo_loop_full = FALSE;
+      } else {
+        fprintf(stderr,
+                "control.combo_loop_mode must be 'entire' or 'final' (got '%s')\n",
+                mode);
+        g_free(mode);
+        goto done;
+      }
+    }
+    g_free(mode);
+  }
+
+  GArray *seq_array = g_array_new(FALSE, FALSE, sizeof(SplashSeq));
+  if (!seq_array) goto done;
+  combo_defs = g_ptr_array_new_with_free_func((GDestroyNotify)pending_combo_free);
+  if (!combo_defs) {
+    g_array_free(seq_array, TRUE);
+    goto done;
+  }
+
+  gsize n_groups = 0;
+  gchar **groups = g_key_file_get_groups(kf, &n_groups);
+  for (gsize i = 0; i < n_groups; ++i) {
+    if (g_str_has_prefix(groups[i], SEQ_GROUP_PREFIX)) {
+      gboolean has_order = g_key_file_has_key(kf, groups[i], "order", NULL);
+      gboolean has_start = g_key_file_has_key(kf, groups[i], "start", NULL);
+      gboolean has_end = g_key_file_has_key(kf, groups[i], "end", NULL);
+      if (has_order) {
+        if (has_start || has_end) {
+          fprintf(stderr,
+                  "Sequence group '%s' cannot mix order with start/end\n",
+                  groups[i]);
+          g_strfreev(groups);
+          g_array_free(seq_array, TRUE);
+          goto done;
+        }
+        PendingCombo *combo = NULL;
+        if (!parse_combo_group(kf, groups[i], &combo, &error)) {
+          fprintf(stderr, "Invalid combo sequence config: %s\n",
+                  error ? error->message : "unknown error");
+          if (error) g_error_free(error);
+          error = NULL;
+          g_strfreev(groups);
+          g_array_free(seq_array, TRUE);
+          g_ptr_array_free(combo_defs, TRUE);
+          combo_defs = NULL;
+          goto done;
+        }
+        g_ptr_array_add(combo_defs, combo);
+      } else {
+        if (!parse_sequence_group(kf, groups[i], owned_strings, seq_array, &error)) {
+          fprintf(stderr, "Invalid sequence config: %s\n",
+                  error ? error->message : "unknown error");
+          if (error) g_error_free(error);
+          error = NULL;
+          g_strfreev(groups);
+          g_array_free(seq_array, TRUE);
+          g_ptr_array_free(combo_defs, TRUE);
+          combo_defs = NULL;
+          goto done;
+        }
+      }
+    }
+  }
+  g_strfreev(groups);
+
+  if (seq_array->len == 0) {
+    fprintf(stderr, "Config must define at least one [sequence NAME] group\n");
+    g_array_free(seq_array, TRUE);
+    g_ptr_array_free(combo_defs, TRUE);
+    combo_defs = NULL;
+    goto done;
+  }
+
+  guint seq_count = seq_array->len;
+  SplashSeq *seqs = g_new0(SplashSeq, seq_count);
+  if (!seqs) {
+    g_array_free(seq_array, TRUE);
+    goto done;
+  }
+
+  for (guint i = 0; i < seq_count; ++i) {
+    seqs[i] = g_array_index(seq_array, SplashSeq, i);
+  }
+  g_array_free(seq_array, TRUE);
+
+  combo_count = combo_defs->len;
+  if (combo_count > 0) {
+    combo_array = g_new0(ComboSeq, combo_count);
+    if (!combo_array) {
+      g_ptr_array_free(combo_defs, TRUE);
+      combo_defs = NULL;
+      g_free(seqs);
+      goto done;
+    }
+    for (guint i = 0; i < combo_count; ++i) {
+      PendingCombo *pc = g_ptr_array_index(combo_defs, i);
+      combo_array[i].count = (int)pc->parts->len;
+      combo_array[i].indices = g_new0(int, combo_array[i].count);
+      if (!combo_array[i].indices) {
+        g_ptr_array_free(combo_defs, TRUE);
+        combo_defs = NULL;
+        for (guint k = 0; k <= i; ++k) {
+          if (combo_array[k].indices) g_free(combo_array[k].indices);
+        }
+        g_free(combo_array);
+        g_free(seqs);
+        goto done;
+      }
+      combo_array[i].name = pc->name;
+      g_ptr_array_add(owned_strings, pc->name);
+      pc->name = NULL;
+      combo_array[i].loop_at_end = pc->loop_at_end;
+      for (guint j = 0; j < pc->parts->len; ++j) {
+        const char *part_name = g_ptr_array_index(pc->parts, j);
+        int found = -1;
+        for (guint sidx = 0; sidx < seq_count; ++sidx) {
+          if (g_strcmp0(seqs[sidx].name, part_name) == 0) {
+            found = (int)sidx;
+            break;
+          }
+        }
+        if (found < 0) {
+          fprintf(stderr,
+                  "Combo sequence '%s' references unknown sequence '%s'\n",
+                  combo_array[i].name ? combo_array[i].name : "?",
+                  part_name);
+          g_ptr_array_free(combo_defs, TRUE);
+          combo_defs = NULL;
+          for (guint k = 0; k <= i; ++k) {
+            g_free(combo_array[k].indices);
+          }
+          g_free(combo_array);
+          g_free(seqs);
+          goto done;
+        }
+        combo_array[i].indices[j] = found;
+      }
+    }
+  }
+  if (combo_defs) {
+    g_ptr_array_free(combo_defs, TRUE);
+    combo_defs = NULL;
+  }
+
+  *seqs_out = seqs;
+  *n_seqs_out = (int)seq_count;
+  if (combos_out) *combos_out = combo_array;
+  if (n_combos_out) *n_combos_out = (int)combo_count;
+  *owned_strings_out = owned_strings;
+  if (combo_loop_full_out) *combo_loop_full_out = combo_loop_full;
+  if (http_port_out) *http_port_out = control_port;
+  ok = TRUE;
+
+done:
+  if (!ok) {
+    if (combo_array) {
+      for (guint i = 0; i < combo_count; ++i) {
+        g_free(combo_array[i].indices);
+      }
+      g_free(combo_array);
+    }
+  }
+  if (combo_defs) {
+    g_ptr_array_free(combo_defs, TRUE);
+  }
+  if (!ok) {
+    g_ptr_array_free(owned_strings, TRUE);
+  }
+  g_free(config_abs);
+  g_free(config_dir);
+  g_key_file_free(kf);
+  return ok;
+}
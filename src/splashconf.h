@@ -0,0 +1,41 @@
+#ifndef SPLASHCONF_H
+#define SPLASHCONF_H
+
+#include <glib.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// INI configuration shared by splash_main and splash_probe. Problems are
+// reported on stderr.
+
+typedef struct {
+  const char *name;
+  int *indices;
+  int count;
+  gboolean loop_at_end;
+} ComboSeq;
+
+// Loads path into cfg plus the [sequence] definitions. Relative paths are
+// resolved against the file's directory. Every string referenced from the
+// outputs is owned by *owned_strings_out; free *seqs_out with g_free() and
+// *combos_out with splash_conf_free_combos(). The combo and control outputs
+// may be NULL.
+gboolean splash_conf_load(const char *path,
+                          SplashConfig *cfg,
+                          SplashSeq **seqs_out,
+                          int *n_seqs_out,
+                          ComboSeq **combos_out,
+                          int *n_combos_out,
+                          GPtrArray **owned_strings_out,
+                          gboolean *combo_loop_full_out,
+                          guint16 *http_port_out);
+
+void splash_conf_free_combos(ComboSeq *combos, int count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,307 @@
+#include "splashdecomp.h"
+#include <gio/gio.h>
+#include <string.h>
+#ifdef SPLASH_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define GROW_CHUNK (1024 * 1024)
+
+SplashCompression splash_detect_compression(const guint8 *data, gsize len){
+  if (data && len >= 2 && data[0] == 0x1f && data[1] == 0x8b) return SPLASH_COMPRESSION_GZIP;
+  if (data && len >= 4 && data[0] == 0x28 && data[1] == 0xb5 &&
+      data[2] == 0x2f && data[3] == 0xfd) return SPLASH_COMPRESSION_ZSTD;
+  if (data && len >= 4 && data[0] == 'P' && data[1] == 'K' &&
+      data[2] == 3 && data[3] == 4) return SPLASH_COMPRESSION_ZIP;
+  return SPLASH_COMPRESSION_NONE;
+}
+
+// ---- parallel block decoding ----
+typedef struct {
+  gsize in_off, in_len;
+  gsize out_off, out_len;
+} Block;
+
+typedef gboolean (*BlockFn)(const guint8 *in, gsize in_len, guint8 *out, gsize out_len);
+
+typedef struct {
+  const guint8 *src;
+  guint8 *dst;
+  const Block *blocks;
+  guint n_blocks;
+  BlockFn fn;
+  gint next;
+  gint failed;
+} Pool;
+
+static gpointer pool_worker(gpointer data){
+  Pool *p = (Pool*)data;
+  for (;;) {
+    gint i = g_atomic_int_add(&p->next, 1);
+    if (i >= (gint)p->n_blocks || g_atomic_int_get(&p->failed)) break;
+    const Block *b = &p->blocks[i];
+    if (!p->fn(p->src + b->in_off, b->in_len, p->dst + b->out_off, b->out_len)) {
+      g_atomic_int_set(&p->failed, 1);
+    }
+  }
+  return NULL;
+}
+
+static GBytes* run_blocks(const guint8 *src, const Block *blocks, guint n_blocks,
+                          BlockFn fn, guint max_threads, guint *threads_used,
+                          GError **err){
+  gsize total = 0;
+  for (guint i = 0; i < n_blocks; ++i) total += blocks[i].out_len;
+  Pool p = { src, g_malloc(MAX(total, 1)), blocks, n_blocks, fn, 0, 0 };
+
+  guint threads = max_threads ? max_threads : g_get_num_processors();
+  threads = CLAMP(threads, 1, MAX(n_blocks, 1));
+  GThread **workers = g_new0(GThread*, threads);
+  for (guint i = 1; i < threads; ++i) {
+    workers[i] = g_thread_new("splash-decomp", pool_worker, &p);
+  }
+  pool_worker(&p);
+  for (guint i = 1; i < threads; ++i) g_thread_join(workers[i]);
+  g_free(workers);
+  if (threads_used) *threads_used = threads;
+
+  if (p.failed) {
+    g_free(p.dst);
+    g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "corrupt compressed block");
+    return NULL;
+  }
+  return g_bytes_new_take(p.dst, total);
+}
+
+// ---- gzip ----
+static gboolean gunzip_block(const guint8 *in, gsize in_len, guint8 *out, gsize out_len){
+  GConverter *conv = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+  gsize r = 0, w = 0;
+  GConverterResult res = g_converter_convert(conv, in, in_len, out, MAX(out_len, 1),
+                                             G_CONVERTER_INPUT_AT_END, &r, &w, NULL);
+  g_object_unref(conv);
+  return res == G_CONVERTER_FINISHED && w == out_len;
+}
+
+static guint32 rd_le32(const guint8 *p){ return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32)p[3] << 24); }
+static guint16 rd_le16(const guint8 *p){ return (guint16)(p[0] | (p[1] << 8)); }
+
+// Splits a BGZF file into members. Returns FALSE if any member lacks the
+// "BC" block-size field (plain gzip), in which case members are not seekable.
+static gboolean bgzf_blocks(const guint8 *data, gsize len, GArray *blocks){
+  gsize pos = 0, out = 0;
+  while (pos < len) {
+    if (len - pos < 18 || data[pos] != 0x1f || data[pos + 1] != 0x8b ||
+        !(data[pos + 3] & 0x04)) return FALSE;
+    gsize xlen = rd_le16(data + pos + 10);
+    if (pos + 12 + xlen > len) return FALSE;
+    gsize bsize = 0;
+    for (gsize x = pos + 12; x + 4 <= pos + 12 + xlen; ) {
+      gsize slen = rd_le16(data + x + 2);
+      if (data[x] == 'B' && data[x + 1] == 'C' && slen == 2) bsize = (gsize)rd_le16(data + x + 4) + 1;
+      x += 4 + slen;
+    }
+    if (bsize < 18 || pos + bsize > len) return FALSE;
+    Block b = { pos, bsize, out, rd_le32(data + pos + bsize - 4) };
+    g_array_append_val(blocks, b);
+    out += b.out_len;
+    pos += bsize;
+  }
+  return blocks->len > 0;
+}
+
+static GBytes* gunzip_stream(const guint8 *data, gsize len, GError **err){
+  GConverter *conv = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+  GByteArray *out = g_byte_array_sized_new((guint)MIN(len * 4, (gsize)G_MAXUINT / 2));
+  gsize in_pos = 0;
+  gboolean ok = FALSE;
+  for (;;) {
+    guint used = out->len;
+    g_byte_array_set_size(out, used + GROW_CHUNK);
+    gsize r = 0, w = 0;
+    GConverterResult res = g_converter_convert(conv, data + in_pos, len - in_pos,
+                                               out->data + used, GROW_CHUNK,
+                                               G_CONVERTER_INPUT_AT_END, &r, &w, err);
+    g_byte_array_set_size(out, used + (guint)w);
+    if (res == G_CONVERTER_ERROR) break;
+    in_pos += r;
+    if (res == G_CONVERTER_FINISHED) {
+      // Concatenated members (e.g. `cat a.gz b.gz`); anything else is padding
+      if (len - in_pos >= 2 && data[in_pos] == 0x1f && data[in_pos + 1] == 0x8b) {
+        g_converter_reset(conv);
+        continue;
+      }
+      ok = TRUE;
+      break;
+    }
+  }
+  g_object_unref(conv);
+  if (!ok) {
+    g_byte_array_free(out, TRUE);
+    return NULL;
+  }
+  return g_byte_array_free_to_bytes(out);
+}
+
+static GBytes* gunzip(const guint8 *data, gsize len, guint max_threads,
+                      guint *threads_used, GError **err){
+  GArray *blocks = g_array_new(FALSE, FALSE, sizeof(Block));
+  GBytes *res;
+  if (bgzf_blocks(data, len, blocks)) {
+    res = run_blocks(data, (const Block*)(void*)blocks->data, blocks->len,
+                     gunzip_block, max_threads, threads_used, err);
+  } else {
+    if (threads_used) *threads_used = 1;
+    res = gunzip_stream(data, len, err);
+  }
+  g_array_free(blocks, TRUE);
+  return res;
+}
+
+// ---- ZIP ----
+// Sizes come from the central directory because streamed archives (general
+// purpose flag bit 3) leave them zero in the local header.
+static GBytes* unzip(const guint8 *data, gsize len, guint *threads_used, GError **err){
+  if (threads_used) *threads_used = 1;
+  gsize eocd = 0;
+  gboolean found = FALSE;
+  for (gsize i = len >= 22 ? len - 22 : 0; len >= 22; --i) {
+    if (rd_le32(data + i) == 0x06054b50) { eocd = i; found = TRUE; break; }
+    if (i == 0 || len - i > 22 + 0xffff) break;
+  }
+  if (!found) {
+    g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "zip: no end of central directory");
+    return NULL;
+  }
+  guint n_entries = rd_le16(data + eocd + 10);
+  gsize cd = rd_le32(data + eocd + 16);
+
+  gsize pick_local = 0, pick_csize = 0, pick_usize = 0;
+  guint pick_method = 0;
+  gboolean picked = FALSE;
+  for (guint e = 0; e < n_entries; ++e) {
+    if (cd + 46 > len || rd_le32(data + cd) != 0x02014b50) break;
+    guint method = rd_le16(data + cd + 10);
+    gsize csize = rd_le32(data + cd + 20), usize = rd_le32(data + cd + 24);
+    gsize nlen = rd_le16(data + cd + 28), xlen = rd_le16(data + cd + 30), clen = rd_le16(data + cd + 32);
+    gsize local = rd_le32(data + cd + 42);
+    if (cd + 46 + nlen > len) break;
+    gboolean h265 = nlen >= 5 && g_ascii_strncasecmp((const char*)data + cd + 46 + nlen - 5, ".h265", 5) == 0;
+    if ((method == 0 || method == 8) && (!picked || h265)) {
+      pick_local = local; pick_csize = csize; pick_usize = usize; pick_method = method;
+      picked = TRUE;
+      if (h265) break;
+    }
+    cd += 46 + nlen + xlen + clen;
+  }
+  if (!picked || pick_local + 30 > len || rd_le32(data + pick_local) != 0x04034b50) {
+    g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "zip: no stored or deflated entry");
+    return NULL;
+  }
+  gsize off = pick_local + 30 + rd_le16(data + pick_local + 26) + rd_le16(data + pick_local + 28);
+  if (off + pick_csize > len) {
+    g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "zip: truncated entry");
+    return NULL;
+  }
+  if (pick_method == 0) return g_bytes_new(data + off, pick_csize);
+
+  guint8 *out = g_malloc(MAX(pick_usize, 1));
+  GConverter *conv = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW));
+  gsize r = 0, w = 0;
+  GConverterResult res = g_converter_convert(conv, data + off, pick_csize, out, MAX(pick_usize, 1),
+                                             G_CONVERTER_INPUT_AT_END, &r, &w, err);
+  g_object_unref(conv);
+  if (res != G_CONVERTER_FINISHED || w != pick_usize) {
+    if (res != G_CONVERTER_ERROR) {
+      g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "zip: size mismatch");
+    }
+    g_free(out);
+    return NULL;
+  }
+  return g_bytes_new_take(out, pick_usize);
+}
+
+// ---- zstd ----
+#ifdef SPLASH_HAVE_ZSTD
+static gboolean unzstd_block(const guint8 *in, gsize in_len, guint8 *out, gsize out_len){
+  size_t r = ZSTD_decompress(out, out_len, in, in_len);
+  return !ZSTD_isError(r) && r == out_len;
+}
+
+static GBytes* unzstd_stream(const guint8 *data, gsize len, GError **err){
+  ZSTD_DCtx *dctx = ZSTD_createDCtx();
+  GByteArray *out = g_byte_array_sized_new((guint)MIN(len * 4, (gsize)G_MAXUINT / 2));
+  ZSTD_inBuffer in = { data, len, 0 };
+  size_t last = 1;
+  for (;;) {
+    guint used = out->len;
+    g_byte_array_set_size(out, used + GROW_CHUNK);
+    ZSTD_outBuffer o = { out->data + used, GROW_CHUNK, 0 };
+    gsize before = in.pos;
+    last = ZSTD_decompressStream(dctx, &o, &in);
+    g_byte_array_set_size(out, used + (guint)o.pos);
+    if (ZSTD_isError(last)) break;
+    if (in.pos == in.size && last == 0) break;
+    if (o.pos == 0 && in.pos == before) { last = 1; break; } // truncated
+  }
+  ZSTD_freeDCtx(dctx);
+  if (ZSTD_isError(last) || last != 0) {
+    g_set_error(err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "zstd: %s",
+                ZSTD_isError(last) ? ZSTD_getErrorName(last) : "truncated input");
+    g_byte_array_free(out, TRUE);
+    return NULL;
+  }
+  return g_byte_array_free_to_bytes(out);
+}
+
+static GBytes* unzstd(const guint8 *data, gsize len, guint max_threads,
+                      guint *threads_used, GError **err){
+  GArray *blocks = g_array_new(FALSE, FALSE, sizeof(Block));
+  gboolean sized = TRUE;
+  gsize pos = 0, out = 0;
+  while (pos < len && sized) {
+    size_t fsz = ZSTD_findFrameCompressedSize(data + pos, len - pos);
+    if (ZSTD_isError(fsz)) { sized = FALSE; break; }
+    unsigned long long csz = ZSTD_getFrameContentSize(data + pos, fsz);
+    if (csz == ZSTD_CONTENTSIZE_UNKNOWN || csz == ZSTD_CONTENTSIZE_ERROR) { sized = FALSE; break; }
+    if (csz > 0) {
+      Block b = { pos, fsz, out, (gsize)csz };
+      g_array_append_val(blocks, b);
+      out += (gsize)csz;
+    }
+    pos += fsz;
+  }
+  GBytes *res;
+  if (sized && blocks->len > 0) {
+    res = run_blocks(data, (const Block*)(void*)blocks->data, blocks->len,
+                     unzstd_block, max_threads, threads_used, err);
+  } else {
+    if (threads_used) *threads_used = 1;
+    res = unzstd_stream(data, len, err);
+  }
+  g_array_free(blocks, TRUE);
+  return res;
+}
+#endif
+
+GBytes* splash_decompress(const guint8 *data, gsize len, SplashCompression kind,
+                          guint max_threads, guint *threads_used, GError **err){
+  if (threads_used) *threads_used = 0;
+  switch (kind) {
+    case SPLASH_COMPRESSION_GZIP:
+      return gunzip(data, len, max_threads, threads_used, err);
+    case SPLASH_COMPRESSION_ZIP:
+      return unzip(data, len, threads_used, err);
+    case SPLASH_COMPRESSION_ZSTD:
+#ifdef SPLASH_HAVE_ZSTD
+      return unzstd(data, len, max_threads, threads_used, err);
+#else
+      g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                  "zstd input requires a build with ZSTD=1");
+      return NULL;
+#endif
+    default:
+      g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "input is not compressed");
+      return NULL;
+  }
+}
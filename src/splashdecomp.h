@@ -0,0 +1,39 @@
+#ifndef SPLASHDECOMP_H
+#define SPLASHDECOMP_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One-shot decompression of compressed input streams into memory.
+//
+// gzip and ZIP are handled through GIO's zlib converter. Concatenated gzip
+// members are supported, and BGZF files (bgzip, "BC" extra field) are
+// decompressed in parallel because every member advertises its compressed and
+// inflated size. ZIP archives use their first stored/deflated entry whose name
+// ends in ".h265" (or the first entry if none does).
+// zstd needs SPLASH_HAVE_ZSTD (make ZSTD=1); multi-frame files whose frames
+// record their content size (pzstd, zstd --content-size) are decompressed in
+// parallel as well.
+
+typedef enum {
+  SPLASH_COMPRESSION_NONE = 0,
+  SPLASH_COMPRESSION_GZIP,
+  SPLASH_COMPRESSION_ZSTD,
+  SPLASH_COMPRESSION_ZIP,
+} SplashCompression;
+
+SplashCompression splash_detect_compression(const guint8 *data, gsize len);
+
+// Decompresses data using up to max_threads workers (0 = one per CPU).
+// *threads_used reports how many were actually used (1 when the format does
+// not allow splitting).
+GBytes* splash_decompress(const guint8 *data, gsize len, SplashCompression kind,
+                          guint max_threads, guint *threads_used, GError **err);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,50 @@
+#include "splashembed.h"
+
+#ifdef SPLASH_EMBED_ASSET
+// .incbin keeps the asset away from the C compiler (no multi-megabyte array
+// literal) and puts it in its own read-only section: the kernel pages it in
+// on first touch like the rest of the binary. The index follows 8-byte
+// aligned, as its entries are read in place.
+__asm__(
+  "  .section .rodata.splash_embed,\"a\",@progbits\n"
+  "  .balign 64\n"
+  "  .globl splash_embed_data\n"
+  "  .hidden splash_embed_data\n"
+  "splash_embed_data:\n"
+  "  .incbin \"" SPLASH_EMBED_ASSET "\"\n"
+  "  .globl splash_embed_data_end\n"
+  "  .hidden splash_embed_data_end\n"
+  "splash_embed_data_end:\n"
+  "  .balign 16\n"
+  "  .globl splash_embed_index\n"
+  "  .hidden splash_embed_index\n"
+  "splash_embed_index:\n"
+#ifdef SPLASH_EMBED_INDEX
+  "  .incbin \"" SPLASH_EMBED_INDEX "\"\n"
+#endif
+  "  .globl splash_embed_index_end\n"
+  "  .hidden splash_embed_index_end\n"
+  "splash_embed_index_end:\n"
+  "  .previous\n");
+
+extern const guint8 splash_embed_data[] G_GNUC_INTERNAL;
+extern const guint8 splash_embed_data_end[] G_GNUC_INTERNAL;
+extern const guint8 splash_embed_index[] G_GNUC_INTERNAL;
+extern const guint8 splash_embed_index_end[] G_GNUC_INTERNAL;
+
+gboolean splash_embedded_asset(const guint8 **data, gsize *len,
+                               const guint8 **index, gsize *index_len){
+  *data = splash_embed_data;
+  *len = (gsize)(splash_embed_data_end - splash_embed_data);
+  *index = splash_embed_index;
+  *index_len = (gsize)(splash_embed_index_end - splash_embed_index);
+  return *len > 0;
+}
+#else
+gboolean splash_embedded_asset(const guint8 **data, gsize *len,
+                               const guint8 **index, gsize *index_len){
+  *data = *index = NULL;
+  *len = *index_len = 0;
+  return FALSE;
+}
+#endif
@@ -0,0 +1,25 @@
+#ifndef SPLASHEMBED_H
+#define SPLASHEMBED_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Asset linked into the library at build time (make EMBED=FILE), served for
+// input=embedded: straight from the read-only mapping of the binary, together
+// with the frame index built for it at link time. Nothing is opened, read or
+// scanned at startup, so the splash runs before any storage is mounted.
+
+#define SPLASH_EMBEDDED_PREFIX "embedded:"
+
+// TRUE when this build carries an asset; *index_len is 0 if it came without
+// an index. The pointers stay valid for the life of the process.
+gboolean splash_embedded_asset(const guint8 **data, gsize *len,
+                               const guint8 **index, gsize *index_len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,148 @@
+#include "splashevents.h"
+#include <string.h>
+
+// Bounded MPMC ring after Vyukov: each slot carries a sequence number that
+// tells producers whether it is free for lap `pos` and the consumer whether
+// it has been published.
+typedef struct {
+  gint seq;                   // atomic
+  SplashEventType type;
+  int a, b;
+  gboolean has_msg;
+  char msg[SPLASH_EVENT_MSG_MAX];
+} Slot;
+
+struct SplashEventQueue {
+  Slot *slots;
+  guint mask;
+  gint tail;                  // atomic, next position to claim
+  guint head;                 // dispatcher only
+  gint dropped;               // atomic
+
+  // Wakeup: producers only touch the mutex when the dispatcher is idle.
+  GMutex lock;
+  GCond cond;
+  gint sleeping;              // atomic
+  gboolean stop;
+  SplashEventCb cb;           // guarded by lock
+  void *user;
+
+  GThread *thread;
+};
+
+#define IDLE_POLL_US 100000   // safety net against a missed wakeup
+
+static gboolean pop(SplashEventQueue *q, Slot *out){
+  Slot *s = &q->slots[q->head & q->mask];
+  gint seq = g_atomic_int_get(&s->seq);
+  if ((gint)((guint)seq - (q->head + 1)) < 0) return FALSE;
+  out->type = s->type;
+  out->a = s->a;
+  out->b = s->b;
+  out->has_msg = s->has_msg;
+  if (s->has_msg) memcpy(out->msg, s->msg, sizeof(out->msg));
+  g_atomic_int_set(&s->seq, (gint)(q->head + q->mask + 1));
+  q->head++;
+  return TRUE;
+}
+
+static gpointer dispatch_main(gpointer data){
+  SplashEventQueue *q = (SplashEventQueue*)data;
+  Slot ev;
+  for (;;) {
+    g_mutex_lock(&q->lock);
+    SplashEventCb cb = q->cb;
+    void *user = q->user;
+    gboolean stop = q->stop;
+    g_mutex_unlock(&q->lock);
+
+    gboolean any = FALSE;
+    while (pop(q, &ev)) {
+      any = TRUE;
+      if (cb) cb(ev.type, ev.a, ev.b, ev.has_msg ? ev.msg : NULL, user);
+    }
+    if (any) continue;
+    if (stop) break;
+
+    g_mutex_lock(&q->lock);
+    g_atomic_int_set(&q->sleeping, 1);
+    // Re-check after announcing we sleep, so a post racing with us is seen.
+    Slot *s = &q->slots[q->head & q->mask];
+    gboolean ready = (gint)((guint)g_atomic_int_get(&s->seq) - (q->head + 1)) >= 0;
+    if (!ready && !q->stop) {
+      g_cond_wait_until(&q->cond, &q->lock, g_get_monotonic_time() + IDLE_POLL_US);
+    }
+    g_atomic_int_set(&q->sleeping, 0);
+    g_mutex_unlock(&q->lock);
+  }
+  return NULL;
+}
+
+SplashEventQueue* splash_events_new(guint capacity){
+  guint cap = 2;
+  while (cap < capacity && cap < (1u << 20)) cap <<= 1;
+  SplashEventQueue *q = g_new0(SplashEventQueue, 1);
+  q->slots = g_new0(Slot, cap);
+  q->mask = cap - 1;
+  for (guint i = 0; i < cap; ++i) q->slots[i].seq = (gint)i;
+  g_mutex_init(&q->lock);
+  g_cond_init(&q->cond);
+  q->thread = g_thread_new("splash-events", dispatch_main, q);
+  return q;
+}
+
+void splash_events_free(SplashEventQueue *q){
+  if (!q) return;
+  g_mutex_lock(&q->lock);
+  q->stop = TRUE;
+  g_cond_broadcast(&q->cond);
+  g_mutex_unlock(&q->lock);
+  g_thread_join(q->thread);
+  g_cond_clear(&q->cond);
+  g_mutex_clear(&q->lock);
+  g_free(q->slots);
+  g_free(q);
+}
+
+void splash_events_set_callback(SplashEventQueue *q, SplashEventCb cb, void *user){
+  g_mutex_lock(&q->lock);
+  q->cb = cb;
+  q->user = user;
+  g_mutex_unlock(&q->lock);
+}
+
+gboolean splash_events_post(SplashEventQueue *q, SplashEventType type, int a, int b,
+                            const char *msg){
+  guint pos = (guint)g_atomic_int_get(&q->tail);
+  Slot *s;
+  for (;;) {
+    s = &q->slots[pos & q->mask];
+    gint dif = (gint)((guint)g_atomic_int_get(&s->seq) - pos);
+    if (dif == 0) {
+      if (g_atomic_int_compare_and_exchange(&q->tail, (gint)pos, (gint)(pos + 1))) break;
+      pos = (guint)g_atomic_int_get(&q->tail);
+    } else if (dif < 0) {
+      g_atomic_int_inc(&q->dropped);
+      return FALSE;
+    } else {
+      pos = (guint)g_atomic_int_get(&q->tail);
+    }
+  }
+  s->type = type;
+  s->a = a;
+  s->b = b;
+  s->has_msg = msg != NULL;
+  if (msg) g_strlcpy(s->msg, msg, sizeof(s->msg));
+  g_atomic_int_set(&s->seq, (gint)(pos + 1));
+
+  if (g_atomic_int_get(&q->sleeping)) {
+    g_mutex_lock(&q->lock);
+    g_cond_signal(&q->cond);
+    g_mutex_unlock(&q->lock);
+  }
+  return TRUE;
+}
+
+guint splash_events_dropped(SplashEventQueue *q){
+  return q ? (guint)g_atomic_int_get(&q->dropped) : 0;
+}
@@ -0,0 +1,37 @@
+#ifndef SPLASHEVENTS_H
+#define SPLASHEVENTS_H
+
+#include <glib.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Asynchronous delivery of SplashEventCb callbacks. Producers post into a
+// bounded lock-free ring (any number of threads, no allocation, callable with
+// engine locks held); a dispatcher thread drains it and runs the callback.
+// When the ring is full the event is dropped and counted. Messages longer than
+// SPLASH_EVENT_MSG_MAX-1 bytes are truncated.
+
+#define SPLASH_EVENT_MSG_MAX 128
+
+typedef struct SplashEventQueue SplashEventQueue;
+
+// capacity is rounded up to a power of two.
+SplashEventQueue* splash_events_new(guint capacity);
+// Delivers what is still queued, then stops the dispatcher.
+void splash_events_free(SplashEventQueue *q);
+
+void splash_events_set_callback(SplashEventQueue *q, SplashEventCb cb, void *user);
+
+// Never blocks and never runs user code. Returns FALSE if the event was dropped.
+gboolean splash_events_post(SplashEventQueue *q, SplashEventType type, int a, int b,
+                            const char *msg);
+
+guint splash_events_dropped(SplashEventQueue *q);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
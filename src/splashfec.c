@@ -0,0 +1,664 @@
+#include "splashfec.h"
+#include "splashrtp.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FEC_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define FEC_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define GF_POLY             0x11d  // x^8 + x^4 + x^3 + x^2 + 1
+#define RTP_HEADER_BYTES    12
+#define SYMBOL_HEADER_BYTES 2      // marker bit + payload length
+#define MAX_PAYLOAD         0x7fff
+#define SOURCE_SLOTS        1024   // power of two, so slots follow seq across its wrap
+#define BLOCK_SLOTS         32
+
+static guint8 gf_exp[512];
+static guint8 gf_log[256];
+
+static void gf_init(void){
+  static gsize done = 0;
+  if (!g_once_init_enter(&done)) return;
+  guint x = 1;
+  for (guint i = 0; i < 255; ++i) {
+    gf_exp[i] = (guint8)x;
+    gf_log[x] = (guint8)i;
+    x <<= 1;
+    if (x & 0x100) x ^= GF_POLY;
+  }
+  for (guint i = 255; i < G_N_ELEMENTS(gf_exp); ++i) gf_exp[i] = gf_exp[i - 255];
+  g_once_init_leave(&done, 1);
+}
+
+static guint8 gf_mul(guint8 a, guint8 b){
+  return a && b ? gf_exp[gf_log[a] + gf_log[b]] : 0;
+}
+
+static guint8 gf_inv(guint8 a){
+  return gf_exp[255 - gf_log[a]];
+}
+
+// Coefficient of source j in repair row i: a Cauchy matrix on x_i = 255 - i
+// and y_j = j, its columns scaled so that row 0 is all ones (plain XOR
+// parity). Every square submatrix stays invertible while k + r <= 256.
+static guint8 coef(guint i, guint j){
+  if (i == 0) return 1;
+  return gf_mul((guint8)(255 ^ j), gf_inv((guint8)((255 - i) ^ j)));
+}
+
+// c * x for the low and the high nibble of x, for table-lookup multiplies.
+static void nibble_tables(guint8 c, guint8 lo[16], guint8 hi[16]){
+  for (guint x = 0; x < 16; ++x) {
+    lo[x] = gf_mul(c, (guint8)x);
+    hi[x] = gf_mul(c, (guint8)(x << 4));
+  }
+}
+
+typedef void (*MulAddFn)(guint8 *dst, const guint8 *src, guint8 c, gsize len);
+
+static void mul_add_scalar(guint8 *dst, const guint8 *src, guint8 c, gsize len){
+  gsize i = 0;
+  if (c == 1) {
+    for (; i + 8 <= len; i += 8) {
+      guint64 a, b;
+      memcpy(&a, dst + i, 8);
+      memcpy(&b, src + i, 8);
+      a ^= b;
+      memcpy(dst + i, &a, 8);
+    }
+    for (; i < len; ++i) dst[i] ^= src[i];
+    return;
+  }
+  guint8 lo[16], hi[16];
+  nibble_tables(c, lo, hi);
+  for (; i < len; ++i) dst[i] ^= lo[src[i] & 0x0f] ^ hi[src[i] >> 4];
+}
+
+// The vector versions multiply 16/32 bytes per step with two 16-entry table
+// lookups (pshufb / tbl), one per nibble, and finish the tail in scalar.
+#ifdef FEC_X86
+__attribute__((target("ssse3")))
+static void mul_add_ssse3(guint8 *dst, const guint8 *src, guint8 c, gsize len){
+  guint8 lo[16], hi[16];
+  nibble_tables(c, lo, hi);
+  const __m128i tlo = _mm_loadu_si128((const __m128i*)(const void*)lo);
+  const __m128i thi = _mm_loadu_si128((const __m128i*)(const void*)hi);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  gsize i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(src + i));
+    __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, _mm_and_si128(v, mask)),
+                              _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(v, 4), mask)));
+    __m128i d = _mm_loadu_si128((const __m128i*)(void*)(dst + i));
+    _mm_storeu_si128((__m128i*)(void*)(dst + i), _mm_xor_si128(d, p));
+  }
+  mul_add_scalar(dst + i, src + i, c, len - i);
+}
+
+__attribute__((target("avx2")))
+static void mul_add_avx2(guint8 *dst, const guint8 *src, guint8 c, gsize len){
+  guint8 lo[16], hi[16];
+  nibble_tables(c, lo, hi);
+  const __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(const void*)lo));
+  const __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(const void*)hi));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  gsize i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(const void*)(src + i));
+    __m256i p = _mm256_xor_si256(
+      _mm256_shuffle_epi8(tlo, _mm256_and_si256(v, mask)),
+      _mm256_shuffle_epi8(thi, _mm256_and_si256(_mm256_srli_epi64(v, 4), mask)));
+    __m256i d = _mm256_loadu_si256((const __m256i*)(void*)(dst + i));
+    _mm256_storeu_si256((__m256i*)(void*)(dst + i), _mm256_xor_si256(d, p));
+  }
+  // The 16-byte step stays here, VEX-encoded: handing the tail to the SSSE3
+  // version costs an AVX/SSE transition per symbol
+  if (i + 16 <= len) {
+    const __m128i m = _mm256_castsi256_si128(mask);
+    __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(src + i));
+    __m128i p = _mm_xor_si128(
+      _mm_shuffle_epi8(_mm256_castsi256_si128(tlo), _mm_and_si128(v, m)),
+      _mm_shuffle_epi8(_mm256_castsi256_si128(thi), _mm_and_si128(_mm_srli_epi64(v, 4), m)));
+    __m128i d = _mm_loadu_si128((const __m128i*)(void*)(dst + i));
+    _mm_storeu_si128((__m128i*)(void*)(dst + i), _mm_xor_si128(d, p));
+    i += 16;
+  }
+  mul_add_scalar(dst + i, src + i, c, len - i);
+}
+#endif
+
+#ifdef FEC_NEON
+// vqtbl1q_u8 on AArch64; ARMv7 NEON looks up 8 lanes at a time with vtbl2_u8.
+static void mul_add_neon(guint8 *dst, const guint8 *src, guint8 c, gsize len){
+  guint8 lo[16], hi[16];
+  nibble_tables(c, lo, hi);
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+#ifdef __aarch64__
+  const uint8x16_t tlo = vld1q_u8(lo), thi = vld1q_u8(hi);
+#else
+  const uint8x8x2_t tlo = { { vld1_u8(lo), vld1_u8(lo + 8) } };
+  const uint8x8x2_t thi = { { vld1_u8(hi), vld1_u8(hi + 8) } };
+#endif
+  gsize i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(src + i);
+    uint8x16_t l = vandq_u8(v, mask), h = vshrq_n_u8(v, 4);
+#ifdef __aarch64__
+    uint8x16_t p = veorq_u8(vqtbl1q_u8(tlo, l), vqtbl1q_u8(thi, h));
+#else
+    uint8x16_t p = vcombine_u8(
+      veor_u8(vtbl2_u8(tlo, vget_low_u8(l)), vtbl2_u8(thi, vget_low_u8(h))),
+      veor_u8(vtbl2_u8(tlo, vget_high_u8(l)), vtbl2_u8(thi, vget_high_u8(h))));
+#endif
+    vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), p));
+  }
+  mul_add_scalar(dst + i, src + i, c, len - i);
+}
+#endif
+
+static gboolean impl_supported(SplashFecImpl impl){
+  switch (impl) {
+    case SPLASH_FEC_IMPL_SCALAR: return TRUE;
+#ifdef FEC_X86
+    case SPLASH_FEC_IMPL_SSSE3:  return __builtin_cpu_supports("ssse3");
+    case SPLASH_FEC_IMPL_AVX2:   return __builtin_cpu_supports("avx2");
+#endif
+#ifdef FEC_NEON
+    case SPLASH_FEC_IMPL_NEON:   return TRUE;
+#endif
+    default:                     return FALSE;
+  }
+}
+
+static MulAddFn impl_fn(SplashFecImpl impl){
+  switch (impl) {
+#ifdef FEC_X86
+    case SPLASH_FEC_IMPL_SSSE3: return mul_add_ssse3;
+    case SPLASH_FEC_IMPL_AVX2:  return mul_add_avx2;
+#endif
+#ifdef FEC_NEON
+    case SPLASH_FEC_IMPL_NEON:  return mul_add_neon;
+#endif
+    default:                    return mul_add_scalar;
+  }
+}
+
+static SplashFecImpl best_impl(void){
+  static const SplashFecImpl order[] = {
+    SPLASH_FEC_IMPL_AVX2, SPLASH_FEC_IMPL_SSSE3, SPLASH_FEC_IMPL_NEON,
+  };
+  for (gsize i = 0; i < G_N_ELEMENTS(order); ++i) {
+    if (impl_supported(order[i])) return order[i];
+  }
+  return SPLASH_FEC_IMPL_SCALAR;
+}
+
+static gint cur_impl = -1; // SplashFecImpl, -1 until first use
+
+static SplashFecImpl current_impl(void){
+  gint impl = g_atomic_int_get(&cur_impl);
+  if (impl < 0) {
+    impl = (gint)best_impl();
+    g_atomic_int_set(&cur_impl, impl);
+  }
+  return (SplashFecImpl)impl;
+}
+
+gboolean splash_fec_set_impl(SplashFecImpl impl){
+  if (impl == SPLASH_FEC_IMPL_AUTO) impl = best_impl();
+  if (!impl_supported(impl)) return FALSE;
+  g_atomic_int_set(&cur_impl, (gint)impl);
+  return TRUE;
+}
+
+SplashFecImpl splash_fec_get_impl(void){
+  return current_impl();
+}
+
+const char* splash_fec_impl_name(SplashFecImpl impl){
+  switch (impl) {
+    case SPLASH_FEC_IMPL_AUTO:   return "auto";
+    case SPLASH_FEC_IMPL_SCALAR: return "scalar";
+    case SPLASH_FEC_IMPL_SSSE3:  return "ssse3";
+    case SPLASH_FEC_IMPL_AVX2:   return "avx2";
+    case SPLASH_FEC_IMPL_NEON:   return "neon";
+  }
+  return "?";
+}
+
+void splash_fec_mul_add(guint8 *dst, const guint8 *src, guint8 c, gsize len){
+  if (!dst || !src || c == 0 || len == 0) return;
+  gf_init();
+  impl_fn(current_impl())(dst, src, c, len);
+}
+
+static void put_be16(guint8 *p, guint16 v){
+  p[0] = (guint8)(v >> 8);
+  p[1] = (guint8)v;
+}
+
+static void put_be32(guint8 *p, guint32 v){
+  p[0] = (guint8)(v >> 24);
+  p[1] = (guint8)(v >> 16);
+  p[2] = (guint8)(v >> 8);
+  p[3] = (guint8)v;
+}
+
+static guint32 be32(const guint8 *p){
+  return (guint32)p[0] << 24 | (guint32)p[1] << 16 | (guint32)p[2] << 8 | p[3];
+}
+
+// Adds c * (symbol header + payload) to a symbol.
+static void add_symbol(guint8 *sym, guint8 c, gboolean marker, const guint8 *payload, gsize len){
+  sym[0] ^= gf_mul(c, (guint8)((marker ? 0x80 : 0) | (len >> 8)));
+  sym[1] ^= gf_mul(c, (guint8)len);
+  splash_fec_mul_add(sym + SYMBOL_HEADER_BYTES, payload, c, len);
+}
+
+// Plain RTP header followed by a payload.
+static void build_packet(GByteArray *out, gboolean marker, guint8 pt, guint16 seq, guint32 ts,
+                         guint32 ssrc, const guint8 *payload, gsize len){
+  g_byte_array_set_size(out, RTP_HEADER_BYTES);
+  guint8 *h = out->data;
+  h[0] = 0x80;
+  h[1] = (guint8)((marker ? 0x80 : 0) | (pt & 0x7f));
+  put_be16(h + 2, seq);
+  put_be32(h + 4, ts);
+  put_be32(h + 8, ssrc);
+  g_byte_array_append(out, payload, (guint)len);
+}
+
+// ---- encoder ----
+
+typedef struct {
+  guint8 *data;   // payload
+  gsize len;
+  gsize alloc;
+  gboolean marker;
+} Source;
+
+struct SplashFecEnc {
+  gint refs;          // atomic
+  GMutex lock;
+  SplashFecScheme scheme;
+  guint k;
+  guint n;
+  guint8 pt;
+  guint32 ssrc;
+  guint16 seq;
+  Source *src;        // block being collected
+  guint count;
+  guint16 base_seq;
+  guint32 ts;
+  guint32 media_ssrc;
+  guint8 media_pt;
+  guint8 *parity;     // repair symbols of the block
+  gsize parity_alloc;
+  GByteArray *pkt;    // repair packet being built
+  GByteArray *fec;    // FEC header + symbol
+  SplashFecStats st;
+};
+
+SplashFecEnc* splash_fec_enc_new(SplashFecScheme scheme, guint k, guint n,
+                                 guint8 payload_type, guint32 ssrc, guint16 seq){
+  if (scheme == SPLASH_FEC_OFF || k == 0) return NULL;
+  gf_init();
+  SplashFecEnc *e = g_new0(SplashFecEnc, 1);
+  e->refs = 1;
+  e->scheme = scheme;
+  e->k = MIN(k, SPLASH_FEC_MAX_N - 1);
+  e->n = scheme == SPLASH_FEC_XOR ? e->k + 1 : CLAMP(n, e->k + 1, SPLASH_FEC_MAX_N);
+  e->pt = payload_type & 0x7f;
+  e->ssrc = ssrc;
+  e->seq = seq;
+  e->src = g_new0(Source, e->k);
+  e->pkt = g_byte_array_new();
+  e->fec = g_byte_array_new();
+  g_mutex_init(&e->lock);
+  return e;
+}
+
+SplashFecEnc* splash_fec_enc_ref(SplashFecEnc *e){
+  if (e) g_atomic_int_inc(&e->refs);
+  return e;
+}
+
+void splash_fec_enc_unref(SplashFecEnc *e){
+  if (!e || !g_atomic_int_dec_and_test(&e->refs)) return;
+  for (guint j = 0; j < e->k; ++j) g_free(e->src[j].data);
+  g_free(e->src);
+  g_free(e->parity);
+  g_byte_array_free(e->pkt, TRUE);
+  g_byte_array_free(e->fec, TRUE);
+  g_mutex_clear(&e->lock);
+  g_free(e);
+}
+
+// Repair packets for a block of count sources: n - k per k, rounded up.
+static guint repairs_for(const SplashFecEnc *e, guint count){
+  if (e->scheme == SPLASH_FEC_XOR) return 1;
+  return MAX(1, (count * (e->n - e->k) + e->k - 1) / e->k);
+}
+
+// Encodes the collected block and sends its repair packets. Caller holds e->lock.
+static guint close_block_locked(SplashFecEnc *e, SplashFecPacketFn fn, gpointer user){
+  if (e->count == 0) return 0;
+  gint64 t0 = g_get_monotonic_time();
+  guint r = repairs_for(e, e->count);
+  gsize sym = 0;
+  for (guint j = 0; j < e->count; ++j) sym = MAX(sym, e->src[j].len);
+  sym += SYMBOL_HEADER_BYTES;
+  gsize need = (gsize)r * sym;
+  if (e->parity_alloc < need) {
+    e->parity = g_realloc(e->parity, need);
+    e->parity_alloc = need;
+  }
+  memset(e->parity, 0, need);
+  for (guint j = 0; j < e->count; ++j) {
+    const Source *s = &e->src[j];
+    for (guint i = 0; i < r; ++i) {
+      add_symbol(e->parity + (gsize)i * sym, coef(i, j), s->marker, s->data, s->len);
+    }
+  }
+  e->st.encode_us += g_get_monotonic_time() - t0;
+
+  for (guint i = 0; i < r; ++i) {
+    g_byte_array_set_size(e->fec, SPLASH_FEC_HEADER_BYTES);
+    guint8 *f = e->fec->data;
+    put_be32(f, e->media_ssrc);
+    put_be16(f + 4, e->base_seq);
+    f[6] = (guint8)e->count;
+    f[7] = (guint8)r;
+    f[8] = (guint8)i;
+    f[9] = e->media_pt;
+    g_byte_array_append(e->fec, e->parity + (gsize)i * sym, (guint)sym);
+    build_packet(e->pkt, i + 1 == r, e->pt, e->seq++, e->ts, e->ssrc, e->fec->data, e->fec->len);
+    e->st.repair_packets++;
+    e->st.repair_bytes += e->fec->len;
+    if (fn) fn(e->pkt->data, e->pkt->len, user);
+  }
+  e->st.blocks++;
+  e->count = 0;
+  return r;
+}
+
+guint splash_fec_enc_push(SplashFecEnc *e, const guint8 *pkt, gsize len,
+                          SplashFecPacketFn fn, gpointer user){
+  SplashRtpHeader h;
+  if (!e || !splash_rtp_parse_header(pkt, len, &h) || h.payload_len > MAX_PAYLOAD) return 0;
+  guint sent = 0;
+  g_mutex_lock(&e->lock);
+  // A block holds consecutive packets of one frame of one stream
+  if (e->count > 0 && (h.ssrc != e->media_ssrc || h.ts != e->ts || h.pt != e->media_pt ||
+                       h.seq != (guint16)(e->base_seq + e->count))) {
+    sent += close_block_locked(e, fn, user);
+  }
+  if (e->count == 0) {
+    e->base_seq = h.seq;
+    e->ts = h.ts;
+    e->media_ssrc = h.ssrc;
+    e->media_pt = h.pt;
+  }
+  Source *s = &e->src[e->count++];
+  if (s->alloc < h.payload_len) {
+    s->data = g_realloc(s->data, h.payload_len);
+    s->alloc = h.payload_len;
+  }
+  memcpy(s->data, pkt + h.payload, h.payload_len);
+  s->len = h.payload_len;
+  s->marker = h.marker;
+  e->st.source_packets++;
+  e->st.source_bytes += h.payload_len;
+  if (h.marker || e->count == e->k) sent += close_block_locked(e, fn, user);
+  g_mutex_unlock(&e->lock);
+  return sent;
+}
+
+void splash_fec_enc_get_stats(SplashFecEnc *e, SplashFecStats *out){
+  if (!e || !out) return;
+  g_mutex_lock(&e->lock);
+  *out = e->st;
+  g_mutex_unlock(&e->lock);
+}
+
+void splash_fec_enc_reset_stats(SplashFecEnc *e){
+  if (!e) return;
+  g_mutex_lock(&e->lock);
+  memset(&e->st, 0, sizeof(e->st));
+  g_mutex_unlock(&e->lock);
+}
+
+// ---- decoder ----
+
+typedef struct {
+  guint8 *data;   // payload
+  gsize len;
+  gsize alloc;
+  gboolean marker;
+  guint16 seq;
+  gboolean used;
+} Stored;
+
+typedef struct {
+  gboolean used;
+  gboolean done;
+  guint64 age;
+  guint32 media_ssrc;
+  guint16 base_seq;
+  guint k;
+  guint r;
+  guint8 media_pt;
+  guint32 ts;
+  gsize sym;
+  guint8 *rows;   // r repair symbols
+  gsize alloc;
+  guint8 have[SPLASH_FEC_MAX_N];
+  guint received;
+} Block;
+
+struct SplashFecDec {
+  gboolean have_media;
+  guint32 media_ssrc;
+  Stored src[SOURCE_SLOTS];
+  Block blocks[BLOCK_SLOTS];
+  guint64 clock;
+  GByteArray *pkt;
+};
+
+SplashFecDec* splash_fec_dec_new(void){
+  gf_init();
+  SplashFecDec *d = g_new0(SplashFecDec, 1);
+  d->pkt = g_byte_array_new();
+  return d;
+}
+
+void splash_fec_dec_free(SplashFecDec *d){
+  if (!d) return;
+  for (guint i = 0; i < SOURCE_SLOTS; ++i) g_free(d->src[i].data);
+  for (guint i = 0; i < BLOCK_SLOTS; ++i) g_free(d->blocks[i].rows);
+  g_byte_array_free(d->pkt, TRUE);
+  g_free(d);
+}
+
+static void store_source(SplashFecDec *d, guint32 ssrc, guint16 seq, gboolean marker,
+                         const guint8 *payload, gsize len){
+  if (!d->have_media || ssrc != d->media_ssrc) {
+    // New stream: what is stored belongs to the old one
+    for (guint i = 0; i < SOURCE_SLOTS; ++i) d->src[i].used = FALSE;
+    d->media_ssrc = ssrc;
+    d->have_media = TRUE;
+  }
+  Stored *s = &d->src[seq & (SOURCE_SLOTS - 1)];
+  if (s->alloc < len) {
+    s->data = g_realloc(s->data, len);
+    s->alloc = len;
+  }
+  memcpy(s->data, payload, len);
+  s->len = len;
+  s->marker = marker;
+  s->seq = seq;
+  s->used = TRUE;
+}
+
+void splash_fec_dec_add_source(SplashFecDec *d, const guint8 *pkt, gsize len){
+  SplashRtpHeader h;
+  if (!d || !splash_rtp_parse_header(pkt, len, &h) || h.payload_len > MAX_PAYLOAD) return;
+  store_source(d, h.ssrc, h.seq, h.marker, pkt + h.payload, h.payload_len);
+}
+
+static const Stored* known_source(const SplashFecDec *d, const Block *b, guint j){
+  const Stored *s = &d->src[(guint16)(b->base_seq + j) & (SOURCE_SLOTS - 1)];
+  if (!d->have_media || d->media_ssrc != b->media_ssrc || !s->used ||
+      s->seq != (guint16)(b->base_seq + j)) {
+    return NULL;
+  }
+  return s;
+}
+
+// Gauss-Jordan inversion of the m x m matrix a (destroyed) into inv.
+static gboolean invert(guint8 *a, guint8 *inv, guint m){
+  memset(inv, 0, (gsize)m * m);
+  for (guint i = 0; i < m; ++i) inv[i * m + i] = 1;
+  for (guint col = 0; col < m; ++col) {
+    guint p = col;
+    while (p < m && a[p * m + col] == 0) p++;
+    if (p == m) return FALSE;
+    if (p != col) {
+      for (guint x = 0; x < m; ++x) {
+        guint8 t = a[p * m + x]; a[p * m + x] = a[col * m + x]; a[col * m + x] = t;
+        t = inv[p * m + x]; inv[p * m + x] = inv[col * m + x]; inv[col * m + x] = t;
+      }
+    }
+    guint8 scale = gf_inv(a[col * m + col]);
+    for (guint x = 0; x < m; ++x) {
+      a[col * m + x] = gf_mul(a[col * m + x], scale);
+      inv[col * m + x] = gf_mul(inv[col * m + x], scale);
+    }
+    for (guint row = 0; row < m; ++row) {
+      guint8 f = a[row * m + col];
+      if (row == col || f == 0) continue;
+      for (guint x = 0; x < m; ++x) {
+        a[row * m + x] ^= gf_mul(f, a[col * m + x]);
+        inv[row * m + x] ^= gf_mul(f, inv[col * m + x]);
+      }
+    }
+  }
+  return TRUE;
+}
+
+// Rebuilds the missing sources of a block once enough repair symbols are in.
+static guint recover(SplashFecDec *d, Block *b, SplashFecPacketFn fn, gpointer user){
+  guint missing[SPLASH_FEC_MAX_N], m = 0;
+  for (guint j = 0; j < b->k; ++j) {
+    const Stored *s = known_source(d, b, j);
+    if (!s) {
+      missing[m++] = j;
+    } else if (s->len + SYMBOL_HEADER_BYTES > b->sym) {
+      b->done = TRUE;  // not the packets this block was built from
+      return 0;
+    }
+  }
+  if (m == 0) {
+    b->done = TRUE;
+    return 0;
+  }
+  if (m > b->received) return 0;
+
+  guint rows[SPLASH_FEC_MAX_N], n = 0;
+  for (guint i = 0; i < b->r && n < m; ++i) {
+    if (b->have[i]) rows[n++] = i;
+  }
+  // Take the known sources out of the repair symbols, leaving the missing
+  // ones' contributions (the block is done afterwards, so in place)
+  for (guint a = 0; a < m; ++a) {
+    guint8 *y = b->rows + (gsize)rows[a] * b->sym;
+    for (guint j = 0; j < b->k; ++j) {
+      const Stored *s = known_source(d, b, j);
+      if (s) add_symbol(y, coef(rows[a], j), s->marker, s->data, s->len);
+    }
+  }
+  guint8 *mat = g_malloc((gsize)m * m * 2);
+  guint8 *inv = mat + (gsize)m * m;
+  for (guint a = 0; a < m; ++a) {
+    for (guint c = 0; c < m; ++c) mat[a * m + c] = coef(rows[a], missing[c]);
+  }
+  b->done = TRUE;
+  if (!invert(mat, inv, m)) {
+    g_free(mat);
+    return 0;
+  }
+  guint8 *x = g_malloc(b->sym);
+  guint recovered = 0;
+  for (guint c = 0; c < m; ++c) {
+    memset(x, 0, b->sym);
+    for (guint a = 0; a < m; ++a) {
+      splash_fec_mul_add(x, b->rows + (gsize)rows[a] * b->sym, inv[c * m + a], b->sym);
+    }
+    gboolean marker = (x[0] & 0x80) != 0;
+    gsize len = (gsize)(x[0] & 0x7f) << 8 | x[1];
+    if (len + SYMBOL_HEADER_BYTES > b->sym) continue;
+    guint16 seq = (guint16)(b->base_seq + missing[c]);
+    store_source(d, b->media_ssrc, seq, marker, x + SYMBOL_HEADER_BYTES, len);
+    build_packet(d->pkt, marker, b->media_pt, seq, b->ts, b->media_ssrc,
+                 x + SYMBOL_HEADER_BYTES, len);
+    if (fn) fn(d->pkt->data, d->pkt->len, user);
+    recovered++;
+  }
+  g_free(x);
+  g_free(mat);
+  return recovered;
+}
+
+guint splash_fec_dec_add_repair(SplashFecDec *d, const guint8 *pkt, gsize len,
+                                SplashFecPacketFn fn, gpointer user){
+  SplashRtpHeader h;
+  if (!d || !splash_rtp_parse_header(pkt, len, &h) ||
+      h.payload_len < SPLASH_FEC_HEADER_BYTES + SYMBOL_HEADER_BYTES) {
+    return 0;
+  }
+  const guint8 *f = pkt + h.payload;
+  guint32 media_ssrc = be32(f);
+  guint16 base_seq = (guint16)(f[4] << 8 | f[5]);
+  guint k = f[6], r = f[7], index = f[8];
+  gsize sym = h.payload_len - SPLASH_FEC_HEADER_BYTES;
+  if (k == 0 || r == 0 || index >= r || k + r > 256) return 0;
+
+  Block *b = NULL, *oldest = &d->blocks[0];
+  for (guint i = 0; i < BLOCK_SLOTS && !b; ++i) {
+    Block *c = &d->blocks[i];
+    if (c->used && c->media_ssrc == media_ssrc && c->base_seq == base_seq &&
+        c->k == k && c->r == r && c->sym == sym) {
+      b = c;
+    } else if (!c->used || (oldest->used && c->age < oldest->age)) {
+      oldest = c;
+    }
+  }
+  if (!b) {
+    b = oldest;
+    b->used = TRUE;
+    b->done = FALSE;
+    b->media_ssrc = media_ssrc;
+    b->base_seq = base_seq;
+    b->k = k;
+    b->r = r;
+    b->media_pt = f[9] & 0x7f;
+    b->ts = h.ts;
+    b->sym = sym;
+    b->received = 0;
+    memset(b->have, 0, sizeof(b->have));
+    if (b->alloc < (gsize)r * sym) {
+      b->rows = g_realloc(b->rows, (gsize)r * sym);
+      b->alloc = (gsize)r * sym;
+    }
+  }
+  b->age = ++d->clock;
+  if (b->done || b->have[index]) return 0;
+  memcpy(b->rows + (gsize)index * sym, f + SPLASH_FEC_HEADER_BYTES, sym);
+  b->have[index] = 1;
+  b->received++;
+  return recover(d, b, fn, user);
+}
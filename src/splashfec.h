@@ -0,0 +1,91 @@
+#ifndef SPLASHFEC_H
+#define SPLASHFEC_H
+
+#include <glib.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward error correction for the UDP output, for links without a return
+// path. The RTP packets of each frame are cut into blocks of up to k source
+// packets, and every block is followed by repair packets: one XOR parity
+// packet, or n - k Reed-Solomon packets (a Cauchy code over GF(2^8) whose
+// first row is the XOR parity). Any k of a block's packets restore it.
+//
+// Repair packets are RTP packets on their own SSRC, sequence numbers and
+// payload type, carrying this header before the coded symbol:
+//
+//   media SSRC (32) | first source seq (16) | k (8) | repair count (8) |
+//   repair index (8) | media payload type (8)
+//
+// A symbol is a source packet's payload behind 16 bits of marker bit and
+// payload length, zero-padded to the block's longest. Source packets are
+// restored with a plain 12-byte RTP header, which is all rtph265pay writes.
+// The GF(2^8) multiply-add runs with SSSE3/AVX2 on x86-64 and NEON on ARM
+// (picked at runtime where the CPU may lack them), scalar elsewhere.
+
+#define SPLASH_FEC_HEADER_BYTES 10
+// A repair packet exceeds the largest packet it protects by this much; the
+// payloader's MTU is reduced by it so repair packets fit the path.
+#define SPLASH_FEC_OVERHEAD (SPLASH_FEC_HEADER_BYTES + 2)
+#define SPLASH_FEC_MAX_N 255
+
+typedef enum {
+  SPLASH_FEC_IMPL_AUTO = 0, // best implementation the CPU supports
+  SPLASH_FEC_IMPL_SCALAR,
+  SPLASH_FEC_IMPL_SSSE3,
+  SPLASH_FEC_IMPL_AVX2,
+  SPLASH_FEC_IMPL_NEON,
+} SplashFecImpl;
+
+// Forces an implementation (for benchmarks). Returns FALSE, leaving the
+// current one in place, when this build or CPU does not support it.
+gboolean splash_fec_set_impl(SplashFecImpl impl);
+SplashFecImpl splash_fec_get_impl(void);
+const char* splash_fec_impl_name(SplashFecImpl impl);
+
+// dst[i] ^= c * src[i] in GF(2^8), for i < len.
+void splash_fec_mul_add(guint8 *dst, const guint8 *src, guint8 c, gsize len);
+
+// Called once per repair or recovered packet; pkt is only valid during the call.
+typedef void (*SplashFecPacketFn)(const guint8 *pkt, gsize len, gpointer user);
+
+typedef struct SplashFecEnc SplashFecEnc;
+
+// k source packets per block; n is only used by SPLASH_FEC_RS (k < n <= 255).
+// The result holds one reference; sender pipelines hold their own while
+// they may still push packets.
+SplashFecEnc* splash_fec_enc_new(SplashFecScheme scheme, guint k, guint n,
+                                 guint8 payload_type, guint32 ssrc, guint16 seq);
+SplashFecEnc* splash_fec_enc_ref(SplashFecEnc *e);
+void          splash_fec_enc_unref(SplashFecEnc *e);
+
+// Adds one sent media packet. A block ends after k packets, on the marker
+// bit (end of frame), or when the next frame starts; its repair packets go
+// to fn before this returns. Returns the number of repair packets. Thread-safe.
+guint splash_fec_enc_push(SplashFecEnc *e, const guint8 *pkt, gsize len,
+                          SplashFecPacketFn fn, gpointer user);
+
+void splash_fec_enc_get_stats(SplashFecEnc *e, SplashFecStats *out);
+void splash_fec_enc_reset_stats(SplashFecEnc *e);
+
+typedef struct SplashFecDec SplashFecDec;
+
+SplashFecDec* splash_fec_dec_new(void);
+void          splash_fec_dec_free(SplashFecDec *d);
+
+// Remembers a received media packet (the last 1024 are kept).
+void  splash_fec_dec_add_source(SplashFecDec *d, const guint8 *pkt, gsize len);
+
+// Takes a repair packet. Once its block has as many packets as it has
+// sources, the missing ones are rebuilt and handed to fn (and remembered).
+// Returns the number recovered.
+guint splash_fec_dec_add_repair(SplashFecDec *d, const guint8 *pkt, gsize len,
+                                SplashFecPacketFn fn, gpointer user);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
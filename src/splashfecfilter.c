@@ -0,0 +1,102 @@
+#include "splashfecfilter.h"
+
+struct _SplashFecFilter {
+  GstElement parent;
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  SplashFecEnc *enc;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+  GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS("application/x-rtp"));
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE("src",
+  GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS("application/x-rtp"));
+
+G_DEFINE_TYPE(SplashFecFilter, splash_fec_filter, GST_TYPE_ELEMENT)
+
+typedef struct {
+  GstBuffer *media;       // the repair packets take its timestamps
+  GstBufferList *repair;
+} Repair;
+
+static void collect_repair(const guint8 *pkt, gsize len, gpointer user){
+  Repair *r = (Repair*)user;
+  GstBuffer *buf = gst_buffer_new_allocate(NULL, len, NULL);
+  gst_buffer_fill(buf, 0, pkt, len);
+  gst_buffer_copy_into(buf, r->media, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  if (!r->repair) r->repair = gst_buffer_list_new();
+  gst_buffer_list_add(r->repair, buf);
+}
+
+static void encode(SplashFecFilter *self, GstBuffer *buf, Repair *r){
+  GstMapInfo map;
+  if (!gst_buffer_map(buf, &map, GST_MAP_READ)) return;
+  r->media = buf;
+  splash_fec_enc_push(self->enc, map.data, map.size, collect_repair, r);
+  gst_buffer_unmap(buf, &map);
+}
+
+// The media goes first; repair packets only follow what was sent.
+static GstFlowReturn push_repair(SplashFecFilter *self, GstFlowReturn fr, GstBufferList *repair){
+  if (!repair) return fr;
+  if (fr != GST_FLOW_OK) {
+    gst_buffer_list_unref(repair);
+    return fr;
+  }
+  return gst_pad_push_list(self->srcpad, repair);
+}
+
+static GstFlowReturn splash_fec_filter_chain(GstPad *pad, GstObject *parent, GstBuffer *buf){
+  (void)pad;
+  SplashFecFilter *self = SPLASH_FEC_FILTER(parent);
+  Repair r = { NULL, NULL };
+  encode(self, buf, &r);
+  return push_repair(self, gst_pad_push(self->srcpad, buf), r.repair);
+}
+
+static GstFlowReturn splash_fec_filter_chain_list(GstPad *pad, GstObject *parent,
+                                                  GstBufferList *list){
+  (void)pad;
+  SplashFecFilter *self = SPLASH_FEC_FILTER(parent);
+  Repair r = { NULL, NULL };
+  guint n = gst_buffer_list_length(list);
+  for (guint i = 0; i < n; ++i) encode(self, gst_buffer_list_get(list, i), &r);
+  return push_repair(self, gst_pad_push_list(self->srcpad, list), r.repair);
+}
+
+static void splash_fec_filter_finalize(GObject *obj){
+  SplashFecFilter *self = SPLASH_FEC_FILTER(obj);
+  splash_fec_enc_unref(self->enc);
+  G_OBJECT_CLASS(splash_fec_filter_parent_class)->finalize(obj);
+}
+
+static void splash_fec_filter_class_init(SplashFecFilterClass *klass){
+  GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+  gobject_class->finalize = splash_fec_filter_finalize;
+  gst_element_class_add_static_pad_template(element_class, &sink_template);
+  gst_element_class_add_static_pad_template(element_class, &src_template);
+  gst_element_class_set_static_metadata(element_class,
+    "Splash FEC filter", "Filter/Network/RTP",
+    "Appends XOR/Reed-Solomon repair packets to an RTP stream", "splashscreen");
+}
+
+static void splash_fec_filter_init(SplashFecFilter *self){
+  self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+  gst_pad_set_chain_function(self->sinkpad, splash_fec_filter_chain);
+  gst_pad_set_chain_list_function(self->sinkpad, splash_fec_filter_chain_list);
+  GST_PAD_SET_PROXY_CAPS(self->sinkpad);
+  GST_PAD_SET_PROXY_ALLOCATION(self->sinkpad);
+  gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+  GST_PAD_SET_PROXY_CAPS(self->srcpad);
+  gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+}
+
+GstElement* splash_fec_filter_new(SplashFecEnc *enc){
+  if (!enc) return NULL;
+  SplashFecFilter *self = g_object_new(SPLASH_TYPE_FEC_FILTER, "name", "fec", NULL);
+  self->enc = splash_fec_enc_ref(enc);
+  return GST_ELEMENT(self);
+}
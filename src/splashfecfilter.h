@@ -0,0 +1,22 @@
+#ifndef SPLASHFECFILTER_H
+#define SPLASHFECFILTER_H
+
+#include <gst/gst.h>
+#include "splashfec.h"
+
+G_BEGIN_DECLS
+
+// RTP filter between the sender's payloader and udpsink: passes the media
+// packets through and, when one ends an FEC block, pushes the block's repair
+// packets right behind it. Flow returns reach the payloader as usual.
+// Private to the library; it is linked in by hand, not through a factory.
+
+#define SPLASH_TYPE_FEC_FILTER (splash_fec_filter_get_type())
+G_DECLARE_FINAL_TYPE(SplashFecFilter, splash_fec_filter, SPLASH, FEC_FILTER, GstElement)
+
+// The element holds its own reference on enc.
+GstElement* splash_fec_filter_new(SplashFecEnc *enc);
+
+G_END_DECLS
+
+#endif
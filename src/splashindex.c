@@ -0,0 +1,311 @@
+#include "splashindex.h"
+#include "splashscan.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IDX_MAGIC        "SPLIDX01"
+#define IDX_VERSION      2
+#define IDX_BYTE_ORDER   0x01020304u
+#define IDX_HASH_SAMPLE  (64 * 1024)
+
+typedef struct {
+  char    magic[8];
+  guint32 byte_order;
+  guint32 version;
+  guint32 header_size;
+  guint32 reserved;
+  guint64 src_size;
+  gint64  src_mtime_ns;
+  guint64 src_hash;
+  guint32 n_aus;
+  guint32 n_ps;
+} IdxHeader;
+
+// ---- source fingerprint ----
+static guint64 fnv1a(guint64 h, const guint8 *p, gsize n){
+  for (gsize i = 0; i < n; ++i) { h ^= p[i]; h *= 0x100000001b3ull; }
+  return h;
+}
+
+// FNV-1a over the first and last IDX_HASH_SAMPLE bytes plus the length. Cheap
+// enough to run on every boot, and catches in-place rewrites that keep mtime.
+static gboolean sample_hash(const char *src_path, const guint8 *data, gsize len,
+                            guint64 *out){
+  guint64 h = 0xcbf29ce484222325ull;
+  h = fnv1a(h, (const guint8*)&len, sizeof(len));
+  gsize head = MIN(len, (gsize)IDX_HASH_SAMPLE);
+  gsize tail_off = len > IDX_HASH_SAMPLE ? len - IDX_HASH_SAMPLE : 0;
+  if (data) {
+    h = fnv1a(h, data, head);
+    h = fnv1a(h, data + tail_off, len - tail_off);
+    *out = h;
+    return TRUE;
+  }
+  int fd = open(src_path, O_RDONLY);
+  if (fd < 0) return FALSE;
+  guint8 *buf = g_malloc(IDX_HASH_SAMPLE);
+  gboolean ok = pread(fd, buf, head, 0) == (ssize_t)head;
+  if (ok) h = fnv1a(h, buf, head);
+  if (ok) ok = pread(fd, buf, len - tail_off, (off_t)tail_off) == (ssize_t)(len - tail_off);
+  if (ok) h = fnv1a(h, buf, len - tail_off);
+  g_free(buf);
+  close(fd);
+  if (ok) *out = h;
+  return ok;
+}
+
+static gboolean stat_source(const char *src_path, guint64 *size, gint64 *mtime_ns, GError **err){
+  struct stat st;
+  if (stat(src_path, &st) != 0) {
+    g_set_error(err, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                "stat('%s') failed: %s", src_path, g_strerror(errno));
+    return FALSE;
+  }
+  *size = (guint64)st.st_size;
+  *mtime_ns = (gint64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  return TRUE;
+}
+
+static guint8 highest_tid(const SplashAuEntry *aus, guint n){
+  guint8 max = 0;
+  for (guint i = 0; i < n; ++i) max = MAX(max, aus[i].tid);
+  return max;
+}
+
+// ---- Annex-B scanning ----
+static gboolean is_vcl(guint8 t){ return t < 32; }
+
+// NAL types that may only appear before the first VCL NAL of an AU, so they
+// open a new AU once the current one has slice data (H.265 7.4.2.4.4).
+static gboolean is_au_prefix(guint8 t){
+  return t == SPLASH_NAL_AUD || t == SPLASH_NAL_VPS || t == SPLASH_NAL_SPS ||
+         t == SPLASH_NAL_PPS || t == SPLASH_NAL_SEI_PREFIX ||
+         (t >= 41 && t <= 44) || (t >= 48 && t <= 55);
+}
+
+SplashIndex* splash_index_build(const guint8 *data, gsize len, guint max_threads,
+                                guint *threads_used){
+  if (threads_used) *threads_used = 0;
+  if (!data || len < 4) return NULL;
+  // Start codes are located up front (vectorised, split across threads); the
+  // NAL walk below only reads the headers they point at.
+  GArray *codes = g_array_new(FALSE, FALSE, sizeof(guint64));
+  guint threads = splash_scan_all(data, len, max_threads, codes);
+  if (threads_used) *threads_used = threads;
+  const guint64 *sc_at = (const guint64*)(void*)codes->data;
+
+  GArray *aus = g_array_new(FALSE, FALSE, sizeof(SplashAuEntry));
+  GArray *ps  = g_array_new(FALSE, FALSE, sizeof(SplashPsEntry));
+
+  SplashAuEntry cur; memset(&cur, 0, sizeof(cur));
+  gboolean open_au = FALSE, has_vcl = FALSE;
+  gsize au_end = 0;
+
+  for (guint i = 0; i < codes->len; ++i) {
+    gsize sc = sc_at[i];
+    gsize nal = sc + 3;
+    gsize nal_start = (sc > 0 && data[sc - 1] == 0) ? sc - 1 : sc; // 4-byte start code
+    gsize next = i + 1 < codes->len ? sc_at[i + 1] : len;
+    gsize nal_end = next;
+    if (next < len && next > 0 && data[next - 1] == 0) nal_end = next - 1;
+    if (nal + 2 > nal_end) continue; // truncated header
+
+    guint8 type = (data[nal] >> 1) & 0x3f;
+    gboolean first_slice = is_vcl(type) && nal + 2 < nal_end && (data[nal + 2] & 0x80);
+    if (open_au && has_vcl && (is_au_prefix(type) || first_slice)) {
+      cur.size = (guint32)(au_end - cur.offset);
+      g_array_append_val(aus, cur);
+      open_au = FALSE;
+    }
+    if (!open_au) {
+      memset(&cur, 0, sizeof(cur));
+      cur.offset = nal_start;
+      cur.ps_first = ps->len;
+      cur.vcl_type = 0xff;
+      open_au = TRUE;
+      has_vcl = FALSE;
+    }
+
+    if (is_vcl(type)) {
+      if (!has_vcl) {
+        cur.vcl_type = type;
+        guint8 tid_plus1 = data[nal + 1] & 0x07;
+        cur.tid = tid_plus1 ? (guint8)(tid_plus1 - 1) : 0;
+        if (type >= SPLASH_NAL_IRAP_FIRST && type <= SPLASH_NAL_IRAP_LAST) cur.flags |= SPLASH_AU_IRAP;
+      }
+      has_vcl = TRUE;
+    } else if (type >= SPLASH_NAL_VPS && type <= SPLASH_NAL_PPS) {
+      SplashPsEntry e; memset(&e, 0, sizeof(e));
+      e.offset = nal_start;
+      e.size = (guint32)(nal_end - nal_start);
+      e.nal_type = type;
+      g_array_append_val(ps, e);
+      if (cur.ps_count < G_MAXUINT8) cur.ps_count++;
+      cur.flags |= (type == SPLASH_NAL_VPS) ? SPLASH_AU_HAS_VPS :
+                   (type == SPLASH_NAL_SPS) ? SPLASH_AU_HAS_SPS : SPLASH_AU_HAS_PPS;
+    } else if (type == SPLASH_NAL_AUD) {
+      cur.flags |= SPLASH_AU_HAS_AUD;
+    }
+    au_end = nal_end;
+  }
+  if (open_au && has_vcl) {
+    cur.size = (guint32)(len - cur.offset);
+    g_array_append_val(aus, cur);
+  }
+  g_array_free(codes, TRUE);
+
+  if (aus->len == 0) {
+    g_array_free(aus, TRUE);
+    g_array_free(ps, TRUE);
+    return NULL;
+  }
+  SplashIndex *idx = g_new0(SplashIndex, 1);
+  idx->au_arr = aus;
+  idx->ps_arr = ps;
+  idx->aus = (const SplashAuEntry*)(void*)aus->data;
+  idx->n_aus = aus->len;
+  idx->ps = (const SplashPsEntry*)(void*)ps->data;
+  idx->n_ps = ps->len;
+  idx->max_tid = highest_tid(idx->aus, idx->n_aus);
+  return idx;
+}
+
+// ---- sidecar I/O ----
+// Checks a sidecar's header and overall size; fills *h. Returns why it is
+// unusable, or NULL.
+static const char* check_header(const guint8 *base, gsize len, IdxHeader *h){
+  if (len < sizeof(*h)) return "truncated header";
+  memcpy(h, base, sizeof(*h));
+  guint64 want = (guint64)h->header_size +
+                 (guint64)h->n_aus * sizeof(SplashAuEntry) +
+                 (guint64)h->n_ps * sizeof(SplashPsEntry);
+  if (memcmp(h->magic, IDX_MAGIC, 8) != 0)  return "bad magic";
+  if (h->byte_order != IDX_BYTE_ORDER)      return "foreign byte order";
+  if (h->version != IDX_VERSION)            return "unsupported version";
+  if (h->header_size != sizeof(*h))         return "unexpected header size";
+  if (want != len || h->n_aus == 0)         return "size mismatch";
+  return NULL;
+}
+
+// Checks that every entry lies inside the data_len bytes it indexes and wraps
+// the entries (not copied: base must outlive the index).
+static SplashIndex* wrap_entries(const guint8 *base, const IdxHeader *h, gsize data_len,
+                                 const char **why){
+  const SplashAuEntry *aus = (const SplashAuEntry*)(const void*)(base + h->header_size);
+  const SplashPsEntry *ps  = (const SplashPsEntry*)(const void*)(aus + h->n_aus);
+  for (guint i = 0; i < h->n_aus; ++i) {
+    if (aus[i].offset + aus[i].size > data_len ||
+        aus[i].ps_first + aus[i].ps_count > h->n_ps) {
+      *why = "entry out of range";
+      return NULL;
+    }
+  }
+  for (guint i = 0; i < h->n_ps; ++i) {
+    if (ps[i].offset + ps[i].size > data_len) {
+      *why = "parameter set out of range";
+      return NULL;
+    }
+  }
+  SplashIndex *idx = g_new0(SplashIndex, 1);
+  idx->aus = aus;
+  idx->n_aus = h->n_aus;
+  idx->ps = ps;
+  idx->n_ps = h->n_ps;
+  idx->max_tid = highest_tid(aus, h->n_aus);
+  return idx;
+}
+
+SplashIndex* splash_index_load(const char *idx_path, const char *src_path,
+                               const guint8 *src_data, gsize data_len,
+                               GError **err){
+  guint64 size; gint64 mtime;
+  if (!stat_source(src_path, &size, &mtime, err)) return NULL;
+
+  GMappedFile *map = g_mapped_file_new(idx_path, FALSE, err);
+  if (!map) return NULL;
+  const guint8 *base = (const guint8*)g_mapped_file_get_contents(map);
+  gsize maplen = g_mapped_file_get_length(map);
+
+  IdxHeader h;
+  guint64 hash = 0;
+  const char *why = check_header(base, maplen, &h);
+  if (!why && (h.src_size != size || (src_data && data_len != size))) why = "source size changed";
+  if (!why && h.src_mtime_ns != mtime) why = "source mtime changed";
+  if (!why && (!sample_hash(src_path, src_data, (gsize)size, &hash) || hash != h.src_hash))
+    why = "source hash changed";
+  if (!why) {
+    SplashIndex *idx = wrap_entries(base, &h, data_len, &why);
+    if (idx) {
+      idx->map = map;
+      return idx;
+    }
+  }
+  g_set_error(err, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+              "index '%s' rejected: %s", idx_path, why);
+  g_mapped_file_unref(map);
+  return NULL;
+}
+
+SplashIndex* splash_index_from_data(const guint8 *blob, gsize blob_len, gsize data_len,
+                                    GError **err){
+  IdxHeader h;
+  const char *why = check_header(blob, blob_len, &h);
+  if (!why && h.src_size != data_len) why = "built for different data";
+  if (!why) {
+    if ((guintptr)blob % sizeof(guint64) != 0) {
+      why = "misaligned";
+    } else {
+      SplashIndex *idx = wrap_entries(blob, &h, data_len, &why);
+      if (idx) return idx;
+    }
+  }
+  g_set_error(err, G_FILE_ERROR, G_FILE_ERROR_INVAL, "embedded index rejected: %s", why);
+  return NULL;
+}
+
+gboolean splash_index_save(const SplashIndex *idx, const char *idx_path,
+                           const char *src_path,
+                           const guint8 *src_data, gsize data_len,
+                           GError **err){
+  if (!idx || !idx_path || !src_path) return FALSE;
+  IdxHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, IDX_MAGIC, 8);
+  h.byte_order = IDX_BYTE_ORDER;
+  h.version = IDX_VERSION;
+  h.header_size = sizeof(h);
+  if (!stat_source(src_path, &h.src_size, &h.src_mtime_ns, err)) return FALSE;
+  if (src_data && data_len != h.src_size) {
+    g_set_error(err, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                "source '%s' changed while indexing", src_path);
+    return FALSE;
+  }
+  if (!sample_hash(src_path, src_data, (gsize)h.src_size, &h.src_hash)) {
+    g_set_error(err, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                "failed to fingerprint '%s'", src_path);
+    return FALSE;
+  }
+  h.n_aus = idx->n_aus;
+  h.n_ps = idx->n_ps;
+
+  gsize au_bytes = (gsize)idx->n_aus * sizeof(SplashAuEntry);
+  gsize ps_bytes = (gsize)idx->n_ps * sizeof(SplashPsEntry);
+  GString *blob = g_string_sized_new(sizeof(h) + au_bytes + ps_bytes);
+  g_string_append_len(blob, (const gchar*)&h, sizeof(h));
+  g_string_append_len(blob, (const gchar*)idx->aus, (gssize)au_bytes);
+  if (ps_bytes) g_string_append_len(blob, (const gchar*)idx->ps, (gssize)ps_bytes);
+  gboolean ok = g_file_set_contents(idx_path, blob->str, (gssize)blob->len, err);
+  g_string_free(blob, TRUE);
+  return ok;
+}
+
+void splash_index_free(SplashIndex *idx){
+  if (!idx) return;
+  if (idx->map) g_mapped_file_unref(idx->map);
+  if (idx->au_arr) g_array_free(idx->au_arr, TRUE);
+  if (idx->ps_arr) g_array_free(idx->ps_arr, TRUE);
+  g_free(idx);
+}
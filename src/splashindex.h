@@ -0,0 +1,105 @@
+#ifndef SPLASHINDEX_H
+#define SPLASHINDEX_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Access-unit index over an Annex-B H.265 elementary stream. Frame N of a
+// [sequence] maps to entry N, so the reader can hand out AUs straight from a
+// mapped file without h265parse or time-based seeks.
+//
+// The index can be persisted next to the input as a sidecar ("<input>.idx").
+// The sidecar is written in host byte order and is validated against the
+// source file's size, mtime and a sampled content hash before use.
+
+// Per access-unit flags
+enum {
+  SPLASH_AU_IRAP    = 1 << 0,  // first VCL NAL is BLA/IDR/CRA (types 16..23)
+  SPLASH_AU_HAS_VPS = 1 << 1,
+  SPLASH_AU_HAS_SPS = 1 << 2,
+  SPLASH_AU_HAS_PPS = 1 << 3,
+  SPLASH_AU_HAS_AUD = 1 << 4,
+};
+
+// H.265 NAL unit types used by the indexer
+enum {
+  SPLASH_NAL_IRAP_FIRST = 16,
+  SPLASH_NAL_IRAP_LAST  = 23,
+  SPLASH_NAL_VPS        = 32,
+  SPLASH_NAL_SPS        = 33,
+  SPLASH_NAL_PPS        = 34,
+  SPLASH_NAL_AUD        = 35,
+  SPLASH_NAL_SEI_PREFIX = 39,
+};
+
+typedef struct {
+  guint64 offset;    // byte offset of the AU's first start code
+  guint32 size;      // AU length in bytes (start codes included)
+  guint32 ps_first;  // first SplashPsEntry belonging to this AU
+  guint16 flags;     // SPLASH_AU_* bits
+  guint8  vcl_type;  // NAL type of the first VCL NAL (0xff if none)
+  guint8  ps_count;  // parameter-set NALs inside this AU
+  guint8  tid;       // TemporalId of the first VCL NAL
+  guint8  reserved[3];
+} SplashAuEntry;
+
+typedef struct {
+  guint64 offset;    // byte offset of the parameter set's start code
+  guint32 size;      // NAL length in bytes (start code included)
+  guint8  nal_type;  // SPLASH_NAL_VPS/SPS/PPS
+  guint8  reserved[3];
+} SplashPsEntry;
+
+typedef struct SplashIndex SplashIndex;
+struct SplashIndex {
+  const SplashAuEntry *aus;
+  guint n_aus;
+  const SplashPsEntry *ps;
+  guint n_ps;
+  guint8 max_tid;    // highest TemporalId of any AU (the top sub-layer)
+
+  // Backing storage: either a mapped sidecar or arrays built in memory
+  GMappedFile *map;
+  GArray *au_arr;
+  GArray *ps_arr;
+};
+
+// Scan an in-memory Annex-B stream and build a fresh index. The start-code
+// scan uses up to max_threads workers (0 = one per CPU); *threads_used (may
+// be NULL) reports how many ran.
+SplashIndex* splash_index_build(const guint8 *data, gsize len, guint max_threads,
+                                guint *threads_used);
+
+// Map a sidecar and validate it against the source file. Returns NULL (with
+// err set) when the sidecar is missing, malformed or stale.
+//
+// The sidecar is always fingerprinted against the file at src_path. src_data
+// may point at that file's mapped bytes to avoid re-reading them, or be NULL
+// (e.g. when the indexed data is a decompressed copy of src_path). data_len is
+// the length of the data the entries point into.
+SplashIndex* splash_index_load(const char *idx_path, const char *src_path,
+                               const guint8 *src_data, gsize data_len,
+                               GError **err);
+
+// Persist an index as a sidecar for src_path (atomic replace). Arguments as
+// for splash_index_load().
+gboolean splash_index_save(const SplashIndex *idx, const char *idx_path,
+                           const char *src_path,
+                           const guint8 *src_data, gsize data_len,
+                           GError **err);
+
+// Wrap a sidecar image already in memory (e.g. linked into the binary next to
+// the asset it indexes). Only the header and the entries' bounds against
+// data_len are checked; blob must be 8-byte aligned and outlive the index.
+SplashIndex* splash_index_from_data(const guint8 *blob, gsize blob_len, gsize data_len,
+                                    GError **err);
+
+void splash_index_free(SplashIndex *idx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
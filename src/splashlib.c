@@ -1,11 +1,41 @@
 #include "splashlib.h"
+#include "splashindex.h"
+#include "splashcache.h"
+#include "splashdecomp.h"
+#include "splashps.h"
+#include "splashoutput.h"
+#include "splashrt.h"
+#include "splashevents.h"
+#include "splashtimer.h"
+#include "splashrtp.h"
+#include "splashembed.h"
+#include "splashsei.h"
+#include "splashrtx.h"
+#include "splashfec.h"
+#include "splashfecfilter.h"
+#include <gio/gio.h>
 #include <gst/app/gstappsink.h>
 #include <gst/app/gstappsrc.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
 
 #define MAX_SEQS 32
 #define MAX_QUEUE 256
+#define PACE_LEAD_FRAMES 3
+#define EVENT_QUEUE_SIZE 256
+#define DEFAULT_MTU 1200
+#define DEFAULT_PT 97
+#define DEFAULT_PORT 5600
+#define RTCP_MAX_BYTES 1500
+#define DEFAULT_FEC_K 10
 
 typedef struct {
   char *name; // owned copy
@@ -20,6 +50,16 @@ struct Splash {
   GMainLoop *loop;
   GMutex lock;
 
+  // Media thread: owns the reader bus watch and segment boundary handling
+  GMainContext *media_ctx;
+  GMainLoop *media_loop;
+  GThread *media_thread;
+  GSource *reader_watch;
+  SplashThreadSched media_sched;
+  SplashThreadSched stream_sched;
+  gint sched_threads;             // atomic
+  gint sched_failures;            // atomic
+
   // Config
   char *input_path;
   double fps;
@@ -27,6 +67,11 @@ struct Splash {
   SplashOutputMode outputs;
   char *host;
   int   port;
+  int   mtu;                      // as configured (0 = default, SPLASH_MTU_AUTO)
+  struct sockaddr_storage mtu_dest; // SPLASH_MTU_AUTO: host:port, resolved without the lock
+  socklen_t mtu_dest_len;         // 0 = not resolved
+  int   payload_type;
+  SplashAggregateMode aggregate;
 
   // Sequences
   SeqDef seqs[MAX_SEQS];
@@ -39,27 +84,118 @@ struct Splash {
   // Sender (UDP)
   GstElement *sender_udp;
   GstElement *appsrc_udp;
+  gsize rtp_packets;              // atomic; media packets, counted on the payloader's src pad
+
+  // RTP retransmission (rtx_history > 0)
+  int rtx_history;
+  int rtx_payload_type;
+  int rtcp_port;
+  guint32 rtx_ssrc;
+  SplashRtx *rtx;                 // history of the packets sent
+  GSocket *rtcp_socket;           // the sender sends from it; RTCP feedback arrives on it
+  GSource *rtcp_watch;            // media thread
+
+  // Forward error correction (fec != SPLASH_FEC_OFF)
+  SplashFecScheme fec;
+  int fec_k;
+  int fec_n;
+  int fec_payload_type;
+  guint32 fec_ssrc;
+  SplashFecEnc *fec_enc;
 
   // Direct appsrc output
   GstElement *appsrc_out;
 
+  // Per-output delivery workers and their backpressure
+  SplashOutputPolicy udp_policy;
+  SplashOutputPolicy appsrc_policy;
+  SplashOutput *out_udp;
+  SplashOutput *out_app;
+  GCond pace_cond;                // wakes a paced frame source on stop
+
+  // Frame index + native reader (replaces the reader pipeline when available)
+  SplashIndexMode index_mode;
+  char *index_path;
+  GBytes *input_bytes;            // mapped or decompressed input (NULL in cache mode)
+  int decompress_threads;
+  int index_threads;
+  SplashIndex *index;
+  SplashCache *cache;             // bounded frame cache (cache_bytes > 0)
+  guint64 cache_bytes;
+  int cache_pin_frames;
+  GThread *feeder;
+  gboolean feeder_stop;
+  int cursor;                     // next frame to send, -1 = restart active sequence
+  gboolean pulling;               // started with SPLASH_OUTPUT_PULL
+  gboolean running;               // between splash_start() and splash_stop()
+  gboolean rendering;             // splash_render() owns the loop engine
+  gboolean paused;                // warm standby: pipelines and caches stay up
+  gint64 resume_at_us;            // splash_resume() time until the next frame goes out
+
+  // Out-of-band parameter sets (native reader)
+  SplashParamSets *ps;
+  int ps_interval_ms;             // min spacing of IRAP re-sends (0 = every IRAP, <0 = never)
+  gboolean ps_resend;             // start / sequence switch: send with the next frame
+  gboolean ps_join;               // downstream asked for a key unit: send on the next IRAP
+  guint ps_group_sent;
+  GstClockTime ps_last_pts;
+
   // Timing
   GstClockTime next_pts;
+  GstClockTime pts_base;          // PTS of the first frame since splash_start()
+
+  // Persistent timeline (SPLASH_TIMELINE_PERSISTENT)
+  SplashTimelineMode timeline;
+  gint64 anchor_us;               // monotonic time of the first start (0 = not anchored)
+  GstClockTime anchor_clock;      // the same instant on the system clock
+  guint32 rtp_ssrc;
+  guint32 rtp_ts_base;
+  guint rtp_seq_next;
+  gboolean rtp_sending;           // sender went PLAYING since the seqnum was saved
 
   // Queue state
   int active_idx;                 // current looping sequence index
   int pending_queue[MAX_QUEUE];   // FIFO of queued sequence indices
   int pending_count;              // number of valid entries in queue
 
+  // Scheduled switches (splash_schedule_at)
+  SplashTimerHeap *timers;
+  GSource *timer_src;             // legacy reader: fires on the media thread
+
+  // Watchdog (media thread): rebuilds a stalled or failed pipeline in place
+  int watchdog_ms;                // stall limit, 0 = off
+  GSource *watchdog_src;
+  GSource *sender_watch;          // UDP sender bus (errors)
+  guint delivering;               // deliver_frame calls using copied output pointers
+  GSList *retired_outputs;        // replaced workers, freed once delivering drops to 0
+  gint64 watch_since_us;          // start / resume / rebuild: idle time counts from here
+  gint64 last_frame_us;           // newest frame read from the source
+  gint64 reader_error_us;         // reader pipeline posted an error (0 = none)
+  gint64 sender_error_us;         // sender pipeline posted an error (0 = none)
+  gint64 recover_reader_us;       // detection time of a rebuild waiting for its first frame
+  gint64 recover_udp_us;
+  guint stalls_reported;          // 1 << SplashStallSource for report-only stalls
+
+  // Latency probes (latency_sei)
+  gboolean latency_sei;
+  guint64 probe_frame;            // frames probed since splash_start() / splash_render()
+  guint32 probe_switches;         // active sequence changes among them
+  int probe_seq;                  // sequence of the previous probed frame (-1 = none)
+
   // Automatic repeat order (optional)
   int loop_order[MAX_QUEUE];
   int loop_count;
   guint64 queue_version;
   guint64 loop_version;
 
-  // Events
-  SplashEventCb evt_cb;
-  void *evt_user;
+  // Events: posted from any thread (locks held or not), delivered by the
+  // queue's dispatcher thread
+  SplashEventQueue *events;
+
+  // Stats
+  SplashStats stats;
+  gint64 start_us;
+  gint64 start_cpu_us;
 };
 
 // ---- small helpers ----
@@ -67,7 +203,50 @@ static void free_str(char **p){ if(*p){ g_free(*p); *p=NULL; } }
 static void dup_cstr(char **dst, const char *src){ free_str(dst); if(src) *dst = g_strdup(src); }
 
 static void emit_evt(Splash *s, SplashEventType t, int a, int b, const char *m){
-  if (s->evt_cb) s->evt_cb(t, a, b, m, s->evt_user);
+  splash_events_post(s->events, t, a, b, m);
+}
+
+static gint64 process_cpu_us(void){
+  struct timespec ts;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0;
+  return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static gboolean sched_is_default(const SplashThreadSched *p){
+  return p->policy == SPLASH_SCHED_OTHER && p->cpus == 0;
+}
+
+// Applies p to the calling thread. Refusals (typically no CAP_SYS_NICE) are
+// counted rather than fatal: the thread keeps running with default scheduling.
+static void apply_thread_sched(Splash *s, const SplashThreadSched *p){
+  if (sched_is_default(p)) return;
+  g_atomic_int_inc(&s->sched_threads);
+  if (!splash_rt_apply(p, NULL)) g_atomic_int_inc(&s->sched_failures);
+}
+
+static void apply_stream_sched(gpointer user){
+  Splash *s = (Splash*)user;
+  g_mutex_lock(&s->lock);
+  SplashThreadSched p = s->stream_sched;
+  g_mutex_unlock(&s->lock);
+  apply_thread_sched(s, &p);
+}
+
+static gboolean apply_media_sched(gpointer user){
+  Splash *s = (Splash*)user;
+  g_mutex_lock(&s->lock);
+  SplashThreadSched p = s->media_sched;
+  g_mutex_unlock(&s->lock);
+  apply_thread_sched(s, &p);
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer media_main(gpointer data){
+  Splash *s = (Splash*)data;
+  g_main_context_push_thread_default(s->media_ctx);
+  g_main_loop_run(s->media_loop);
+  g_main_context_pop_thread_default(s->media_ctx);
+  return NULL;
 }
 
 static gboolean do_segment_seek_locked(Splash *s, int which){
@@ -79,6 +258,201 @@ static gboolean do_segment_seek_locked(Splash *s, int which){
       GST_SEEK_TYPE_SET, s->seqs[which].seg_stop_ns);
 }
 
+// Applies the queue/repeat state machine at the end of a pass over the
+// active sequence. Caller holds s->lock.
+static void advance_at_boundary_locked(Splash *s){
+  if (s->pending_count > 0) {
+    int from = s->active_idx;
+    int next = s->pending_queue[0];
+    if (s->pending_count > 1) {
+      memmove(&s->pending_queue[0], &s->pending_queue[1],
+              (s->pending_count - 1) * sizeof(int));
+    }
+    s->pending_count--;
+    s->active_idx = next;
+    if (next != from) s->ps_resend = TRUE;
+    emit_evt(s, SPLASH_EVT_SWITCHED_AT_BOUNDARY, from, s->active_idx, NULL);
+  } else if (s->loop_count > 0 && s->loop_version == s->queue_version) {
+    int from = s->active_idx;
+    int next = s->loop_order[0];
+    if (next >= 0 && next < s->nseq) {
+      s->active_idx = next;
+      s->pending_count = 0;
+      for (int i = 1; i < s->loop_count && i < MAX_QUEUE; ++i) {
+        s->pending_queue[s->pending_count++] = s->loop_order[i];
+      }
+      if (from != s->active_idx) {
+        s->ps_resend = TRUE;
+        emit_evt(s, SPLASH_EVT_SWITCHED_AT_BOUNDARY, from, s->active_idx, NULL);
+      }
+    }
+  }
+}
+
+// Switches to the target of every schedule due by the frame presented at
+// frame_us (monotonic), i.e. the frame boundary nearest to its due time. The
+// switch restarts the target sequence; the queue and repeat order are kept.
+// Returns TRUE when a switch happened. Caller holds s->lock.
+static gboolean apply_due_schedules_locked(Splash *s, gint64 frame_us){
+  gint64 half = (gint64)(s->dur / GST_USECOND) / 2;
+  SplashTimer t;
+  gboolean switched = FALSE;
+  while (splash_timers_peek(s->timers, &t) && t.due_us <= frame_us + half) {
+    splash_timers_pop(s->timers, &t);
+    if (t.seq < 0 || t.seq >= s->nseq) continue;
+    int from = s->active_idx;
+    s->active_idx = t.seq;
+    s->ps_resend = TRUE;
+    gint64 err = frame_us - t.due_us;
+    s->stats.sched_switches++;
+    s->stats.sched_error_us = err;
+    if (ABS(err) > s->stats.sched_error_max_us) s->stats.sched_error_max_us = ABS(err);
+    emit_evt(s, SPLASH_EVT_SCHEDULED_SWITCH, from, t.seq, NULL);
+    switched = TRUE;
+  }
+  return switched;
+}
+
+// Monotonic time at which the next frame is presented (its PTS on the
+// outputs' running time).
+static gint64 next_frame_time_locked(Splash *s){
+  return s->start_us + (gint64)((s->next_pts - s->pts_base) / GST_USECOND);
+}
+
+// A rebuilt pipeline delivers again: detected_us was when its stall or
+// error was noticed. Caller holds s->lock.
+static void record_recovery_locked(Splash *s, SplashStallSource what, gint64 detected_us){
+  gint64 us = g_get_monotonic_time() - detected_us;
+  s->stats.watchdog_recoveries++;
+  s->stats.recovery_us = us;
+  if (us > s->stats.recovery_max_us) s->stats.recovery_max_us = us;
+  emit_evt(s, SPLASH_EVT_RECOVERED, what, (int)MIN(us / 1000, (gint64)G_MAXINT), NULL);
+}
+
+// Counts one delivered AU; the first one after start also fires
+// SPLASH_EVT_FIRST_PACKET, the first one after a resume records its latency.
+static void account_frame(Splash *s, gsize bytes, gboolean pushed){
+  gint64 first_us = -1;
+  g_mutex_lock(&s->lock);
+  s->last_frame_us = g_get_monotonic_time();
+  if (s->recover_reader_us > 0) {
+    record_recovery_locked(s, SPLASH_STALL_READER, s->recover_reader_us);
+    s->recover_reader_us = 0;
+  }
+  s->stats.frames_pushed++;
+  s->stats.bytes_pushed += bytes;
+  if (pushed && s->stats.first_packet_us < 0) {
+    first_us = s->stats.first_packet_us = g_get_monotonic_time() - s->start_us;
+  }
+  if (pushed && s->resume_at_us > 0) {
+    gint64 lat = g_get_monotonic_time() - s->resume_at_us;
+    s->stats.resume_latency_us = lat;
+    if (lat > s->stats.resume_latency_max_us) s->stats.resume_latency_max_us = lat;
+    s->resume_at_us = 0;
+  }
+  g_mutex_unlock(&s->lock);
+  if (first_us >= 0) {
+    emit_evt(s, SPLASH_EVT_FIRST_PACKET, (int)MIN(first_us, (gint64)G_MAXINT), 0, NULL);
+  }
+}
+
+// Holds a live frame source back to real time. Outputs used to be paced by
+// their blocking appsrcs; with per-output workers and leak policies nothing
+// downstream throttles the reader any more. A few frames of lead keep the
+// output queues primed.
+static void pace_frame(Splash *s, GstClockTime pts){
+  g_mutex_lock(&s->lock);
+  gint64 due = s->start_us + (gint64)((pts - s->pts_base) / GST_USECOND) -
+               (gint64)(PACE_LEAD_FRAMES * s->dur / GST_USECOND);
+  while (!s->feeder_stop && g_get_monotonic_time() < due) {
+    if (!g_cond_wait_until(&s->pace_cond, &s->lock, due)) break;
+  }
+  g_mutex_unlock(&s->lock);
+}
+
+// Fills the counters of the next latency probe; the caller adds the send
+// time. Caller holds s->lock.
+static void next_probe_locked(Splash *s, GstClockTime pts, SplashLatencyProbe *p){
+  if (s->active_idx != s->probe_seq) {
+    if (s->probe_seq >= 0) s->probe_switches++;
+    s->probe_seq = s->active_idx;
+  }
+  p->frame = s->probe_frame++;
+  p->send_us = 0;
+  p->pts = pts;
+  p->switches = s->probe_switches;
+  p->seq = (guint8)MAX(s->active_idx, 0);
+}
+
+static void reset_probes_locked(Splash *s){
+  s->probe_frame = 0;
+  s->probe_switches = 0;
+  s->probe_seq = -1;
+}
+
+// Timestamps one AU and hands a reference to every enabled output worker.
+// Takes ownership of inbuf; all outputs share the same buffer.
+static GstFlowReturn deliver_frame(Splash *s, GstBuffer *inbuf) {
+  GstClockTime pts;
+  GstClockTime dur;
+  g_mutex_lock(&s->lock);
+  pts = s->next_pts;
+  dur = s->dur;
+  s->next_pts += dur;
+  SplashOutput *outs[2] = {
+    (s->outputs & SPLASH_OUTPUT_UDP) ? s->out_udp : NULL,
+    (s->outputs & SPLASH_OUTPUT_APPSRC) ? s->out_app : NULL,
+  };
+  gboolean tolerate = s->watchdog_ms > 0;
+  s->delivering++;   // the watchdog keeps retired outputs alive until we are done
+  SplashLatencyProbe probe;
+  gboolean stamp = s->latency_sei;
+  if (stamp) next_probe_locked(s, pts, &probe);
+  // When the frame is due on the monotonic clock, as pace_frame() counts it
+  gint64 due_us = s->start_us + (gint64)((pts - s->pts_base) / GST_USECOND);
+  g_mutex_unlock(&s->lock);
+
+  pace_frame(s, pts);
+
+  GstBuffer *buf = gst_buffer_make_writable(inbuf);
+  GST_BUFFER_PTS(buf)      = pts;
+  GST_BUFFER_DTS(buf)      = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION(buf) = dur;
+  if (stamp) {
+    // Pacing releases the frame PACE_LEAD_FRAMES early and udpsink (sync=true)
+    // holds it until it is due, so that is its send time; a late frame goes now
+    gint64 now_us = g_get_monotonic_time();
+    probe.send_us = g_get_real_time() + MAX(due_us - now_us, 0);
+    buf = splash_sei_insert_probe(buf, &probe);
+  }
+
+  GstFlowReturn overall = GST_FLOW_OK;
+  gboolean pushed = FALSE;
+  for (int i = 0; i < 2; ++i) {
+    if (!outs[i]) continue;
+    GstFlowReturn fr = splash_output_enqueue(outs[i], gst_buffer_ref(buf));
+    // With the watchdog on, a failing output is rebuilt rather than stopping
+    // the stream; a retired one reports FLUSHING while it is replaced.
+    if (tolerate && fr != GST_FLOW_OK) fr = GST_FLOW_OK;
+    if (overall == GST_FLOW_OK) overall = fr;
+    pushed = TRUE;
+  }
+  g_mutex_lock(&s->lock);
+  s->delivering--;
+  g_mutex_unlock(&s->lock);
+  gsize bytes = gst_buffer_get_size(buf);
+  gst_buffer_unref(buf);
+  account_frame(s, bytes, pushed);
+  return overall;
+}
+
+// Runs the watchdog check now instead of at its next tick.
+static void wake_watchdog_locked(Splash *s){
+  if (s->watchdog_src && s->running && s->watchdog_ms > 0) {
+    g_source_set_ready_time(s->watchdog_src, 0);
+  }
+}
+
 // ------------------------------------------------------------------
 // GStreamer callbacks
 // ------------------------------------------------------------------
@@ -89,30 +463,7 @@ static gboolean on_reader_bus(GstBus *bus, GstMessage *m, gpointer user) {
     case GST_MESSAGE_SEGMENT_DONE:
     case GST_MESSAGE_EOS: {
       g_mutex_lock(&s->lock);
-      if (s->pending_count > 0) {
-        int from = s->active_idx;
-        int next = s->pending_queue[0];
-        if (s->pending_count > 1) {
-          memmove(&s->pending_queue[0], &s->pending_queue[1],
-                  (s->pending_count - 1) * sizeof(int));
-        }
-        s->pending_count--;
-        s->active_idx = next;
-        emit_evt(s, SPLASH_EVT_SWITCHED_AT_BOUNDARY, from, s->active_idx, NULL);
-      } else if (s->loop_count > 0 && s->loop_version == s->queue_version) {
-        int from = s->active_idx;
-        int next = s->loop_order[0];
-        if (next >= 0 && next < s->nseq) {
-          s->active_idx = next;
-          s->pending_count = 0;
-          for (int i = 1; i < s->loop_count && i < MAX_QUEUE; ++i) {
-            s->pending_queue[s->pending_count++] = s->loop_order[i];
-          }
-          if (from != s->active_idx) {
-            emit_evt(s, SPLASH_EVT_SWITCHED_AT_BOUNDARY, from, s->active_idx, NULL);
-          }
-        }
-      }
+      advance_at_boundary_locked(s);
       do_segment_seek_locked(s, s->active_idx);
       g_mutex_unlock(&s->lock);
       return TRUE;
@@ -122,6 +473,14 @@ static gboolean on_reader_bus(GstBus *bus, GstMessage *m, gpointer user) {
       gst_message_parse_error(m, &err, &dbg);
       emit_evt(s, SPLASH_EVT_ERROR, 0, 0, err?err->message:NULL);
       g_clear_error(&err); g_free(dbg);
+      g_mutex_lock(&s->lock);
+      gboolean recover = s->watchdog_ms > 0 && s->running;
+      if (recover) {
+        if (!s->reader_error_us) s->reader_error_us = g_get_monotonic_time();
+        wake_watchdog_locked(s);
+      }
+      g_mutex_unlock(&s->lock);
+      if (recover) return TRUE;
       if (s->loop) g_main_loop_quit(s->loop);
       return FALSE;
     }
@@ -129,6 +488,74 @@ static gboolean on_reader_bus(GstBus *bus, GstMessage *m, gpointer user) {
   }
 }
 
+// Only watched with the watchdog on: a sender error gets the sender rebuilt.
+static gboolean on_sender_bus(GstBus *bus, GstMessage *m, gpointer user) {
+  (void)bus;
+  Splash *s = (Splash*)user;
+  if (GST_MESSAGE_TYPE(m) == GST_MESSAGE_ERROR) {
+    GError *err=NULL; gchar *dbg=NULL;
+    gst_message_parse_error(m, &err, &dbg);
+    emit_evt(s, SPLASH_EVT_ERROR, 0, 0, err?err->message:NULL);
+    g_clear_error(&err); g_free(dbg);
+    g_mutex_lock(&s->lock);
+    if (s->running && !s->sender_error_us) {
+      s->sender_error_us = g_get_monotonic_time();
+      wake_watchdog_locked(s);
+    }
+    g_mutex_unlock(&s->lock);
+  }
+  return TRUE;
+}
+
+// Legacy reader: schedules are applied on the media thread with a flushing
+// seek, shortly ahead of their due time so the cut lands on the nearest frame.
+static void arm_timer_locked(Splash *s){
+  SplashTimer t;
+  if (!s->reader || !s->running || !splash_timers_peek(s->timers, &t)) {
+    g_source_set_ready_time(s->timer_src, -1);
+    return;
+  }
+  g_source_set_ready_time(s->timer_src, t.due_us - (gint64)(s->dur / GST_USECOND) / 2);
+}
+
+static gboolean on_timer_due(gpointer user){
+  Splash *s = (Splash*)user;
+  g_mutex_lock(&s->lock);
+  if (s->reader && s->running &&
+      apply_due_schedules_locked(s, g_get_monotonic_time())) {
+    do_segment_seek_locked(s, s->active_idx);
+  }
+  arm_timer_locked(s);
+  g_mutex_unlock(&s->lock);
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean timer_dispatch(GSource *src, GSourceFunc cb, gpointer user){
+  g_source_set_ready_time(src, -1);
+  return cb ? cb(user) : G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs timer_funcs = { NULL, NULL, timer_dispatch, NULL, NULL, NULL };
+
+// GStreamer tasks announce themselves from their own thread, so the sync
+// handler can set their scheduling before they process any data.
+static GstBusSyncReply on_stream_status(GstBus *bus, GstMessage *m, gpointer user) {
+  (void)bus;
+  if (GST_MESSAGE_TYPE(m) == GST_MESSAGE_STREAM_STATUS) {
+    GstStreamStatusType type;
+    GstElement *owner = NULL;
+    gst_message_parse_stream_status(m, &type, &owner);
+    if (type == GST_STREAM_STATUS_TYPE_ENTER) apply_stream_sched(user);
+  }
+  return GST_BUS_PASS;
+}
+
+static void watch_stream_status(Splash *s, GstElement *pipeline){
+  GstBus *bus = gst_element_get_bus(pipeline);
+  gst_bus_set_sync_handler(bus, on_stream_status, s, NULL);
+  gst_object_unref(bus);
+}
+
 static GstFlowReturn on_new_sample(GstAppSink *sink, gpointer user) {
   Splash *s = (Splash*)user;
   GstSample *samp = gst_app_sink_pull_sample(sink);
@@ -138,41 +565,322 @@ static GstFlowReturn on_new_sample(GstAppSink *sink, gpointer user) {
     gst_sample_unref(samp);
     return GST_FLOW_ERROR;
   }
+  gst_buffer_ref(inbuf);
+  gst_sample_unref(samp);
+  return deliver_frame(s, inbuf);
+}
 
-  GstClockTime pts;
-  GstClockTime dur;
+// ------------------------------------------------------------------
+// Native reader (frame index)
+// ------------------------------------------------------------------
+static void close_index_locked(Splash *s){
+  if (s->ps) { splash_ps_free(s->ps); s->ps = NULL; }
+  if (s->cache) { splash_cache_free(s->cache); s->cache = NULL; }
+  if (s->index) { splash_index_free(s->index); s->index = NULL; }
+  if (s->input_bytes) { g_bytes_unref(s->input_bytes); s->input_bytes = NULL; }
+}
+
+// input=embedded: the asset and its index are part of the binary; the index
+// mode, sidecar path and cache settings do not apply.
+static gboolean open_embedded_locked(Splash *s, GError **err){
+  gint64 t0 = g_get_monotonic_time();
+  const guint8 *data, *blob;
+  gsize len, blob_len;
+  if (!splash_embedded_asset(&data, &len, &blob, &blob_len)) {
+    g_set_error(err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_NOT_FOUND,
+                "no asset embedded in this build (make EMBED=FILE)");
+    return FALSE;
+  }
+  s->input_bytes = g_bytes_new_static(data, len);
+  if (blob_len > 0) {
+    s->index = splash_index_from_data(blob, blob_len, len, err);
+    s->stats.index_from_sidecar = s->index != NULL;
+  } else {
+    s->index = splash_index_build(data, len, (guint)s->index_threads, &s->stats.index_threads);
+    if (!s->index) {
+      g_set_error(err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ,
+                  "no H.265 access units found in the embedded asset");
+    }
+  }
+  if (!s->index) {
+    close_index_locked(s);
+    return FALSE;
+  }
+  s->ps = splash_ps_new(s->index, data, len);
+  s->stats.index_frames = (int)s->index->n_aus;
+  s->stats.ps_groups = splash_ps_n_groups(s->ps);
+  s->stats.index_time_us = g_get_monotonic_time() - t0;
+  return TRUE;
+}
+
+// Maps (or decompresses) the input and loads, or builds and persists, its
+// frame index. Leaves s->index NULL when indexing is disabled or a plain input
+// cannot be indexed, in which case the legacy h265parse reader is used.
+// Compressed inputs have no such fallback, so failing to index them is an error.
+static gboolean open_index_locked(Splash *s, GError **err){
+  close_index_locked(s);
+  s->stats.index_frames = 0;
+  s->stats.index_from_sidecar = false;
+  s->stats.index_saved = false;
+  s->stats.index_time_us = 0;
+  s->stats.decompress_us = 0;
+  s->stats.decompress_threads = 0;
+  s->stats.index_threads = 0;
+  s->stats.ps_groups = 0;
+  if (g_str_has_prefix(s->input_path, SPLASH_EMBEDDED_PREFIX)) return open_embedded_locked(s, err);
+  if (s->index_mode == SPLASH_INDEX_OFF) return TRUE;
+
+  gint64 t0 = g_get_monotonic_time();
+  GMappedFile *map = g_mapped_file_new(s->input_path, FALSE, NULL);
+  if (!map) return TRUE;
+  s->input_bytes = g_mapped_file_get_bytes(map);
+  g_mapped_file_unref(map);
+  gsize len = 0;
+  const guint8 *data = g_bytes_get_data(s->input_bytes, &len);
+  const guint8 *fp_data = data; // sidecar fingerprint source (NULL -> read the file)
+
+  SplashCompression kind = splash_detect_compression(data, len);
+  if (kind != SPLASH_COMPRESSION_NONE) {
+    gint64 d0 = g_get_monotonic_time();
+    guint threads = 0;
+    GBytes *plain = splash_decompress(data, len, kind, s->decompress_threads, &threads, err);
+    s->stats.decompress_us = g_get_monotonic_time() - d0;
+    s->stats.decompress_threads = threads;
+    g_bytes_unref(s->input_bytes);
+    s->input_bytes = plain;
+    if (!plain) return FALSE;
+    data = g_bytes_get_data(plain, &len);
+    fp_data = NULL;
+  }
+
+  gchar *idx_path = s->index_path ? g_strdup(s->index_path)
+                                  : g_strdup_printf("%s.idx", s->input_path);
+  if (s->index_mode == SPLASH_INDEX_AUTO) {
+    s->index = splash_index_load(idx_path, s->input_path, fp_data, len, NULL);
+    s->stats.index_from_sidecar = s->index != NULL;
+  }
+  if (!s->index) {
+    s->index = splash_index_build(data, len, (guint)s->index_threads,
+                                  &s->stats.index_threads);
+    if (s->index && s->index_mode == SPLASH_INDEX_AUTO) {
+      s->stats.index_saved = splash_index_save(s->index, idx_path, s->input_path,
+                                               fp_data, len, NULL);
+    }
+  }
+  g_free(idx_path);
+  if (s->index) s->ps = splash_ps_new(s->index, data, len);
+  if (s->index && s->cache_bytes > 0 && kind == SPLASH_COMPRESSION_NONE) {
+    // Cache mode: the mapping was only needed to load/build the index
+    int fd = open(s->input_path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) s->cache = splash_cache_new(fd, s->index, s->cache_bytes);
+    if (!s->cache) {
+      if (fd >= 0) close(fd);
+      splash_ps_free(s->ps);
+      s->ps = NULL;
+      splash_index_free(s->index);
+      s->index = NULL;
+    }
+    g_bytes_unref(s->input_bytes);
+    s->input_bytes = NULL;
+  }
+  if (!s->index) {
+    close_index_locked(s);
+    if (kind != SPLASH_COMPRESSION_NONE) {
+      g_set_error(err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ,
+                  "no H.265 access units found in compressed input '%s'", s->input_path);
+      return FALSE;
+    }
+    return TRUE;
+  }
+  s->stats.index_frames = (int)s->index->n_aus;
+  s->stats.ps_groups = splash_ps_n_groups(s->ps);
+  s->stats.index_time_us = g_get_monotonic_time() - t0 - s->stats.decompress_us;
+  return TRUE;
+}
+
+static void seq_frames_locked(Splash *s, int which, int *first, int *last){
+  int n = (int)s->index->n_aus;
+  if (which < 0 || which >= s->nseq) { *first = 0; *last = n - 1; return; }
+  *first = CLAMP(s->seqs[which].start_f, 0, n - 1);
+  *last  = CLAMP(s->seqs[which].end_f, *first, n - 1);
+}
+
+// Pins the frames around every sequence edge so boundary switches never wait
+// on storage. Sequence starts go first: they matter most for switch latency.
+static void repin_cache_locked(Splash *s){
+  if (!s->cache) return;
+  splash_cache_unpin_all(s->cache);
+  int pin = s->cache_pin_frames;
+  if (pin <= 0) return;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int i = 0; i < s->nseq; ++i) {
+      int first, last;
+      seq_frames_locked(s, i, &first, &last);
+      int from = pass == 0 ? first : MAX(first, last - pin + 1);
+      int to   = pass == 0 ? MIN(last, first + pin - 1) : last;
+      for (int f = from; f <= to; ++f) splash_cache_pin(s->cache, (guint)f);
+    }
+  }
+}
+
+// Picks the next frame for the native reader. Running past the end of the
+// active sequence is the native equivalent of SEGMENT_DONE.
+static int next_frame_locked(Splash *s){
+  int first, last;
+  if (s->cursor >= 0) {
+    seq_frames_locked(s, s->active_idx, &first, &last);
+    if (s->cursor > last) {
+      advance_at_boundary_locked(s);
+      s->cursor = -1;
+    }
+  }
+  seq_frames_locked(s, s->active_idx, &first, &last);
+  if (s->cursor < 0) s->cursor = first;
+  return s->cursor++;
+}
+
+// Only valid while the native reader owns the index (no lock needed: the
+// index, mapping and cache are replaced only after stop_feeder()).
+static GstBuffer* index_frame_buffer(Splash *s, int frame){
+  if (s->cache) return splash_cache_get(s->cache, (guint)frame);
+  const SplashAuEntry *au = &s->index->aus[frame];
+  guint8 *base = (guint8*)g_bytes_get_data(s->input_bytes, NULL);
+  return gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+                                     base + au->offset, au->size, 0, au->size,
+                                     g_bytes_ref(s->input_bytes),
+                                     (GDestroyNotify)g_bytes_unref);
+}
+
+// Whether an enabled output's cap skipped parameter sets it still needs.
+static gboolean outputs_owe_ps_locked(Splash *s){
+  return ((s->outputs & SPLASH_OUTPUT_UDP) && splash_output_ps_owed(s->out_udp)) ||
+         ((s->outputs & SPLASH_OUTPUT_APPSRC) && splash_output_ps_owed(s->out_app));
+}
+
+// Decides whether `frame` (about to be stamped with pts) carries the cached
+// parameter sets: after start or a sequence switch, when the decoder
+// configuration changes, and on IRAP frames once ps_interval_ms of media time
+// has passed, a downstream element asked for a key unit or an output skipped
+// the last ones.
+static gboolean want_param_sets_locked(Splash *s, int frame, GstClockTime pts){
+  guint group = splash_ps_group(s->ps, (guint)frame);
+  gboolean want = s->ps_resend || group != s->ps_group_sent;
+  if (!want && (s->index->aus[frame].flags & SPLASH_AU_IRAP)) {
+    want = s->ps_join || outputs_owe_ps_locked(s) ||
+           (s->ps_interval_ms >= 0 &&
+            pts - s->ps_last_pts >= (GstClockTime)s->ps_interval_ms * GST_MSECOND);
+  }
+  if (want) {
+    s->ps_resend = FALSE;
+    s->ps_join = FALSE;
+    s->ps_group_sent = group;
+    s->ps_last_pts = pts;
+  }
+  return want;
+}
+
+// Flags an AU the way h265parse would for the outputs' bitrate cap:
+// DELTA_UNIT unless it is an IRAP, HEADER when it carries parameter sets, and
+// DROPPABLE for sub-layer non-reference pictures (TRAIL_N, RASL_N, ...) in
+// the highest sub-layer. Lower sub-layers' ones may still be referenced by
+// pictures with a higher TemporalId.
+static GstBuffer* flag_frame(Splash *s, int frame, GstBuffer *buf, gboolean injected){
+  const SplashAuEntry *au = &s->index->aus[frame];
+  buf = gst_buffer_make_writable(buf);
+  if (!(au->flags & SPLASH_AU_IRAP)) GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  if (injected || (!s->ps && au->ps_count > 0)) GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_HEADER);
+  if (au->vcl_type <= 14 && au->vcl_type % 2 == 0 && au->tid == s->index->max_tid) {
+    GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_DROPPABLE);
+  }
+  return buf;
+}
+
+// Runs the loop engine for one frame and returns its AU (untimestamped), or
+// NULL when the read failed.
+static GstBuffer* read_next_frame(Splash *s){
   g_mutex_lock(&s->lock);
-  pts = s->next_pts;
-  dur = s->dur;
-  s->next_pts += dur;
+  if (!s->rendering && apply_due_schedules_locked(s, next_frame_time_locked(s))) s->cursor = -1;
+  int frame = next_frame_locked(s);
+  gboolean inject = s->ps && want_param_sets_locked(s, frame, s->next_pts);
   g_mutex_unlock(&s->lock);
 
-  GstFlowReturn overall = GST_FLOW_OK;
-  gboolean pushed = FALSE;
+  GstBuffer *buf = index_frame_buffer(s, frame);
+  gsize stripped = 0, injected = 0;
+  if (buf && s->ps) {
+    buf = splash_ps_rewrite(s->ps, (guint)frame, buf, inject, &stripped, &injected);
+    g_mutex_lock(&s->lock);
+    s->stats.ps_bytes_stripped += stripped;
+    s->stats.ps_bytes_injected += injected;
+    if (injected) s->stats.ps_injections++;
+    g_mutex_unlock(&s->lock);
+  }
+  if (buf) buf = flag_frame(s, frame, buf, s->ps ? injected > 0 : FALSE);
+  return buf;
+}
 
-  if ((s->outputs & SPLASH_OUTPUT_UDP) && s->appsrc_udp) {
-    GstBuffer *out = gst_buffer_copy_deep(inbuf);
-    GST_BUFFER_PTS(out)      = pts;
-    GST_BUFFER_DTS(out)      = GST_CLOCK_TIME_NONE;
-    GST_BUFFER_DURATION(out) = dur;
-    GstFlowReturn fr = gst_app_src_push_buffer(GST_APP_SRC(s->appsrc_udp), out);
-    overall = fr;
-    pushed = TRUE;
+static gpointer feeder_main(gpointer data){
+  Splash *s = (Splash*)data;
+  apply_stream_sched(s);
+  for (;;) {
+    g_mutex_lock(&s->lock);
+    while (s->paused && !s->feeder_stop) g_cond_wait(&s->pace_cond, &s->lock);
+    gboolean stop = s->feeder_stop;
+    g_mutex_unlock(&s->lock);
+    if (stop) break;
+
+    GstBuffer *buf = read_next_frame(s);
+    if (!buf) {
+      emit_evt(s, SPLASH_EVT_ERROR, 0, 0, "failed to read frame from input");
+      if (s->loop) g_main_loop_quit(s->loop);
+      break;
+    }
+    GstFlowReturn fr = deliver_frame(s, buf);
+    if (fr == GST_FLOW_FLUSHING) break;
+    if (fr != GST_FLOW_OK) {
+      emit_evt(s, SPLASH_EVT_ERROR, 0, 0, gst_flow_get_name(fr));
+      if (s->loop) g_main_loop_quit(s->loop);
+      break;
+    }
   }
+  return NULL;
+}
 
-  if ((s->outputs & SPLASH_OUTPUT_APPSRC) && s->appsrc_out) {
-    GstBuffer *out = gst_buffer_copy_deep(inbuf);
-    GST_BUFFER_PTS(out)      = pts;
-    GST_BUFFER_DTS(out)      = GST_CLOCK_TIME_NONE;
-    GST_BUFFER_DURATION(out) = dur;
-    GstFlowReturn fr = gst_app_src_push_buffer(GST_APP_SRC(s->appsrc_out), out);
-    if (!pushed || overall == GST_FLOW_OK) overall = fr;
-    pushed = TRUE;
+// Stops and joins the native reader. Must be called without s->lock held; the
+// output workers are flushed first so an enqueue blocked on them returns.
+static void stop_feeder(Splash *s){
+  g_mutex_lock(&s->lock);
+  GThread *t = s->feeder;
+  s->feeder = NULL;
+  s->feeder_stop = TRUE;
+  g_cond_broadcast(&s->pace_cond);
+  if (t) {
+    splash_output_set_flushing(s->out_udp, TRUE);
+    splash_output_set_flushing(s->out_app, TRUE);
   }
+  g_mutex_unlock(&s->lock);
+  if (t) g_thread_join(t);
+}
 
-  gst_sample_unref(samp);
-  if (!pushed) return GST_FLOW_OK;
-  return overall;
+// A downstream GstForceKeyUnit (e.g. a receiver joining through a payloader
+// or muxer) makes the feeder resend the parameter sets on the next IRAP.
+static GstPadProbeReturn on_output_upstream_event(GstPad *pad, GstPadProbeInfo *info, gpointer user){
+  (void)pad;
+  Splash *s = (Splash*)user;
+  GstEvent *ev = GST_PAD_PROBE_INFO_EVENT(info);
+  if (ev && GST_EVENT_TYPE(ev) == GST_EVENT_CUSTOM_UPSTREAM &&
+      gst_event_has_name(ev, "GstForceKeyUnit")) {
+    g_mutex_lock(&s->lock);
+    s->ps_join = TRUE;
+    g_mutex_unlock(&s->lock);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static void watch_output_events(Splash *s, GstElement *appsrc){
+  GstPad *pad = gst_element_get_static_pad(appsrc, "src");
+  if (!pad) return;
+  gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, on_output_upstream_event, s, NULL);
+  gst_object_unref(pad);
 }
 
 // ------------------------------------------------------------------
@@ -181,7 +889,162 @@ static GstFlowReturn on_new_sample(GstAppSink *sink, gpointer user) {
 // ------------------------------------------------------------------
 // Pipeline lifecycle
 // ------------------------------------------------------------------
+// Persistent timeline: remembers where the payloader's sequence numbers got to
+// before the sender goes down, so the next run continues from there.
+static void save_rtp_state_locked(Splash *s){
+  if (s->timeline != SPLASH_TIMELINE_PERSISTENT || !s->sender_udp || !s->rtp_sending) return;
+  GstElement *pay = gst_bin_get_by_name(GST_BIN(s->sender_udp), "pay");
+  if (!pay) return;
+  guint seq = 0;
+  g_object_get(G_OBJECT(pay), "seqnum", &seq, NULL);
+  gst_object_unref(pay);
+  s->rtp_seq_next = (seq + 1) & 0xffff;
+  s->rtp_sending = FALSE;
+}
+
+// Persistent timeline: before the sender leaves NULL/READY, pins its base time
+// to the timeline anchor (running time = monotonic time since the first start)
+// and restores SSRC, timestamp base and the next sequence number.
+static void prepare_sender_timeline_locked(Splash *s){
+  if (s->timeline != SPLASH_TIMELINE_PERSISTENT || !s->sender_udp) return;
+  GstState cur = GST_STATE_NULL;
+  gst_element_get_state(s->sender_udp, &cur, NULL, 0);
+  if (cur >= GST_STATE_PAUSED) return;
+  GstElement *pay = gst_bin_get_by_name(GST_BIN(s->sender_udp), "pay");
+  if (pay) {
+    g_object_set(G_OBJECT(pay),
+      "ssrc", s->rtp_ssrc,
+      "timestamp-offset", s->rtp_ts_base,
+      "seqnum-offset", (gint)s->rtp_seq_next,
+      NULL);
+    gst_object_unref(pay);
+  }
+  gst_element_set_start_time(s->sender_udp, GST_CLOCK_TIME_NONE);
+  gst_element_set_base_time(s->sender_udp, s->anchor_clock);
+}
+
+static void remove_watch(GSource **watch){
+  if (!*watch) return;
+  g_source_destroy(*watch);
+  g_source_unref(*watch);
+  *watch = NULL;
+}
+
+typedef struct {
+  GSocket *sock;
+  GSocketAddress *to;
+} RtxDest;
+
+static gboolean send_rtx(const guint8 *pkt, gsize len, gpointer user){
+  RtxDest *d = (RtxDest*)user;
+  return g_socket_send_to(d->sock, d->to, (const gchar*)pkt, len, NULL, NULL) == (gssize)len;
+}
+
+// RTCP feedback from receivers (media thread). Retransmissions go to the RTP
+// port of the host that asked. They are sent without s->lock, on a reference
+// to the history (it has its own lock): a NACK burst may ask for all of it.
+static gboolean on_rtcp(GSocket *sock, GIOCondition cond, gpointer user){
+  (void)cond;
+  Splash *s = (Splash*)user;
+  guint8 buf[RTCP_MAX_BYTES];
+  g_mutex_lock(&s->lock);
+  if (g_source_is_destroyed(g_main_current_source())) {
+    g_mutex_unlock(&s->lock);
+    return G_SOURCE_REMOVE;
+  }
+  SplashRtx *rtx = splash_rtx_ref(s->rtx);
+  guint16 port = (guint16)s->port;
+  g_mutex_unlock(&s->lock);
+  for (;;) {
+    GSocketAddress *from = NULL;
+    gssize n = g_socket_receive_from(sock, &from, (gchar*)buf, sizeof(buf), NULL, NULL);
+    if (n < 0) break;
+    if (from && G_IS_INET_SOCKET_ADDRESS(from)) {
+      GInetAddress *ip = g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(from));
+      RtxDest d = { sock, g_inet_socket_address_new(ip, port) };
+      splash_rtx_handle_rtcp(rtx, buf, (gsize)n, g_get_monotonic_time(), send_rtx, &d);
+      g_object_unref(d.to);
+    }
+    if (from) g_object_unref(from);
+  }
+  splash_rtx_unref(rtx);
+  return G_SOURCE_CONTINUE;
+}
+
+// Payload types after defaults: retransmissions and repair packets take the
+// next dynamic types after the media's, wrapping to 96.
+static int resolve_pt(int pt){
+  return pt > 0 ? pt : DEFAULT_PT;
+}
+
+static int resolve_rtx_pt(int rtx_pt, int pt){
+  return rtx_pt > 0 ? rtx_pt : (pt < 127 ? pt + 1 : 96);
+}
+
+static int resolve_fec_pt(int fec_pt, int pt){
+  return fec_pt > 0 ? fec_pt : (pt < 126 ? pt + 2 : pt - 30);
+}
+
+// RTP retransmission: the packet history and the socket the UDP sender sends
+// from, bound to rtcp_port. Receivers send their NACKs to it, either to that
+// port or straight back to the packets' source.
+static gboolean open_rtx_locked(Splash *s, GError **err){
+  if (s->rtx_history <= 0 || !(s->outputs & SPLASH_OUTPUT_UDP)) return TRUE;
+  GSocketFamily family = strchr(s->host, ':') ? G_SOCKET_FAMILY_IPV6 : G_SOCKET_FAMILY_IPV4;
+  GSocket *sock = g_socket_new(family, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, err);
+  if (!sock) return FALSE;
+  GInetAddress *any = g_inet_address_new_any(family);
+  GSocketAddress *local = g_inet_socket_address_new(any, (guint16)s->rtcp_port);
+  gboolean bound = g_socket_bind(sock, local, TRUE, err);
+  g_object_unref(local);
+  g_object_unref(any);
+  if (!bound) {
+    g_object_unref(sock);
+    return FALSE;
+  }
+  g_socket_set_blocking(sock, FALSE);
+  int rtx_pt = resolve_rtx_pt(s->rtx_payload_type, resolve_pt(s->payload_type));
+  s->rtx = splash_rtx_new((guint)s->rtx_history, (guint8)rtx_pt, s->rtx_ssrc,
+                          (guint16)g_random_int());
+  s->rtcp_socket = sock;
+  s->rtcp_watch = g_socket_create_source(sock, G_IO_IN, NULL);
+  g_source_set_callback(s->rtcp_watch, (GSourceFunc)(void (*)(void))on_rtcp, s, NULL);
+  g_source_attach(s->rtcp_watch, s->media_ctx);
+  return TRUE;
+}
+
+static void close_rtx_locked(Splash *s){
+  remove_watch(&s->rtcp_watch);
+  if (s->rtcp_socket) {
+    g_object_unref(s->rtcp_socket);
+    s->rtcp_socket = NULL;
+  }
+  splash_rtx_unref(s->rtx);
+  s->rtx = NULL;
+}
+
+static SplashFecEnc* new_fec_enc_locked(Splash *s, guint32 ssrc){
+  int fec_pt = resolve_fec_pt(s->fec_payload_type, resolve_pt(s->payload_type));
+  return splash_fec_enc_new(s->fec, (guint)s->fec_k, (guint)s->fec_n, (guint8)fec_pt,
+                            ssrc, (guint16)g_random_int());
+}
+
+// FEC encoder, kept across sender rebuilds like the retransmission history.
+static void open_fec_locked(Splash *s){
+  if (s->fec == SPLASH_FEC_OFF || !(s->outputs & SPLASH_OUTPUT_UDP)) return;
+  s->fec_enc = new_fec_enc_locked(s, s->fec_ssrc);
+}
+
 static void destroy_pipelines_locked(Splash *s){
+  remove_watch(&s->reader_watch);
+  remove_watch(&s->sender_watch);
+  g_slist_free_full(s->retired_outputs, (GDestroyNotify)splash_output_free);
+  s->retired_outputs = NULL;
+  splash_output_free(s->out_udp);
+  s->out_udp = NULL;
+  splash_output_free(s->out_app);
+  s->out_app = NULL;
+
   if (s->reader){
     gst_element_set_state(s->reader, GST_STATE_NULL);
     gst_object_unref(s->reader);
@@ -190,11 +1053,16 @@ static void destroy_pipelines_locked(Splash *s){
   s->appsink = NULL;
 
   if (s->sender_udp){
+    save_rtp_state_locked(s);
     gst_element_set_state(s->sender_udp, GST_STATE_NULL);
     gst_object_unref(s->sender_udp);
     s->sender_udp=NULL;
   }
   s->appsrc_udp = NULL;
+  s->stats.rtp_mtu = 0;
+  close_rtx_locked(s);
+  splash_fec_enc_unref(s->fec_enc);
+  s->fec_enc = NULL;
 
   if (s->appsrc_out) {
     gst_object_unref(s->appsrc_out);
@@ -202,13 +1070,132 @@ static void destroy_pipelines_locked(Splash *s){
   }
 }
 
-static gboolean build_pipelines_locked(Splash *s, GError **err){
-  // Reader
+// Resolves host:port for probe_rtp_mtu(). May block on DNS, so it must not
+// run under s->lock. Returns the address length, or 0.
+static socklen_t resolve_mtu_dest(const char *host, int port, struct sockaddr_storage *out){
+  struct addrinfo hints, *ai = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_socktype = SOCK_DGRAM;
+  gchar *service = g_strdup_printf("%d", port);
+  int rc = getaddrinfo(host, service, &hints, &ai);
+  g_free(service);
+  if (rc != 0 || !ai) return 0;
+  socklen_t len = 0;
+  if (ai->ai_addrlen <= sizeof(*out)) {
+    memcpy(out, ai->ai_addr, ai->ai_addrlen);
+    len = ai->ai_addrlen;
+  }
+  freeaddrinfo(ai);
+  return len;
+}
+
+// RTP packet size that fits the path MTU towards dest without IP
+// fragmentation (route MTU, or a smaller one learned through PMTU discovery),
+// or 0 when it cannot be determined.
+static int probe_rtp_mtu(const struct sockaddr_storage *dest, socklen_t len){
+#if defined(IP_MTU) && defined(IPV6_MTU)
+  int mtu = 0;
+  gboolean v6 = dest->ss_family == AF_INET6;
+  int fd = socket(dest->ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd >= 0 && connect(fd, (const struct sockaddr*)dest, len) == 0) {
+    int path_mtu = 0;
+    socklen_t optlen = sizeof(path_mtu);
+    if (getsockopt(fd, v6 ? IPPROTO_IPV6 : IPPROTO_IP, v6 ? IPV6_MTU : IP_MTU,
+                   &path_mtu, &optlen) == 0) {
+      mtu = path_mtu - (v6 ? 40 : 20) - 8;
+    }
+  }
+  if (fd >= 0) close(fd);
+  return mtu > 0 ? mtu : 0;
+#else
+  (void)dest; (void)len;
+  return 0;
+#endif
+}
+
+static GstPadProbeReturn on_rtp_packets(GstPad *pad, GstPadProbeInfo *info, gpointer user){
+  (void)pad;
+  Splash *s = (Splash*)user;
+  gssize n = (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+               ? (gssize)gst_buffer_list_length(GST_PAD_PROBE_INFO_BUFFER_LIST(info)) : 1;
+  g_atomic_pointer_add(&s->rtp_packets, n);
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn on_rtp_history(GstPad *pad, GstPadProbeInfo *info, gpointer user){
+  (void)pad;
+  SplashRtx *rtx = (SplashRtx*)user;
+  gint64 now = g_get_monotonic_time();
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+    guint n = gst_buffer_list_length(list);
+    for (guint i = 0; i < n; ++i) {
+      GstMapInfo map;
+      GstBuffer *buf = gst_buffer_list_get(list, i);
+      if (!gst_buffer_map(buf, &map, GST_MAP_READ)) continue;
+      splash_rtx_store(rtx, map.data, map.size, now);
+      gst_buffer_unmap(buf, &map);
+    }
+  } else {
+    GstMapInfo map;
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (gst_buffer_map(buf, &map, GST_MAP_READ)) {
+      splash_rtx_store(rtx, map.data, map.size, now);
+      gst_buffer_unmap(buf, &map);
+    }
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static int rtp_mtu_locked(Splash *s){
+  if (s->mtu == SPLASH_MTU_AUTO) {
+    int probed = s->mtu_dest_len ? probe_rtp_mtu(&s->mtu_dest, s->mtu_dest_len) : 0;
+    return probed > 0 ? probed : DEFAULT_MTU;
+  }
+  return s->mtu > 0 ? s->mtu : DEFAULT_MTU;
+}
+
+// Applies MTU, payload type and aggregation to the sender's payloader and
+// counts the packets it produces (and keeps them for retransmission). Media
+// packets leave room for the FEC header in the repair packets.
+static void configure_payloader_locked(Splash *s){
+  GstElement *pay = gst_bin_get_by_name(GST_BIN(s->sender_udp), "pay");
+  if (!pay) return;
+  int mtu = rtp_mtu_locked(s);
+  g_object_set(G_OBJECT(pay),
+    "mtu", (guint)(mtu - (s->fec_enc ? SPLASH_FEC_OVERHEAD : 0)),
+    "pt", (guint)(s->payload_type > 0 ? s->payload_type : DEFAULT_PT),
+    NULL);
+  // aggregate-mode needs GStreamer 1.18; older payloaders never aggregate
+  if (g_object_class_find_property(G_OBJECT_GET_CLASS(pay), "aggregate-mode")) {
+    gst_util_set_object_arg(G_OBJECT(pay), "aggregate-mode",
+                            s->aggregate == SPLASH_AGGREGATE_NONE ? "none" :
+                            s->aggregate == SPLASH_AGGREGATE_MAX  ? "max" : "zero-latency");
+  }
+  s->stats.rtp_mtu = (guint)mtu;
+  GstPad *pad = gst_element_get_static_pad(pay, "src");
+  if (pad) {
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_rtp_packets, s, NULL);
+    // The pipeline holds its own reference: a retired sender may still be
+    // draining while the history is replaced
+    if (s->rtx) {
+      gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                        on_rtp_history, splash_rtx_ref(s->rtx),
+                        (GDestroyNotify)splash_rtx_unref);
+    }
+    gst_object_unref(pad);
+  }
+  gst_object_unref(pay);
+}
+
+// Legacy reader pipeline (the native reader needs none).
+static gboolean build_reader_locked(Splash *s, GError **err){
   gchar *rdesc = g_strdup_printf(
     "filesrc location=\"%s\" ! "
     "h265parse config-interval=1 ! "
     "video/x-h265,stream-format=byte-stream,alignment=au,framerate=%d/1 ! "
-    "appsink name=srcsink emit-signals=true sync=false drop=false max-buffers=64",
+    "appsink name=srcsink emit-signals=true sync=false drop=false max-buffers=2",
     s->input_path, (int)(s->fps+0.5));
   s->reader = gst_parse_launch(rdesc, err); g_free(rdesc);
   if (!s->reader) return FALSE;
@@ -216,19 +1203,95 @@ static gboolean build_pipelines_locked(Splash *s, GError **err){
   s->appsink = gst_bin_get_by_name(GST_BIN(s->reader), "srcsink");
   g_signal_connect(s->appsink, "new-sample", G_CALLBACK(on_new_sample), s);
   GstBus *rbus = gst_element_get_bus(s->reader);
-  gst_bus_add_watch(rbus, (GstBusFunc)on_reader_bus, s);
+  s->reader_watch = gst_bus_create_watch(rbus);
+  g_source_set_callback(s->reader_watch, (GSourceFunc)on_reader_bus, s, NULL);
+  g_source_attach(s->reader_watch, s->media_ctx);
+  gst_bus_set_sync_handler(rbus, on_stream_status, s, NULL);
   gst_object_unref(rbus);
+  return TRUE;
+}
+
+// Frame rate in an output's caps: the asset's, or the output's frame-rate
+// cap when that is lower.
+static int output_fps(Splash *s, const SplashOutputPolicy *p){
+  int fps = (int)(s->fps+0.5);
+  return p->max_fps > 0 && (int)p->max_fps < fps ? (int)p->max_fps : fps;
+}
+
+// Puts the FEC filter between payloader and udpsink. Like the history, the
+// filter holds its own reference on the encoder.
+static gboolean insert_fec_locked(Splash *s, GError **err){
+  GstElement *pay = gst_bin_get_by_name(GST_BIN(s->sender_udp), "pay");
+  GstElement *sink = gst_bin_get_by_name(GST_BIN(s->sender_udp), "sink");
+  GstElement *fec = splash_fec_filter_new(s->fec_enc);
+  gboolean ok = FALSE;
+  if (pay && sink && fec) {
+    gst_element_unlink(pay, sink);
+    if (gst_bin_add(GST_BIN(s->sender_udp), fec)) {
+      ok = gst_element_link_many(pay, fec, sink, NULL);
+      fec = NULL;         // the bin owns it now
+    }
+  }
+  if (fec) gst_object_unref(fec);
+  if (pay) gst_object_unref(pay);
+  if (sink) gst_object_unref(sink);
+  if (!ok && err) {
+    g_set_error(err, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+                "could not link the FEC filter into the sender");
+  }
+  return ok;
+}
+
+// Frames arrive AU-aligned with parameter sets already in place (native
+// reader injection or the reader's h265parse), so the sender neither
+// re-parses them nor lets the payloader add another copy.
+static gboolean build_sender_locked(Splash *s, GError **err){
+  gchar *sdesc = g_strdup_printf(
+    "appsrc name=src is-live=true format=time do-timestamp=false block=true "
+      "caps=video/x-h265,stream-format=byte-stream,alignment=au,framerate=%d/1 ! "
+    "rtph265pay name=pay config-interval=0 ! "
+    "udpsink name=sink host=%s port=%d sync=true async=false",
+    output_fps(s, &s->udp_policy), s->host, s->port);
+  s->sender_udp = gst_parse_launch(sdesc, err); g_free(sdesc);
+  if (!s->sender_udp) return FALSE;
+  if (s->fec_enc && !insert_fec_locked(s, err)) {
+    gst_object_unref(s->sender_udp);
+    s->sender_udp = NULL;
+    return FALSE;
+  }
+  s->appsrc_udp = gst_bin_get_by_name(GST_BIN(s->sender_udp), "src");
+  configure_payloader_locked(s);
+  if (s->rtcp_socket) {
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(s->sender_udp), "sink");
+    gboolean v6 = g_socket_get_family(s->rtcp_socket) == G_SOCKET_FAMILY_IPV6;
+    g_object_set(G_OBJECT(sink), v6 ? "socket-v6" : "socket", s->rtcp_socket,
+                 "close-socket", FALSE, NULL);
+    gst_object_unref(sink);
+  }
+  if (s->timeline == SPLASH_TIMELINE_PERSISTENT) {
+    GstClock *clock = gst_system_clock_obtain();
+    gst_pipeline_use_clock(GST_PIPELINE(s->sender_udp), clock);
+    gst_object_unref(clock);
+  }
+  watch_stream_status(s, s->sender_udp);
+  if (s->watchdog_ms > 0) {
+    GstBus *sbus = gst_element_get_bus(s->sender_udp);
+    s->sender_watch = gst_bus_create_watch(sbus);
+    g_source_set_callback(s->sender_watch, (GSourceFunc)on_sender_bus, s, NULL);
+    g_source_attach(s->sender_watch, s->media_ctx);
+    gst_object_unref(sbus);
+  }
+  s->out_udp = splash_output_new("udp", s->appsrc_udp, &s->udp_policy,
+                                 apply_stream_sched, s);
+  if (s->ps) watch_output_events(s, s->appsrc_udp);
+  return TRUE;
+}
 
+static gboolean build_pipelines_locked(Splash *s, GError **err){
+  if (!s->index && !build_reader_locked(s, err)) return FALSE;
   if (s->outputs & SPLASH_OUTPUT_UDP) {
-    gchar *sdesc = g_strdup_printf(
-      "appsrc name=src is-live=true format=time do-timestamp=false block=true "
-        "caps=video/x-h265,stream-format=byte-stream,alignment=au,framerate=%d/1 ! "
-      "h265parse config-interval=1 ! rtph265pay pt=97 mtu=1200 config-interval=1 ! "
-      "udpsink host=%s port=%d sync=true async=false",
-      (int)(s->fps+0.5), s->host, s->port);
-    s->sender_udp = gst_parse_launch(sdesc, err); g_free(sdesc);
-    if (!s->sender_udp) return FALSE;
-    s->appsrc_udp = gst_bin_get_by_name(GST_BIN(s->sender_udp), "src");
+    open_fec_locked(s);
+    if (!open_rtx_locked(s, err) || !build_sender_locked(s, err)) return FALSE;
   } else {
     s->sender_udp = NULL;
     s->appsrc_udp = NULL;
@@ -247,7 +1310,7 @@ static gboolean build_pipelines_locked(Splash *s, GError **err){
     GstCaps *caps = gst_caps_new_simple("video/x-h265",
       "stream-format", G_TYPE_STRING, "byte-stream",
       "alignment", G_TYPE_STRING, "au",
-      "framerate", GST_TYPE_FRACTION, (int)(s->fps+0.5), 1,
+      "framerate", GST_TYPE_FRACTION, output_fps(s, &s->appsrc_policy), 1,
       NULL);
     g_object_set(G_OBJECT(s->appsrc_out),
       "is-live", TRUE,
@@ -257,6 +1320,9 @@ static gboolean build_pipelines_locked(Splash *s, GError **err){
       "caps", caps,
       NULL);
     gst_caps_unref(caps);
+    s->out_app = splash_output_new("appsrc", s->appsrc_out, &s->appsrc_policy,
+                                   apply_stream_sched, s);
+    if (s->ps) watch_output_events(s, s->appsrc_out);
   } else {
     s->appsrc_out = NULL;
   }
@@ -264,19 +1330,292 @@ static gboolean build_pipelines_locked(Splash *s, GError **err){
   return TRUE;
 }
 
+// ------------------------------------------------------------------
+// Watchdog
+// ------------------------------------------------------------------
+static void arm_watchdog_locked(Splash *s){
+  if (!s->running || s->watchdog_ms <= 0) {
+    g_source_set_ready_time(s->watchdog_src, -1);
+    return;
+  }
+  gint64 tick_ms = CLAMP(s->watchdog_ms / 4, 10, 250);
+  g_source_set_ready_time(s->watchdog_src, g_get_monotonic_time() + tick_ms * 1000);
+}
+
+// An output is stalled when it pushed nothing for the limit while it had
+// frames to push or its appsrc is rejecting them.
+static gboolean output_stalled(const SplashOutputCounters *c, gint64 since_us,
+                               gint64 now, gint64 limit_us){
+  gint64 idle = now - MAX(c->last_push_us, since_us);
+  return idle > limit_us && (c->queue_depth > 0 || c->failing);
+}
+
+// Counts a stall; report-only stalls are reported once until they clear.
+static void report_stall_locked(Splash *s, SplashStallSource what, gboolean once){
+  guint bit = 1u << what;
+  if (once && (s->stalls_reported & bit)) return;
+  if (once) s->stalls_reported |= bit;
+  s->stats.watchdog_stalls++;
+  emit_evt(s, SPLASH_EVT_STALLED, what, 0, NULL);
+}
+
+// Replaces the UDP sender, continuing its RTP stream: same SSRC, the next
+// sequence number and timestamps on the same running time (same clock and
+// base time). The active sequence, queue and frame timeline are untouched;
+// frames for the old sender are dropped while it is replaced.
+static void recover_sender(Splash *s){
+  g_mutex_lock(&s->lock);
+  GstElement *old = s->sender_udp;
+  if (!old) {
+    g_mutex_unlock(&s->lock);
+    return;
+  }
+  gboolean carry = FALSE;
+  guint ssrc = 0, ts_offset = 0, seq = 0;
+  GstElement *pay = gst_bin_get_by_name(GST_BIN(old), "pay");
+  if (pay) {
+    GstStructure *st = NULL;
+    g_object_get(G_OBJECT(pay), "stats", &st, NULL);
+    if (st) {
+      carry = gst_structure_get_uint(st, "ssrc", &ssrc) &&
+              gst_structure_get_uint(st, "timestamp-offset", &ts_offset) &&
+              gst_structure_get_uint(st, "seqnum", &seq);
+      gst_structure_free(st);
+    }
+    gst_object_unref(pay);
+  }
+  GstClockTime base = gst_element_get_base_time(old);
+  save_rtp_state_locked(s);
+  remove_watch(&s->sender_watch);
+  // The old worker may be blocking the frame source: flushing releases it.
+  splash_output_set_flushing(s->out_udp, TRUE);
+  if (s->out_udp) s->retired_outputs = g_slist_prepend(s->retired_outputs, s->out_udp);
+  s->out_udp = NULL;
+  s->sender_udp = NULL;
+  s->appsrc_udp = NULL;
+  s->sender_error_us = 0;
+  g_mutex_unlock(&s->lock);
+
+  gst_element_set_state(old, GST_STATE_NULL);
+  gst_object_unref(old);
+
+  g_mutex_lock(&s->lock);
+  if (s->sender_udp || !(s->outputs & SPLASH_OUTPUT_UDP)) { // reconfigured meanwhile
+    g_mutex_unlock(&s->lock);
+    return;
+  }
+  GError *err = NULL;
+  if (!build_sender_locked(s, &err)) {
+    s->recover_udp_us = 0;
+    g_mutex_unlock(&s->lock);
+    emit_evt(s, SPLASH_EVT_ERROR, 0, 0, err ? err->message : "sender rebuild failed");
+    g_clear_error(&err);
+    if (s->loop) g_main_loop_quit(s->loop);
+    return;
+  }
+  if (s->running) {
+    if (s->timeline == SPLASH_TIMELINE_PERSISTENT) {
+      prepare_sender_timeline_locked(s);
+    } else {
+      GstClock *clock = gst_system_clock_obtain();
+      gst_pipeline_use_clock(GST_PIPELINE(s->sender_udp), clock);
+      gst_object_unref(clock);
+      pay = gst_bin_get_by_name(GST_BIN(s->sender_udp), "pay");
+      if (pay && carry) {
+        g_object_set(G_OBJECT(pay),
+          "ssrc", ssrc,
+          "timestamp-offset", ts_offset,
+          "seqnum-offset", (gint)((seq + 1) & 0xffff),
+          NULL);
+      }
+      if (pay) gst_object_unref(pay);
+      gst_element_set_start_time(s->sender_udp, GST_CLOCK_TIME_NONE);
+      gst_element_set_base_time(s->sender_udp, base);
+    }
+    gst_element_set_state(s->sender_udp, GST_STATE_PLAYING);
+    s->rtp_sending = TRUE;
+    s->watch_since_us = g_get_monotonic_time();
+  }
+  g_mutex_unlock(&s->lock);
+}
+
+// Replaces the legacy reader pipeline and seeks it back into the active
+// sequence; the queue, repeat order and output timestamps carry on.
+static void recover_reader(Splash *s){
+  g_mutex_lock(&s->lock);
+  GstElement *old = s->reader;
+  if (!old) {
+    g_mutex_unlock(&s->lock);
+    return;
+  }
+  remove_watch(&s->reader_watch);
+  s->reader = NULL;
+  s->appsink = NULL;
+  s->reader_error_us = 0;
+  g_mutex_unlock(&s->lock);
+
+  gst_element_set_state(old, GST_STATE_NULL);
+  gst_object_unref(old);
+
+  g_mutex_lock(&s->lock);
+  if (s->reader || s->index) { // reconfigured meanwhile
+    g_mutex_unlock(&s->lock);
+    return;
+  }
+  GError *err = NULL;
+  if (!build_reader_locked(s, &err)) {
+    s->recover_reader_us = 0;
+    g_mutex_unlock(&s->lock);
+    emit_evt(s, SPLASH_EVT_ERROR, 0, 0, err ? err->message : "reader rebuild failed");
+    g_clear_error(&err);
+    if (s->loop) g_main_loop_quit(s->loop);
+    return;
+  }
+  if (s->running) {
+    gst_element_set_state(s->reader, s->paused ? GST_STATE_PAUSED : GST_STATE_PLAYING);
+    do_segment_seek_locked(s, s->active_idx);
+    arm_timer_locked(s);
+    s->watch_since_us = g_get_monotonic_time();
+  }
+  g_mutex_unlock(&s->lock);
+}
+
+// Media thread, every watchdog_ms / 4 while running (and at once on a
+// pipeline error). Outputs are checked first: a blocked output also starves
+// the frame source, which must not be mistaken for a reader stall.
+static gboolean on_watchdog(gpointer user){
+  Splash *s = (Splash*)user;
+  g_mutex_lock(&s->lock);
+  if (s->delivering == 0 && s->retired_outputs) {
+    g_slist_free_full(s->retired_outputs, (GDestroyNotify)splash_output_free);
+    s->retired_outputs = NULL;
+  }
+  gboolean rebuild_udp = FALSE, rebuild_reader = FALSE;
+  if (s->running && !s->paused && s->watchdog_ms > 0) {
+    gint64 now = g_get_monotonic_time();
+    gint64 limit = MAX((gint64)s->watchdog_ms * 1000, 2 * (gint64)(s->dur / GST_USECOND));
+    gboolean outputs_stalled = FALSE;
+    SplashOutputCounters c;
+
+    if (s->out_udp) {
+      splash_output_get_counters(s->out_udp, &c);
+      if (s->recover_udp_us > 0 && c.first_push_us > 0) {
+        record_recovery_locked(s, SPLASH_STALL_UDP, s->recover_udp_us);
+        s->recover_udp_us = 0;
+      }
+      if (s->sender_error_us || output_stalled(&c, s->watch_since_us, now, limit)) {
+        if (!s->recover_udp_us) s->recover_udp_us = s->sender_error_us ? s->sender_error_us : now;
+        report_stall_locked(s, SPLASH_STALL_UDP, FALSE);
+        rebuild_udp = outputs_stalled = TRUE;
+      }
+    }
+    if (s->out_app) {
+      splash_output_get_counters(s->out_app, &c);
+      if (output_stalled(&c, s->watch_since_us, now, limit)) {
+        report_stall_locked(s, SPLASH_STALL_APPSRC, TRUE);
+        outputs_stalled = TRUE;
+      } else {
+        s->stalls_reported &= ~(1u << SPLASH_STALL_APPSRC);
+      }
+    }
+    if (!s->pulling) {
+      gint64 idle = now - MAX(s->last_frame_us, s->watch_since_us);
+      if (s->reader_error_us || (idle > limit && !outputs_stalled)) {
+        if (s->reader) {
+          if (!s->recover_reader_us) {
+            s->recover_reader_us = s->reader_error_us ? s->reader_error_us : now;
+          }
+          report_stall_locked(s, SPLASH_STALL_READER, FALSE);
+          rebuild_reader = TRUE;
+        } else {
+          report_stall_locked(s, SPLASH_STALL_READER, TRUE);
+        }
+      } else {
+        s->stalls_reported &= ~(1u << SPLASH_STALL_READER);
+      }
+    }
+  }
+  g_mutex_unlock(&s->lock);
+
+  if (rebuild_udp) recover_sender(s);
+  if (rebuild_reader) recover_reader(s);
+
+  g_mutex_lock(&s->lock);
+  arm_watchdog_locked(s);
+  g_mutex_unlock(&s->lock);
+  return G_SOURCE_CONTINUE;
+}
+
 // ------------------------------------------------------------------
 // Public API
 // ------------------------------------------------------------------
-Splash* splash_new(void){
+#ifdef SPLASH_GST_STATIC
+// make GST_STATIC=1: exactly the plugins behind the elements the library
+// creates, linked in and registered without touching the plugin directories.
+GST_PLUGIN_STATIC_DECLARE(coreelements);     // filesrc, capsfilter
+GST_PLUGIN_STATIC_DECLARE(app);              // appsrc, appsink
+GST_PLUGIN_STATIC_DECLARE(rtp);              // rtph265pay
+GST_PLUGIN_STATIC_DECLARE(udp);              // udpsink
+GST_PLUGIN_STATIC_DECLARE(videoparsersbad);  // h265parse (legacy reader)
+
+static void register_static_plugins(void){
+  GST_PLUGIN_STATIC_REGISTER(coreelements);
+  GST_PLUGIN_STATIC_REGISTER(app);
+  GST_PLUGIN_STATIC_REGISTER(rtp);
+  GST_PLUGIN_STATIC_REGISTER(udp);
+  GST_PLUGIN_STATIC_REGISTER(videoparsersbad);
+}
+#endif
+
+static gboolean gst_ready;
+static gint64 gst_init_us;
+
+bool splash_init(SplashInitMode mode){
   static gsize once = 0;
   if (g_once_init_enter(&once)) {
-    int argc=0; char **argv=NULL;
-    gst_init(&argc, &argv);
+    gint64 t0 = g_get_monotonic_time();
+    gboolean fast = mode == SPLASH_INIT_FAST;
+    char *args[] = { (char*)"splash", (char*)"--gst-disable-registry-update", NULL };
+    int argc = fast ? 2 : 1;
+    char **argv = args;
+    if (fast) gst_registry_fork_set_enabled(FALSE);
+#ifdef SPLASH_GST_STATIC
+    // Nothing to find on disk: keep a registry update (if one still runs)
+    // from walking the system plugin directories.
+    if (fast) g_setenv("GST_PLUGIN_SYSTEM_PATH_1_0", "", FALSE);
+#endif
+    GError *err = NULL;
+    gst_ready = gst_init_check(&argc, &argv, &err);
+    if (!gst_ready) {
+      g_warning("GStreamer initialisation failed: %s", err ? err->message : "unknown error");
+      g_clear_error(&err);
+    }
+#ifdef SPLASH_GST_STATIC
+    if (gst_ready) register_static_plugins();
+#endif
+    gst_init_us = g_get_monotonic_time() - t0;
     g_once_init_leave(&once, 1);
   }
+  return gst_ready;
+}
+
+Splash* splash_new(void){
+  if (!splash_init(SPLASH_INIT_DEFAULT)) return NULL;
   Splash *s = g_new0(Splash, 1);
   g_mutex_init(&s->lock);
+  g_cond_init(&s->pace_cond);
   s->loop = g_main_loop_new(NULL, FALSE);
+  s->events = splash_events_new(EVENT_QUEUE_SIZE);
+  s->media_ctx = g_main_context_new();
+  s->media_loop = g_main_loop_new(s->media_ctx, FALSE);
+  s->timers = splash_timers_new();
+  s->timer_src = g_source_new(&timer_funcs, sizeof(GSource));
+  g_source_set_callback(s->timer_src, on_timer_due, s, NULL);
+  g_source_attach(s->timer_src, s->media_ctx);
+  s->watchdog_src = g_source_new(&timer_funcs, sizeof(GSource));
+  g_source_set_callback(s->watchdog_src, on_watchdog, s, NULL);
+  g_source_attach(s->watchdog_src, s->media_ctx);
+  s->media_thread = g_thread_new("splash-media", media_main, s);
   s->fps = 30.0;
   s->dur = (GstClockTime)(GST_SECOND/30.0 + 0.5);
   s->outputs = SPLASH_OUTPUT_UDP;
@@ -287,6 +1626,15 @@ Splash* splash_new(void){
   s->loop_count = 0;
   s->queue_version = 0;
   s->loop_version = 0;
+  s->cursor = -1;
+  s->probe_seq = -1;
+  s->stats.first_packet_us = -1;
+  s->stats.resume_latency_us = -1;
+  s->rtp_ssrc = g_random_int();
+  s->rtp_ts_base = g_random_int();
+  s->rtp_seq_next = (guint)g_random_int_range(0, 0x10000);
+  s->rtx_ssrc = g_random_int();
+  s->fec_ssrc = g_random_int();
   return s;
 }
 
@@ -295,17 +1643,68 @@ void splash_free(Splash *s){
   splash_stop(s);
   g_mutex_lock(&s->lock);
   destroy_pipelines_locked(s);
+  close_index_locked(s);
   for (int i=0;i>s->nseq;i++){ free_str(&s->seqs[i].name); }
   for (int i=0;i<s->nseq;i++){ free_str(&s->seqs[i].name); } // fixed loop
-  free_str(&s->input_path); free_str(&s->host);
+  free_str(&s->input_path); free_str(&s->host); free_str(&s->index_path);
   g_mutex_unlock(&s->lock);
+  g_main_loop_quit(s->media_loop);
+  g_thread_join(s->media_thread);
+  g_source_destroy(s->timer_src);
+  g_source_unref(s->timer_src);
+  g_source_destroy(s->watchdog_src);
+  g_source_unref(s->watchdog_src);
+  splash_timers_free(s->timers);
+  g_main_loop_unref(s->media_loop);
+  g_main_context_unref(s->media_ctx);
+  splash_events_free(s->events);
   if (s->loop) g_main_loop_unref(s->loop);
+  g_cond_clear(&s->pace_cond);
   g_mutex_clear(&s->lock);
   g_free(s);
 }
 
 void splash_set_event_cb(Splash *s, SplashEventCb cb, void *user){
-  s->evt_cb = cb; s->evt_user = user;
+  splash_events_set_callback(s->events, cb, user);
+}
+
+void splash_get_status(Splash *s, SplashStatus *out){
+  if (!s || !out) return;
+  g_mutex_lock(&s->lock);
+  out->running = s->running;
+  out->paused = s->paused;
+  out->active_idx = s->active_idx;
+  out->pending_idx = s->pending_count > 0 ? s->pending_queue[0] : -1;
+  out->queue_depth = s->pending_count;
+  out->running_us = s->running ? g_get_monotonic_time() - s->start_us : 0;
+  out->frames_pushed = s->stats.frames_pushed;
+  g_mutex_unlock(&s->lock);
+}
+
+void splash_get_stats(Splash *s, SplashStats *out){
+  if (!s || !out) return;
+  g_mutex_lock(&s->lock);
+  *out = s->stats;
+  out->sched_pending = splash_timers_count(s->timers);
+  if (s->start_us > 0) out->cpu_us = process_cpu_us() - s->start_cpu_us;
+  SplashCacheCounters cc = {0};
+  splash_cache_get_counters(s->cache, &cc);
+  splash_output_get_counters(s->out_udp, &out->udp);
+  splash_output_get_counters(s->out_app, &out->appsrc);
+  splash_rtx_get_stats(s->rtx, &out->rtx);
+  splash_fec_enc_get_stats(s->fec_enc, &out->fec);
+  g_mutex_unlock(&s->lock);
+  out->sched_threads = (guint)g_atomic_int_get(&s->sched_threads);
+  out->sched_failures = (guint)g_atomic_int_get(&s->sched_failures);
+  out->events_dropped = splash_events_dropped(s->events);
+  out->gst_init_us = gst_init_us;
+  out->rtp_packets = (guint64)(gsize)g_atomic_pointer_get(&s->rtp_packets);
+  out->cache_hits = cc.hits;
+  out->cache_misses = cc.misses;
+  out->cache_evictions = cc.evictions;
+  out->cache_bytes_used = cc.bytes_used;
+  out->cache_bytes_pinned = cc.bytes_pinned;
+  out->cache_frames_pinned = cc.frames_pinned;
 }
 
 bool splash_set_sequences(Splash *s, const SplashSeq *seqs, int n_seqs){
@@ -343,36 +1742,110 @@ bool splash_set_sequences(Splash *s, const SplashSeq *seqs, int n_seqs){
   s->pending_count = w;
   s->loop_count = 0;
   s->queue_version++;
+  repin_cache_locked(s);
 
   g_mutex_unlock(&s->lock);
   return true;
 }
 
+bool splash_check_config(const SplashConfig *cfg){
+  if (!cfg || !cfg->input_path || cfg->fps <= 0.1) return false;
+  SplashOutputMode outputs = cfg->outputs;
+  if ((outputs & ~(SPLASH_OUTPUT_UDP | SPLASH_OUTPUT_APPSRC | SPLASH_OUTPUT_PULL)) != 0 ||
+      ((outputs & SPLASH_OUTPUT_PULL) && outputs != SPLASH_OUTPUT_PULL) ||
+      ((outputs & SPLASH_OUTPUT_PULL) && cfg->index_mode == SPLASH_INDEX_OFF)) {
+    return false;
+  }
+  if (outputs == SPLASH_OUTPUT_NONE) outputs = SPLASH_OUTPUT_UDP;
+  if ((outputs & SPLASH_OUTPUT_UDP) &&
+      (!cfg->endpoint.host || cfg->endpoint.port <= 0 ||
+       (cfg->mtu != SPLASH_MTU_AUTO && cfg->mtu != 0 && (cfg->mtu < 64 || cfg->mtu > 65507)) ||
+       (cfg->payload_type != 0 && (cfg->payload_type < 96 || cfg->payload_type > 127)) ||
+       (cfg->rtx_payload_type != 0 &&
+        (cfg->rtx_payload_type < 96 || cfg->rtx_payload_type > 127)) ||
+       cfg->rtcp_port < 0 || cfg->rtcp_port > 65535 ||
+       cfg->fec_k < 0 || cfg->fec_k >= SPLASH_FEC_MAX_N ||
+       (cfg->fec_n != 0 && (cfg->fec_n <= (cfg->fec_k > 0 ? cfg->fec_k : DEFAULT_FEC_K) ||
+                            cfg->fec_n > SPLASH_FEC_MAX_N)) ||
+       (cfg->fec_payload_type != 0 &&
+        (cfg->fec_payload_type < 96 || cfg->fec_payload_type > 127)))) {
+    return false;
+  }
+  // Receivers tell media, retransmissions and repair packets apart by type
+  if (outputs & SPLASH_OUTPUT_UDP) {
+    int pt = resolve_pt(cfg->payload_type);
+    int rtx_pt = cfg->rtx_history > 0 ? resolve_rtx_pt(cfg->rtx_payload_type, pt) : -1;
+    int fec_pt = cfg->fec != SPLASH_FEC_OFF ? resolve_fec_pt(cfg->fec_payload_type, pt) : -2;
+    if (rtx_pt == pt || fec_pt == pt || rtx_pt == fec_pt) return false;
+  }
+  return true;
+}
+
 bool splash_apply_config(Splash *s, const SplashConfig *cfg){
-  if (!s || !cfg || !cfg->input_path || cfg->fps <= 0.1) return false;
+  // Rejected before anything stops or changes
+  if (!s || !splash_check_config(cfg)) return false;
+  g_mutex_lock(&s->lock);
+  gboolean rendering = s->rendering;
+  g_mutex_unlock(&s->lock);
+  if (rendering) return false;
+  // Looked up here, before anything stops, so pipeline (re)builds under the
+  // lock never wait for DNS
+  struct sockaddr_storage mtu_dest;
+  socklen_t mtu_dest_len = 0;
+  if (cfg->mtu == SPLASH_MTU_AUTO &&
+      (cfg->outputs == SPLASH_OUTPUT_NONE || (cfg->outputs & SPLASH_OUTPUT_UDP))) {
+    mtu_dest_len = resolve_mtu_dest(cfg->endpoint.host, cfg->endpoint.port, &mtu_dest);
+  }
 
+  stop_feeder(s);
   g_mutex_lock(&s->lock);
+  if (s->rendering) {
+    g_mutex_unlock(&s->lock);
+    return false;
+  }
   // store config
   dup_cstr(&s->input_path, cfg->input_path);
+  dup_cstr(&s->index_path, cfg->index_path);
+  s->index_mode = cfg->index_mode;
+  s->cache_bytes = cfg->cache_bytes;
+  s->cache_pin_frames = cfg->cache_pin_frames;
+  s->decompress_threads = cfg->decompress_threads;
+  s->index_threads = cfg->index_threads;
+  s->ps_interval_ms = cfg->ps_interval_ms;
+  s->timeline = cfg->timeline;
+  s->watchdog_ms = MAX(cfg->watchdog_ms, 0);
+  s->latency_sei = cfg->latency_sei;
+  s->rtx_history = MAX(cfg->rtx_history, 0);
+  s->rtx_payload_type = cfg->rtx_payload_type;
+  s->rtcp_port = cfg->rtcp_port;
+  s->fec = cfg->fec;
+  s->fec_k = cfg->fec_k > 0 ? cfg->fec_k : DEFAULT_FEC_K;
+  s->fec_n = cfg->fec_n > 0 ? cfg->fec_n : s->fec_k + 2;
+  s->fec_payload_type = cfg->fec_payload_type;
+  s->udp_policy = cfg->udp_policy;
+  s->appsrc_policy = cfg->appsrc_policy;
+  s->stream_sched = cfg->stream_sched;
+  if (memcmp(&s->media_sched, &cfg->media_sched, sizeof(s->media_sched)) != 0) {
+    s->media_sched = cfg->media_sched;
+    g_main_context_invoke(s->media_ctx, apply_media_sched, s);
+  }
   s->fps = cfg->fps;
   s->dur = (GstClockTime)(GST_SECOND / s->fps + 0.5);
   SplashOutputMode outputs = cfg->outputs;
-  if ((outputs & ~(SPLASH_OUTPUT_UDP | SPLASH_OUTPUT_APPSRC)) != 0) {
-    g_mutex_unlock(&s->lock);
-    return false;
-  }
   if (outputs == SPLASH_OUTPUT_NONE) outputs = SPLASH_OUTPUT_UDP;
-  if ((outputs & SPLASH_OUTPUT_UDP) && (!cfg->endpoint.host || cfg->endpoint.port <= 0)) {
-    g_mutex_unlock(&s->lock);
-    return false;
-  }
   s->outputs = outputs;
   if (outputs & SPLASH_OUTPUT_UDP) {
     dup_cstr(&s->host, cfg->endpoint.host ? cfg->endpoint.host : "127.0.0.1");
     s->port = cfg->endpoint.port;
+    s->mtu = cfg->mtu;
+    if (mtu_dest_len) memcpy(&s->mtu_dest, &mtu_dest, mtu_dest_len);
+    s->mtu_dest_len = mtu_dest_len;
+    s->payload_type = cfg->payload_type;
+    s->aggregate = cfg->aggregate;
   } else {
     free_str(&s->host);
     s->port = 0;
+    s->mtu_dest_len = 0;
   }
 
   // recompute sequence segment times (fps may have changed)
@@ -384,10 +1857,23 @@ bool splash_apply_config(Splash *s, const SplashConfig *cfg){
   // rebuild pipelines
   destroy_pipelines_locked(s);
   GError *err=NULL;
-  if (!build_pipelines_locked(s, &err)){
+  gboolean built = open_index_locked(s, &err);
+  if (built && (s->outputs & SPLASH_OUTPUT_PULL) && !s->index) {
+    g_set_error(&err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ,
+                "pull output needs a frame index, but '%s' could not be indexed",
+                s->input_path);
+    built = FALSE;
+  }
+  repin_cache_locked(s);
+  if (!built || !build_pipelines_locked(s, &err)){
     char buf[256]; buf[0]=0;
     if (err && err->message) g_strlcpy(buf, err->message, sizeof(buf));
     if (err) g_error_free(err);
+    // Nothing is left to play: stopped until the next start
+    s->running = FALSE;
+    s->paused = FALSE;
+    arm_timer_locked(s);
+    arm_watchdog_locked(s);
     g_mutex_unlock(&s->lock);
     emit_evt(s, SPLASH_EVT_ERROR, 0, 0, buf[0]?buf: "pipeline build failed");
     return false;
@@ -399,15 +1885,79 @@ bool splash_apply_config(Splash *s, const SplashConfig *cfg){
 }
 
 bool splash_start(Splash *s){
-  if (!s || !s->reader) return false;
+  if (!s) return false;
+  stop_feeder(s);
   g_mutex_lock(&s->lock);
-  if (s->sender_udp)
+  if (s->rendering || (!s->reader && !s->index)) {
+    g_mutex_unlock(&s->lock);
+    return false;
+  }
+  s->start_us = g_get_monotonic_time();
+  s->pts_base = 0;
+  if (s->timeline == SPLASH_TIMELINE_PERSISTENT) {
+    if (s->anchor_us == 0) {
+      GstClock *clock = gst_system_clock_obtain();
+      s->anchor_clock = gst_clock_get_time(clock);
+      s->anchor_us = g_get_monotonic_time();
+      gst_object_unref(clock);
+    }
+    s->pts_base = (GstClockTime)(s->start_us - s->anchor_us) * GST_USECOND;
+    prepare_sender_timeline_locked(s);
+  }
+  if (s->sender_udp) {
     gst_element_set_state(s->sender_udp, GST_STATE_PLAYING);
+    s->rtp_sending = TRUE;
+  }
 
-  gst_element_set_state(s->reader, GST_STATE_PLAYING);
   if (s->active_idx < 0 && s->nseq>0) s->active_idx = 0;
-  do_segment_seek_locked(s, s->active_idx);
-  s->next_pts = 0;
+  s->next_pts = s->pts_base;
+  s->running = TRUE;
+  s->paused = FALSE;
+  s->resume_at_us = 0;
+  s->start_cpu_us = process_cpu_us();
+  s->feeder_stop = FALSE;
+  reset_probes_locked(s);
+  s->stats.first_packet_us = -1;
+  g_atomic_pointer_set(&s->rtp_packets, 0);
+  splash_rtx_reset_stats(s->rtx);
+  splash_fec_enc_reset_stats(s->fec_enc);
+  s->stats.frames_pushed = 0;
+  s->stats.bytes_pushed = 0;
+  s->stats.ps_bytes_stripped = 0;
+  s->stats.ps_bytes_injected = 0;
+  s->stats.ps_injections = 0;
+  s->stats.resume_latency_us = -1;
+  s->stats.resume_latency_max_us = 0;
+  s->stats.sched_switches = 0;
+  s->stats.sched_error_us = 0;
+  s->stats.sched_error_max_us = 0;
+  s->stats.watchdog_stalls = 0;
+  s->stats.watchdog_recoveries = 0;
+  s->stats.recovery_us = 0;
+  s->stats.recovery_max_us = 0;
+  s->watch_since_us = s->start_us;
+  s->last_frame_us = 0;
+  s->reader_error_us = 0;
+  s->sender_error_us = 0;
+  s->recover_reader_us = 0;
+  s->recover_udp_us = 0;
+  s->stalls_reported = 0;
+  splash_output_reset_counters(s->out_udp);
+  splash_output_reset_counters(s->out_app);
+  splash_output_set_flushing(s->out_udp, FALSE);
+  splash_output_set_flushing(s->out_app, FALSE);
+  if (s->reader) {
+    gst_element_set_state(s->reader, GST_STATE_PLAYING);
+    do_segment_seek_locked(s, s->active_idx);
+    arm_timer_locked(s);
+  } else {
+    s->cursor = -1;
+    s->ps_resend = TRUE;
+    s->ps_join = FALSE;
+    s->pulling = (s->outputs & SPLASH_OUTPUT_PULL) != 0;
+    if (!s->pulling) s->feeder = g_thread_new("splash-feeder", feeder_main, s);
+  }
+  arm_watchdog_locked(s);
   g_mutex_unlock(&s->lock);
   emit_evt(s, SPLASH_EVT_STARTED, 0, 0, NULL);
   return true;
@@ -424,13 +1974,103 @@ void splash_quit(Splash *s){
 }
 
 void splash_stop(Splash *s){
+  stop_feeder(s);
   g_mutex_lock(&s->lock);
+  s->pulling = FALSE;
+  s->running = FALSE;
+  s->paused = FALSE;
+  arm_timer_locked(s);
+  arm_watchdog_locked(s);
   if (s->reader) gst_element_set_state(s->reader, GST_STATE_NULL);
+  splash_output_set_flushing(s->out_udp, TRUE);
+  splash_output_set_flushing(s->out_app, TRUE);
+  save_rtp_state_locked(s);
   if (s->sender_udp) gst_element_set_state(s->sender_udp, GST_STATE_NULL);
   g_mutex_unlock(&s->lock);
   emit_evt(s, SPLASH_EVT_STOPPED, 0, 0, NULL);
 }
 
+bool splash_pause(Splash *s){
+  if (!s) return false;
+  g_mutex_lock(&s->lock);
+  gboolean ok = s->running && !s->paused && !s->pulling;
+  GstElement *reader = NULL;
+  if (ok) {
+    s->paused = TRUE;
+    if (s->reader) reader = gst_object_ref(s->reader);
+  }
+  g_mutex_unlock(&s->lock);
+  if (reader) {
+    gst_element_set_state(reader, GST_STATE_PAUSED);
+    gst_object_unref(reader);
+  }
+  if (ok) emit_evt(s, SPLASH_EVT_PAUSED, 0, 0, NULL);
+  return ok;
+}
+
+bool splash_resume(Splash *s, bool restart_sequence){
+  if (!s) return false;
+  g_mutex_lock(&s->lock);
+  gboolean ok = s->running && s->paused;
+  GstElement *reader = NULL;
+  if (ok) {
+    // The outputs' running time kept advancing while paused: continue at
+    // "now" so the first frame is on time rather than late.
+    gint64 now = g_get_monotonic_time();
+    GstClockTime live = s->pts_base + (GstClockTime)(now - s->start_us) * GST_USECOND;
+    if (s->next_pts < live) s->next_pts = live;
+    s->paused = FALSE;
+    s->resume_at_us = now;
+    s->watch_since_us = now;
+    s->ps_resend = TRUE;
+    if (restart_sequence) {
+      if (s->reader) do_segment_seek_locked(s, s->active_idx);
+      else s->cursor = -1;
+    }
+    if (s->reader) reader = gst_object_ref(s->reader);
+    g_cond_broadcast(&s->pace_cond);
+  }
+  g_mutex_unlock(&s->lock);
+  if (reader) {
+    gst_element_set_state(reader, GST_STATE_PLAYING);
+    gst_object_unref(reader);
+  }
+  if (ok) emit_evt(s, SPLASH_EVT_RESUMED, restart_sequence ? 1 : 0, 0, NULL);
+  return ok;
+}
+
+guint splash_schedule_at(Splash *s, int idx, gint64 when_ns, SplashClockId clock){
+  if (!s) return 0;
+  gint64 now = g_get_monotonic_time();
+  gint64 due_us = when_ns / 1000;
+  if (clock == SPLASH_CLOCK_REALTIME) due_us += now - g_get_real_time();
+  g_mutex_lock(&s->lock);
+  guint id = 0;
+  if (idx >= 0 && idx < s->nseq) {
+    id = splash_timers_add(s->timers, due_us, idx);
+    arm_timer_locked(s);
+  }
+  g_mutex_unlock(&s->lock);
+  return id;
+}
+
+bool splash_schedule_cancel(Splash *s, guint id){
+  if (!s) return false;
+  g_mutex_lock(&s->lock);
+  gboolean ok = splash_timers_cancel(s->timers, id);
+  arm_timer_locked(s);
+  g_mutex_unlock(&s->lock);
+  return ok;
+}
+
+void splash_schedule_clear(Splash *s){
+  if (!s) return;
+  g_mutex_lock(&s->lock);
+  splash_timers_clear(s->timers);
+  arm_timer_locked(s);
+  g_mutex_unlock(&s->lock);
+}
+
 // ---- Queue control ----
 bool splash_enqueue_next_by_index(Splash *s, int idx){
   return splash_enqueue_next_many(s, &idx, 1);
@@ -516,13 +2156,8 @@ bool splash_enqueue_next_many(Splash *s, const int *indices, int n_indices){
     s->pending_queue[s->pending_count++] = indices[i];
   }
   s->queue_version++;
-  int to_emit[MAX_QUEUE];
-  int emit_count = n_indices;
-  for (int i = 0; i < emit_count; ++i) to_emit[i] = indices[i];
   g_mutex_unlock(&s->lock);
-  for (int i = 0; i < emit_count; ++i) {
-    emit_evt(s, SPLASH_EVT_QUEUED_NEXT, to_emit[i], 0, NULL);
-  }
+  emit_evt(s, SPLASH_EVT_QUEUED_NEXT, indices[0], n_indices, NULL);
   return true;
 }
 
@@ -563,3 +2198,193 @@ GstElement* splash_get_appsrc(Splash *s){
   g_mutex_unlock(&s->lock);
   return out;
 }
+
+GstBuffer* splash_pull_frame(Splash *s){
+  if (!s) return NULL;
+  g_mutex_lock(&s->lock);
+  gboolean ok = s->pulling && s->index;
+  g_mutex_unlock(&s->lock);
+  if (!ok) return NULL;
+
+  GstBuffer *buf = read_next_frame(s);
+  if (!buf) {
+    emit_evt(s, SPLASH_EVT_ERROR, 0, 0, "failed to read frame from input");
+    return NULL;
+  }
+  buf = gst_buffer_make_writable(buf);
+  g_mutex_lock(&s->lock);
+  GST_BUFFER_PTS(buf)      = s->next_pts;
+  GST_BUFFER_DTS(buf)      = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION(buf) = s->dur;
+  s->next_pts += s->dur;
+  g_mutex_unlock(&s->lock);
+  account_frame(s, gst_buffer_get_size(buf), TRUE);
+  return buf;
+}
+
+typedef struct {
+  SplashPcap *pcap;
+  gint64 ts_us;
+  guint64 packets;        // media packets
+  guint64 repair_packets;
+  SplashFecEnc *fec;      // NULL without fec
+  gboolean failed;        // a repair packet could not be written
+} RenderSink;
+
+static void render_repair(const guint8 *pkt, gsize len, gpointer user){
+  RenderSink *rs = (RenderSink*)user;
+  rs->repair_packets++;
+  if (!splash_pcap_write(rs->pcap, rs->ts_us, pkt, len)) rs->failed = TRUE;
+}
+
+// Repair packets follow the media packet that ends their block, as they
+// leave the sender.
+static gboolean render_packet(const guint8 *pkt, gsize len, gpointer user){
+  RenderSink *rs = (RenderSink*)user;
+  rs->packets++;
+  if (!splash_pcap_write(rs->pcap, rs->ts_us, pkt, len)) return FALSE;
+  if (rs->fec) splash_fec_enc_push(rs->fec, pkt, len, render_repair, rs);
+  return !rs->failed;
+}
+
+static gboolean render_step(Splash *s, const SplashRenderStep *st){
+  if (st->op == SPLASH_RENDER_CLEAR) {
+    splash_clear_next(s);
+    return TRUE;
+  }
+  return splash_enqueue_with_repeat(s, st->indices, st->n_indices, st->repeat);
+}
+
+bool splash_render(Splash *s, const SplashRenderStep *script, int n_steps,
+                   guint64 n_frames, const char *path, SplashRenderFormat format,
+                   SplashRenderStats *out){
+  SplashRenderStats st = {0};
+  if (out) *out = st;
+  if (!s || !path || n_steps < 0 || (n_steps > 0 && !script)) return false;
+  for (int i = 1; i < n_steps; ++i) {
+    if (script[i].frame < script[i - 1].frame) return false;
+  }
+
+  g_mutex_lock(&s->lock);
+  const char *why = NULL;
+  if (!s->index) why = "render needs the frame index";
+  else if (s->running || s->rendering) why = "render needs a stopped handle";
+  if (why) {
+    g_mutex_unlock(&s->lock);
+    emit_evt(s, SPLASH_EVT_ERROR, 0, 0, why);
+    return false;
+  }
+  s->rendering = TRUE;
+  if (s->active_idx < 0 && s->nseq > 0) s->active_idx = 0;
+  s->cursor = -1;
+  s->ps_resend = TRUE;
+  s->ps_join = FALSE;
+  s->pts_base = 0;
+  s->next_pts = 0;
+  reset_probes_locked(s);
+  GstClockTime dur = s->dur;
+  int mtu = rtp_mtu_locked(s);
+  guint8 pt = (guint8)(s->payload_type > 0 ? s->payload_type : DEFAULT_PT);
+  SplashAggregateMode aggregate = s->aggregate;
+  gchar *host = g_strdup(s->host);
+  int port = s->port > 0 ? s->port : DEFAULT_PORT;
+  SplashFecEnc *fec = format == SPLASH_RENDER_RTP_PCAP && s->fec != SPLASH_FEC_OFF ?
+                      new_fec_enc_locked(s, g_random_int()) : NULL;
+  g_mutex_unlock(&s->lock);
+
+  GError *err = NULL;
+  FILE *f = NULL;
+  SplashRtp *rtp = NULL;
+  RenderSink sink = { NULL, g_get_real_time(), 0, 0, fec, FALSE };
+  if (format == SPLASH_RENDER_RTP_PCAP) {
+    sink.pcap = splash_pcap_open(path, host, port, &err);
+    // Same room for the FEC header as configure_payloader_locked() leaves
+    rtp = splash_rtp_new((guint)(mtu - (fec ? SPLASH_FEC_OVERHEAD : 0)), pt, aggregate, g_random_int(),
+                         (guint16)g_random_int(), g_random_int());
+    if (!err && !rtp) {
+      g_set_error(&err, GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "invalid RTP mtu %d", mtu);
+    }
+  } else if (!(f = fopen(path, "wb"))) {
+    int e = errno;
+    g_set_error(&err, G_FILE_ERROR, g_file_error_from_errno(e),
+                "cannot create '%s': %s", path, g_strerror(e));
+  } else {
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+  }
+  gint64 ts0 = sink.ts_us;
+  gint64 t0 = g_get_monotonic_time();
+  int next_step = 0;
+  for (guint64 n = 0; !err && n < n_frames; ++n) {
+    while (next_step < n_steps && script[next_step].frame <= n) {
+      if (!render_step(s, &script[next_step])) {
+        g_set_error(&err, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+                    "render script step %d (frame %" G_GUINT64_FORMAT ") failed",
+                    next_step, script[next_step].frame);
+        break;
+      }
+      next_step++;
+    }
+    if (err) break;
+    GstBuffer *buf = read_next_frame(s);
+    if (!buf) {
+      g_set_error(&err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+                  "failed to read frame from input");
+      break;
+    }
+    g_mutex_lock(&s->lock);
+    GstClockTime pts = s->next_pts;
+    s->next_pts += dur;
+    SplashLatencyProbe probe;
+    gboolean stamp = s->latency_sei;
+    if (stamp) next_probe_locked(s, pts, &probe);
+    g_mutex_unlock(&s->lock);
+    if (stamp) {
+      // Sent at its capture timestamp, so replays measure the network alone
+      probe.send_us = ts0 + (gint64)(pts / GST_USECOND);
+      buf = splash_sei_insert_probe(buf, &probe);
+    }
+
+    GstMapInfo map;
+    if (gst_buffer_map(buf, &map, GST_MAP_READ)) {
+      if (rtp) {
+        sink.ts_us = ts0 + (gint64)(pts / GST_USECOND);
+        if (!splash_rtp_packetize(rtp, map.data, map.size, pts, render_packet, &sink, NULL)) {
+          g_set_error(&err, G_FILE_ERROR, G_FILE_ERROR_IO, "writing '%s' failed", path);
+        }
+      } else if (fwrite(map.data, 1, map.size, f) != map.size) {
+        int e = errno;
+        g_set_error(&err, G_FILE_ERROR, g_file_error_from_errno(e),
+                    "writing '%s' failed: %s", path, g_strerror(e));
+      }
+      st.bytes += map.size;
+      gst_buffer_unmap(buf, &map);
+    }
+    gst_buffer_unref(buf);
+    st.frames++;
+  }
+
+  if (sink.pcap) splash_pcap_close(sink.pcap, err ? NULL : &err);
+  if (f && fclose(f) != 0 && !err) {
+    int e = errno;
+    g_set_error(&err, G_FILE_ERROR, g_file_error_from_errno(e),
+                "writing '%s' failed: %s", path, g_strerror(e));
+  }
+  st.elapsed_us = g_get_monotonic_time() - t0;
+  st.rtp_packets = sink.packets;
+  st.repair_packets = sink.repair_packets;
+  st.frames_per_sec = st.elapsed_us > 0 ? st.frames * (double)G_USEC_PER_SEC / st.elapsed_us : 0.0;
+  splash_rtp_free(rtp);
+  splash_fec_enc_unref(fec);
+  g_free(host);
+
+  g_mutex_lock(&s->lock);
+  s->rendering = FALSE;
+  g_mutex_unlock(&s->lock);
+  if (out) *out = st;
+  if (err) {
+    emit_evt(s, SPLASH_EVT_ERROR, 0, 0, err->message);
+    g_error_free(err);
+    return false;
+  }
+  return true;
+}
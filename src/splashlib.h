@@ -23,6 +23,8 @@ typedef enum {
   SPLASH_OUTPUT_NONE   = 0,
   SPLASH_OUTPUT_UDP    = 1 << 0,
   SPLASH_OUTPUT_APPSRC = 1 << 1,
+  SPLASH_OUTPUT_PULL   = 1 << 2,  // no sender/feeder: frames are taken with splash_pull_frame()
+                                  // (exclusive; requires the frame index)
 } SplashOutputMode;
 
 // UDP endpoint
@@ -31,42 +33,291 @@ typedef struct {
   int port;          // e.g., 5600
 } SplashEndpoint;
 
+// Frame index handling for the input stream
+typedef enum {
+  SPLASH_INDEX_AUTO = 0,  // load "<input>.idx" sidecar, (re)write it when missing or stale
+  SPLASH_INDEX_MEMORY,    // scan the input at startup, never touch the sidecar
+  SPLASH_INDEX_OFF,       // legacy filesrc ! h265parse reader with segment seeks
+} SplashIndexMode;
+
+// What an output does when its consumer cannot keep up
+typedef enum {
+  SPLASH_BACKPRESSURE_BLOCK = 0,    // wait for room (a full queue stalls the frame source)
+  SPLASH_BACKPRESSURE_LEAK_OLDEST,  // drop queued frames to make room for new ones
+  SPLASH_BACKPRESSURE_LEAK_NEWEST,  // drop incoming frames while the queue is full
+} SplashBackpressure;
+
+typedef struct {
+  SplashBackpressure policy;
+  guint64 max_bytes;        // queued bytes before the policy applies (0 = appsrc default)
+  guint64 max_time_ms;      // queued media time before the policy applies (0 = unlimited)
+  guint   queue_frames;     // frames buffered ahead of the output's delivery thread (0 = 8)
+  guint64 max_bitrate;      // token-bucket cap in bits/s of media time (0 = uncapped)
+  guint64 burst_bytes;      // bucket depth (0 = 250 ms at max_bitrate)
+  guint   max_fps;          // frame-rate cap, frames chosen by timestamp (0 = every frame)
+} SplashOutputPolicy;
+
+// RTP aggregation packets (RFC 7798 4.4.2) of the UDP sender's rtph265pay
+typedef enum {
+  SPLASH_AGGREGATE_ZERO_LATENCY = 0, // bundle NALs up to each VCL NAL (e.g. VPS+SPS+PPS)
+  SPLASH_AGGREGATE_NONE,             // one NAL (or fragment) per packet
+  SPLASH_AGGREGATE_MAX,              // bundle as much as fits within an access unit
+} SplashAggregateMode;
+
+// Forward error correction on the UDP output (splashfec)
+typedef enum {
+  SPLASH_FEC_OFF = 0,
+  SPLASH_FEC_XOR,    // one parity packet per block
+  SPLASH_FEC_RS,     // Reed-Solomon: n - k repair packets per block of k
+} SplashFecScheme;
+
+// SplashConfig.mtu: size the RTP packets from the path MTU towards the host
+#define SPLASH_MTU_AUTO (-1)
+
+// Timeline of the outputs across splash_stop()/splash_start() and
+// splash_apply_config()
+typedef enum {
+  SPLASH_TIMELINE_RESET = 0,  // every start begins at PTS 0 with a fresh RTP SSRC/seqnum/timestamp base
+  SPLASH_TIMELINE_PERSISTENT, // PTS and RTP timestamps follow CLOCK_MONOTONIC from the first
+                              // start; SSRC and sequence numbers carry over
+} SplashTimelineMode;
+
+// Scheduling of a library thread (Linux). A zeroed value leaves the thread alone.
+typedef enum {
+  SPLASH_SCHED_OTHER = 0,   // inherit the default time-sharing policy
+  SPLASH_SCHED_FIFO,
+  SPLASH_SCHED_RR,
+} SplashSchedPolicy;
+
+typedef struct {
+  SplashSchedPolicy policy;
+  int     priority;         // 1..99 for FIFO/RR (0 = lowest)
+  guint64 cpus;             // affinity mask, bit n = CPU n (0 = any CPU)
+} SplashThreadSched;
+
 // Configuration
 typedef struct {
-  const char *input_path;   // Annex-B H.265 elementary stream (AUD+VUI recommended)
+  const char *input_path;   // Annex-B H.265 elementary stream (AUD+VUI recommended);
+                            // gzip/zip/zstd compressed streams are inflated into memory
+                            // once at startup (requires index_mode != SPLASH_INDEX_OFF)
   double fps;               // e.g., 30.0
   SplashOutputMode outputs; // Bitmask of SPLASH_OUTPUT_* values (defaults to UDP)
   SplashEndpoint endpoint;  // UDP host+port
+  int mtu;                  // RTP packet size in bytes, RTP header included (0 = 1200,
+                            // SPLASH_MTU_AUTO = path MTU minus IP/UDP headers)
+  int payload_type;         // RTP payload type, 96..127 (0 = 97)
+  SplashAggregateMode aggregate; // defaults to SPLASH_AGGREGATE_ZERO_LATENCY
+  SplashIndexMode index_mode; // defaults to SPLASH_INDEX_AUTO
+  const char *index_path;   // optional sidecar path (NULL -> "<input_path>.idx")
+  guint64 cache_bytes;      // >0: read frames through a bounded LRU cache instead of mapping the input
+  int cache_pin_frames;     // frames pinned at the start and end of every sequence (cache mode)
+  int decompress_threads;   // compressed inputs: worker threads (0 = one per CPU)
+  int index_threads;        // start-code scan when building the index (0 = one per CPU)
+  int ps_interval_ms;       // frame index: resend VPS/SPS/PPS on IRAPs at most this
+                            // often (0 = every IRAP, <0 = only on start/switch/join)
+  SplashOutputPolicy udp_policy;    // backpressure of the UDP sender's appsrc
+  SplashOutputPolicy appsrc_policy; // backpressure of the splash_get_appsrc() element
+  SplashTimelineMode timeline;      // defaults to SPLASH_TIMELINE_RESET
+  SplashThreadSched media_sched;    // the library's media thread (bus watches, boundaries)
+  SplashThreadSched stream_sched;   // streaming threads: GStreamer tasks of the library's
+                                    // pipelines, the native reader and output workers
+  int watchdog_ms;          // >0: rebuild a pipeline that pushed no frame for this long
+                            // (or posted an error), keeping the timeline (0 = off)
+  bool latency_sei;         // add a latency-probe SEI (send time, frame counter) to
+                            // every frame, for splash_rx
+  int rtx_history;          // >0: keep this many sent RTP packets and retransmit them
+                            // (RFC 4588) on RTCP generic NACKs (0 = off)
+  int rtx_payload_type;     // payload type of the retransmissions (0 = payload_type + 1)
+  int rtcp_port;            // local port the UDP sender sends from and takes RTCP
+                            // feedback on (0 = any; receivers reply to the source port)
+  SplashFecScheme fec;      // repair packets after every frame (defaults to SPLASH_FEC_OFF)
+  int fec_k;                // source packets per FEC block (0 = 10)
+  int fec_n;                // RS: source + repair packets per block (0 = fec_k + 2)
+  int fec_payload_type;     // payload type of the repair packets (0 = payload_type + 2);
+                            // media, RTX and FEC types must differ
 } SplashConfig;
 
+// Per-output delivery counters
+typedef struct {
+  guint64 frames_pushed;
+  guint64 frames_dropped;     // discarded by a leak policy
+  gint64  stall_us;           // total time the delivery thread waited for room (block)
+  gint64  stall_max_us;       // longest single wait
+  guint   queue_depth;        // frames waiting for the delivery thread
+  gint64  lag_us;             // newest queued frame minus newest delivered frame
+  gint64  lag_max_us;         // worst lag seen at delivery
+  guint64 frames_held;        // skipped after a reference frame was skipped, until an IRAP
+  guint64 frames_shed;        // non-reference frames skipped by the bitrate cap
+  guint64 frames_decimated;   // skipped by the frame-rate cap
+  guint64 bytes_pushed;
+  guint64 bitrate_bps;        // achieved, over the last second of media time
+  gint64  first_push_us;      // monotonic time of the first push since start (0 = none)
+  gint64  last_push_us;       // ... and of the newest one
+  bool    failing;            // the appsrc rejected the last push
+} SplashOutputCounters;
+
+// RTP retransmission counters (rtx_history > 0)
+typedef struct {
+  guint64 nacks;              // generic NACK entries received
+  guint64 requested;          // packets they asked for
+  guint64 sent;               // retransmissions sent
+  guint64 missed;             // asked for but no longer in the history
+  gint64  repair_us;          // mean time from a packet's first send to its retransmission
+  gint64  repair_max_us;
+} SplashRtxStats;
+
+// FEC encoder counters (fec != SPLASH_FEC_OFF)
+typedef struct {
+  guint64 blocks;
+  guint64 source_packets;
+  guint64 source_bytes;       // RTP payload bytes protected
+  guint64 repair_packets;
+  guint64 repair_bytes;       // RTP payload bytes of the repair packets
+  gint64  encode_us;          // time spent encoding
+} SplashFecStats;
+
+// Runtime statistics snapshot
+typedef struct {
+  guint64 frames_pushed;      // access units handed to the outputs since splash_start()
+  guint64 bytes_pushed;       // their payload bytes (parameter sets included)
+  gint64  cpu_us;             // process CPU time since splash_start(), all threads
+  int     index_frames;       // AUs in the frame index (0 when the legacy reader is used)
+  bool    index_from_sidecar; // index was mapped from a valid sidecar instead of scanned
+  bool    index_saved;        // a fresh sidecar was written during the last apply_config
+  gint64  index_time_us;      // time spent mapping the input and loading/building the index
+  gint64  decompress_us;      // time spent inflating a compressed input (0 for plain inputs)
+  guint   decompress_threads; // workers used for decompression
+  guint   index_threads;      // workers used for the start-code scan (0 = index not built)
+  gint64  first_packet_us;    // splash_start() -> first frame pushed (-1 until it happens)
+  guint   rtp_mtu;            // RTP packet size in use (0 without the UDP output)
+  guint64 rtp_packets;        // media RTP packets sent since splash_start(), FEC repair
+                              // packets and retransmissions not included
+  gint64  resume_latency_us;  // last splash_resume() -> first frame pushed (-1 if none yet)
+  gint64  resume_latency_max_us;
+  // Scheduled switches (splash_schedule_at)
+  guint   sched_pending;
+  guint64 sched_switches;
+  gint64  sched_error_us;     // last switch: presentation time of its first frame minus due time
+  gint64  sched_error_max_us; // largest |error|
+  // Frame cache (all zero unless cache_bytes > 0)
+  guint64 cache_hits;
+  guint64 cache_misses;
+  guint64 cache_evictions;
+  guint64 cache_bytes_used;   // pinned bytes included
+  guint64 cache_bytes_pinned;
+  guint   cache_frames_pinned;
+  // Out-of-band parameter sets (native reader only)
+  guint   ps_groups;          // distinct VPS/SPS/PPS configurations in the input
+  guint64 ps_bytes_stripped;  // in-band parameter-set bytes removed from frames
+  guint64 ps_bytes_injected;  // cached parameter-set bytes inserted into frames
+  guint64 ps_injections;
+  SplashOutputCounters udp;
+  SplashOutputCounters appsrc;
+  // Thread scheduling (media_sched / stream_sched)
+  guint   sched_threads;      // threads a non-default policy or affinity was applied to
+  guint   sched_failures;     // ... and those where it was refused
+  guint   events_dropped;     // events lost to a full event queue (slow callback)
+  gint64  gst_init_us;        // time spent initialising GStreamer (process-wide, once)
+  // Watchdog (watchdog_ms > 0)
+  guint   watchdog_stalls;    // stalls and pipeline errors detected
+  guint   watchdog_recoveries;// pipelines rebuilt and delivering again
+  gint64  recovery_us;        // last recovery: detection -> first frame pushed
+  gint64  recovery_max_us;
+  SplashRtxStats rtx;         // since splash_start()
+  SplashFecStats fec;         // since splash_start()
+} SplashStats;
+
 // Event callback (optional)
 typedef enum {
   SPLASH_EVT_STARTED,
   SPLASH_EVT_STOPPED,
   SPLASH_EVT_SWITCHED_AT_BOUNDARY,  // payload: from_idx -> to_idx
-  SPLASH_EVT_QUEUED_NEXT,           // payload: to_idx
+  SPLASH_EVT_QUEUED_NEXT,           // payload: a = first queued idx, b = number queued
   SPLASH_EVT_CLEARED_QUEUE,
-  SPLASH_EVT_ERROR                  // payload: const char* message
+  SPLASH_EVT_ERROR,                 // payload: const char* message
+  SPLASH_EVT_FIRST_PACKET,          // payload: a = microseconds since splash_start()
+  SPLASH_EVT_PAUSED,
+  SPLASH_EVT_RESUMED,               // payload: a = 1 if the active sequence was restarted
+  SPLASH_EVT_SCHEDULED_SWITCH,      // payload: from_idx -> to_idx (splash_schedule_at)
+  SPLASH_EVT_STALLED,               // payload: a = SplashStallSource
+  SPLASH_EVT_RECOVERED,             // payload: a = SplashStallSource, b = recovery time in ms
 } SplashEventType;
 
+// What the watchdog found stalled. The UDP sender and the legacy reader
+// pipeline are rebuilt; the appsrc output belongs to the application and the
+// native reader has no pipeline, so their stalls are only reported.
+typedef enum {
+  SPLASH_STALL_READER = 0,  // no frames from the reader (legacy pipeline or native reader)
+  SPLASH_STALL_UDP,         // UDP sender
+  SPLASH_STALL_APPSRC,      // splash_get_appsrc() consumer
+} SplashStallSource;
+
+// Callbacks run on the library's event dispatcher thread, never under its
+// locks and never on the media or streaming threads, so they may call back
+// into the API. msg is only valid during the call (truncated to 127 bytes).
 typedef void (*SplashEventCb)(SplashEventType type, int a, int b, const char *msg, void *user);
 
+// GStreamer initialisation, once per process. FAST skips the plugin registry
+// rescan and the scanner helper fork that gst_init() does when the registry
+// cache looks stale; plugins are found through the existing cache (or are
+// linked in: make GST_STATIC=1). Use it where the installed plugins do not
+// change behind the application's back.
+typedef enum {
+  SPLASH_INIT_DEFAULT = 0,   // plain gst_init()
+  SPLASH_INIT_FAST,
+} SplashInitMode;
+
 // ---- Lifecycle ----
+// Optional, before the first splash_new() (which otherwise initialises in
+// DEFAULT mode). Later calls, or GStreamer already initialised by the
+// application, keep the existing state. Returns false if GStreamer failed.
+bool    splash_init(SplashInitMode mode);
+// NULL if GStreamer cannot be initialised.
 Splash* splash_new(void);
 void    splash_free(Splash *s);
 
 // Configure named sequences (can be called any time; thread-safe)
 bool splash_set_sequences(Splash *s, const SplashSeq *seqs, int n_seqs);
 
-// Full (re)configuration of pipelines (safe to call while running)
+// Checks a configuration the way splash_apply_config() does, without
+// touching any handle
+bool splash_check_config(const SplashConfig *cfg);
+
+// Full (re)configuration of pipelines (safe to call while running). An
+// invalid cfg is rejected with nothing changed; when the pipelines cannot
+// be built the handle is left stopped.
 bool splash_apply_config(Splash *s, const SplashConfig *cfg);
 
 // Start/Run/Stop
 bool splash_start(Splash *s);
+// Bus watches and segment boundaries are handled on the library's own media
+// thread (with its own GMainContext).
 void splash_run(Splash *s);    // blocks: runs internal GMainLoop
 void splash_quit(Splash *s);   // quits the loop (non-blocking)
 void splash_stop(Splash *s);   // stops pipelines
 
+// Warm standby: splash_pause() stops sending but keeps the pipelines, index,
+// cache and position; splash_resume() is back on air with the next frame.
+// restart_sequence restarts the active sequence instead of continuing from
+// the frame where playout paused. Both return false when not applicable
+// (not started, already paused/running, or SPLASH_OUTPUT_PULL).
+bool splash_pause(Splash *s);
+bool splash_resume(Splash *s, bool restart_sequence);
+
+// ---- Scheduled playout ----
+typedef enum {
+  SPLASH_CLOCK_MONOTONIC = 0, // g_get_monotonic_time() / CLOCK_MONOTONIC, in ns
+  SPLASH_CLOCK_REALTIME,      // Unix time in ns
+} SplashClockId;
+
+// Cuts to sequence idx (from its first frame) at the frame boundary nearest to
+// when_ns, independent of the enqueue/boundary model; the queue is kept.
+// Past times switch on the next frame. Many schedules may be pending. Returns
+// a schedule id (0 if idx is invalid). Achieved errors are in SplashStats.
+guint splash_schedule_at(Splash *s, int idx, gint64 when_ns, SplashClockId clock);
+bool  splash_schedule_cancel(Splash *s, guint id);
+void  splash_schedule_clear(Splash *s);
+
 // ---- Control / Queue API ----
 // Multi-queue model: current loops forever; queued entries take over at segment boundaries.
 // Returns false if any index/name is invalid or the queue would overflow.
@@ -105,9 +356,75 @@ int  splash_find_index_by_name(Splash *s, const char *name);
 // Logging / events
 void splash_set_event_cb(Splash *s, SplashEventCb cb, void *user);
 
+// Copies the current counters into *out.
+void splash_get_stats(Splash *s, SplashStats *out);
+
+// Playout state, cheap enough to poll (one lock, no counter collection)
+typedef struct {
+  bool    running;            // between splash_start() and splash_stop()
+  bool    paused;
+  int     active_idx;         // -1 if none
+  int     pending_idx;        // next queued index, -1 if none
+  int     queue_depth;        // queued entries
+  gint64  running_us;         // time since splash_start() (0 when stopped)
+  guint64 frames_pushed;
+} SplashStatus;
+
+void splash_get_status(Splash *s, SplashStatus *out);
+
 // Accessors for optional outputs
 GstElement* splash_get_appsrc(Splash *s); // returns new ref or NULL when disabled
 
+// SPLASH_OUTPUT_PULL: runs the loop engine for one frame on the caller's
+// thread and returns the next timestamped access unit, or NULL when not
+// started or the frame could not be read (SPLASH_EVT_ERROR is emitted).
+GstBuffer* splash_pull_frame(Splash *s);
+
+// ---- Offline render ----
+typedef enum {
+  SPLASH_RENDER_ANNEXB = 0,   // the timestamped AUs back to back, as the outputs receive them
+  SPLASH_RENDER_RTP_PCAP,     // RTP packets as the UDP sender would packetize them (mtu,
+                              // payload_type, aggregate, fec repair packets), as IPv4/UDP
+                              // to the configured endpoint
+} SplashRenderFormat;
+
+typedef enum {
+  SPLASH_RENDER_ENQUEUE = 0,  // splash_enqueue_with_repeat(indices, n_indices, repeat)
+  SPLASH_RENDER_CLEAR,        // splash_clear_next()
+} SplashRenderOp;
+
+// One entry of a render script, applied just before output frame `frame`
+// (0 = the first) is read. Scripts must be ordered by frame.
+typedef struct {
+  guint64 frame;
+  SplashRenderOp op;
+  const int *indices;
+  int n_indices;
+  SplashRepeatMode repeat;
+} SplashRenderStep;
+
+typedef struct {
+  guint64 frames;
+  guint64 bytes;              // access unit bytes, parameter sets included
+  guint64 rtp_packets;        // SPLASH_RENDER_RTP_PCAP only: media packets, as in
+                              // SplashStats.rtp_packets
+  guint64 repair_packets;     // SPLASH_RENDER_RTP_PCAP with fec: FEC repair packets
+  gint64  elapsed_us;
+  double  frames_per_sec;     // rendering throughput
+} SplashRenderStats;
+
+// Runs the loop engine unpaced for n_frames from the active sequence (and
+// queue) on the caller's thread, applying script as it goes, and writes the
+// result to path. Boundaries, queue/repeat handling and parameter-set
+// placement are those of a live run; scheduled switches are not applied.
+// Needs the frame index and a stopped handle (splash_start() and
+// splash_apply_config() fail while rendering). Leaves the active sequence
+// and queue where the script ended. Returns false on errors (SPLASH_EVT_ERROR
+// carries the reason); *out (optional) is filled either way.
+bool splash_render(Splash *s, const SplashRenderStep *script, int n_steps,
+                   guint64 n_frames, const char *path, SplashRenderFormat format,
+                   SplashRenderStats *out);
+
 #ifdef __cplusplus
 }
 #endif
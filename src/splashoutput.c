@@ -0,0 +1,404 @@
+#include "splashoutput.h"
+#include <gst/app/gstappsrc.h>
+#include <string.h>
+
+#define DEFAULT_QUEUE_FRAMES 8
+#define ROOM_POLL_US         2000
+#define DEFAULT_BURST_MS     250
+
+struct SplashOutput {
+  gchar *name;
+  GstElement *appsrc;
+  SplashOutputPolicy policy;
+  gboolean native_leak;       // appsrc has leaky-type (GStreamer >= 1.20)
+  gboolean has_level_time;
+
+  GMutex lock;
+  GCond cond;                 // queue changed / flushing changed / stop
+  GQueue queue;               // GstBuffer*, oldest at the head
+  guint cap;
+  gboolean flushing;
+  gboolean stop;
+  GstFlowReturn last_flow;    // sticky push error
+  GstClockTime queued_pts;    // newest frame handed to enqueue
+  GstClockTime delivered_pts; // newest frame pushed to the appsrc
+  SplashOutputCounters ctr;
+  guint64 appsrc_dropped_base; // the appsrc's own "dropped" at the last reset
+
+  // Bitrate cap (policy.max_bitrate > 0), refilled over media time
+  gint64 tokens;              // bytes; negative after an oversized frame went out
+  GstClockTime bucket_pts;    // PTS the bucket was refilled up to
+  gboolean holding;           // a reference frame was skipped: wait for an IRAP
+  gboolean ps_owed;           // skipped parameter sets: the IRAP ending the hold needs them
+  // Frame-rate cap (policy.max_fps > 0)
+  GstClockTime next_slot;     // PTS from which the next frame is due
+  // Achieved bitrate
+  GstClockTime win_pts;       // start of the current one-second window
+  guint64 win_bytes;
+
+  SplashOutputThreadInit thread_init;
+  gpointer thread_init_user;
+  GThread *thread;
+};
+
+static gboolean has_property(GstElement *el, const char *name){
+  return g_object_class_find_property(G_OBJECT_GET_CLASS(el), name) != NULL;
+}
+
+// The worker never blocks inside appsrc (block=false), so it stays
+// interruptible; BLOCK is implemented by waiting for room in wait_for_room().
+static void configure_appsrc(SplashOutput *o){
+  const SplashOutputPolicy *p = &o->policy;
+  g_object_set(G_OBJECT(o->appsrc), "block", FALSE, NULL);
+  if (p->max_bytes > 0) g_object_set(G_OBJECT(o->appsrc), "max-bytes", p->max_bytes, NULL);
+  if (p->max_time_ms > 0 && has_property(o->appsrc, "max-time")) {
+    g_object_set(G_OBJECT(o->appsrc), "max-time",
+                 (guint64)(p->max_time_ms * GST_MSECOND), NULL);
+  }
+  if (p->policy != SPLASH_BACKPRESSURE_BLOCK && o->native_leak) {
+    gst_util_set_object_arg(G_OBJECT(o->appsrc), "leaky-type",
+                            p->policy == SPLASH_BACKPRESSURE_LEAK_OLDEST ? "downstream"
+                                                                        : "upstream");
+  }
+}
+
+// Frames the appsrc leaked on its own (leaky-type), since it was created.
+static guint64 appsrc_dropped(SplashOutput *o){
+  guint64 dropped = 0;
+  if (o->native_leak && has_property(o->appsrc, "dropped")) {
+    g_object_get(G_OBJECT(o->appsrc), "dropped", &dropped, NULL);
+  }
+  return dropped;
+}
+
+static gboolean appsrc_full(SplashOutput *o){
+  GstAppSrc *src = GST_APP_SRC(o->appsrc);
+  guint64 max = gst_app_src_get_max_bytes(src);
+  if (max > 0 && gst_app_src_get_current_level_bytes(src) >= max) return TRUE;
+  if (o->policy.max_time_ms > 0 && o->has_level_time) {
+    guint64 level = 0;
+    g_object_get(G_OBJECT(o->appsrc), "current-level-time", &level, NULL);
+    if (level >= o->policy.max_time_ms * GST_MSECOND) return TRUE;
+  }
+  return FALSE;
+}
+
+// Waits until the appsrc has room. Returns FALSE when stopping or flushing.
+// Caller holds o->lock.
+static gboolean wait_for_room_locked(SplashOutput *o){
+  while (!o->stop && !o->flushing && appsrc_full(o)) {
+    gint64 end = g_get_monotonic_time() + ROOM_POLL_US;
+    g_cond_wait_until(&o->cond, &o->lock, end);
+  }
+  return !o->stop && !o->flushing;
+}
+
+// Achieved bitrate over one-second windows of media time. Caller holds o->lock.
+static void count_bitrate_locked(SplashOutput *o, GstClockTime pts, gsize size){
+  if (!GST_CLOCK_TIME_IS_VALID(pts)) return;
+  if (!GST_CLOCK_TIME_IS_VALID(o->win_pts) || pts < o->win_pts) {
+    o->win_pts = pts;
+    o->win_bytes = 0;
+  } else if (pts - o->win_pts >= GST_SECOND) {
+    o->ctr.bitrate_bps = gst_util_uint64_scale(o->win_bytes * 8, GST_SECOND, pts - o->win_pts);
+    o->win_pts = pts;
+    o->win_bytes = 0;
+  }
+  o->win_bytes += size;
+}
+
+// Frame-rate cap: a frame is due once its PTS reaches the next 1/max_fps slot,
+// half a frame early included, so 30 -> 10 fps keeps every third frame
+// without drifting. Frames that are not due are skipped like the bitrate
+// cap's: non-reference frames on their own, anything else (including a frame
+// carrying parameter sets) puts the output on hold until the next IRAP.
+// Caller holds o->lock.
+static gboolean fps_due_locked(SplashOutput *o, GstBuffer *buf){
+  if (o->policy.max_fps == 0) return TRUE;
+  GstClockTime pts = GST_BUFFER_PTS(buf);
+  if (!GST_CLOCK_TIME_IS_VALID(pts) || !GST_CLOCK_TIME_IS_VALID(o->next_slot)) return TRUE;
+  GstClockTime period = GST_SECOND / o->policy.max_fps;
+  GstClockTime dur = GST_BUFFER_DURATION(buf);
+  GstClockTime slack = GST_CLOCK_TIME_IS_VALID(dur) ? dur / 2 : 0;
+  // Later than the slot, or so far before it that the timeline went back
+  if (pts + slack >= o->next_slot || pts + slack + period < o->next_slot) return TRUE;
+  if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_HEADER)) o->ps_owed = TRUE;
+  if (!GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DROPPABLE) || o->ps_owed) o->holding = TRUE;
+  o->ctr.frames_decimated++;
+  return FALSE;
+}
+
+// Moves the slot on past an admitted frame and stretches its duration to the
+// capped rate, so downstream sees the lower frame rate while the PTS stays
+// exact. Caller holds o->lock.
+static GstBuffer* fps_admitted_locked(SplashOutput *o, GstBuffer *buf){
+  if (o->policy.max_fps == 0) return buf;
+  GstClockTime pts = GST_BUFFER_PTS(buf);
+  if (!GST_CLOCK_TIME_IS_VALID(pts)) return buf;
+  GstClockTime period = GST_SECOND / o->policy.max_fps;
+  if (!GST_CLOCK_TIME_IS_VALID(o->next_slot) || pts >= o->next_slot + period ||
+      pts + period < o->next_slot) {
+    o->next_slot = pts + period;
+  } else {
+    o->next_slot += period;
+  }
+  GstClockTime dur = GST_BUFFER_DURATION(buf);
+  if (GST_CLOCK_TIME_IS_VALID(dur) && dur >= period) return buf;
+  // Shared with the other outputs: only the metadata is copied
+  buf = gst_buffer_make_writable(buf);
+  GST_BUFFER_DURATION(buf) = period;
+  return buf;
+}
+
+// Hold after either cap skipped a reference frame: its dependants would
+// decode corrupted, so everything up to the next IRAP is skipped as well;
+// receivers repeat the last picture meanwhile. When the skipped frames
+// carried parameter sets, only an IRAP carrying them again ends the hold.
+// Caller holds o->lock.
+static gboolean hold_admit_locked(SplashOutput *o, GstBuffer *buf){
+  if (!o->holding) return TRUE;
+  if (!GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT) &&
+      (!o->ps_owed || GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_HEADER))) {
+    o->holding = FALSE;
+    return TRUE;
+  }
+  o->ctr.frames_held++;
+  return FALSE;
+}
+
+// Token bucket in front of the queue: refilled at max_bitrate over media time
+// and at most burst bytes deep, so sent frames keep their timestamps instead
+// of going out late. A frame goes out while the bucket holds its size (or is
+// full, for frames larger than the bucket), IRAPs included. Otherwise a
+// non-reference frame is simply skipped, and a reference frame (or one
+// carrying parameter sets) puts the output on hold until an IRAP that fits.
+// Caller holds o->lock.
+static gboolean rate_admit_locked(SplashOutput *o, GstBuffer *buf){
+  const SplashOutputPolicy *p = &o->policy;
+  if (p->max_bitrate == 0) return TRUE;
+  gint64 burst = p->burst_bytes > 0
+                   ? (gint64)p->burst_bytes
+                   : (gint64)(p->max_bitrate / 8 * DEFAULT_BURST_MS / 1000);
+  GstClockTime pts = GST_BUFFER_PTS(buf);
+  if (!GST_CLOCK_TIME_IS_VALID(o->bucket_pts) || !GST_CLOCK_TIME_IS_VALID(pts)) {
+    o->tokens = burst;
+  } else if (pts > o->bucket_pts) {
+    guint64 add = gst_util_uint64_scale(pts - o->bucket_pts, p->max_bitrate, 8 * GST_SECOND);
+    o->tokens = MIN(burst, o->tokens + (gint64)MIN(add, (guint64)burst));
+  }
+  if (GST_CLOCK_TIME_IS_VALID(pts)) o->bucket_pts = pts;
+
+  gint64 size = (gint64)gst_buffer_get_size(buf);
+  if (o->tokens >= MIN(size, burst)) {
+    o->tokens -= size;
+    return TRUE;
+  }
+  if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_HEADER)) o->ps_owed = TRUE;
+  if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DROPPABLE) && !o->ps_owed) {
+    o->ctr.frames_shed++;
+  } else {
+    o->holding = TRUE;
+    o->ctr.frames_held++;
+  }
+  return FALSE;
+}
+
+static gpointer output_main(gpointer data){
+  SplashOutput *o = (SplashOutput*)data;
+  if (o->thread_init) o->thread_init(o->thread_init_user);
+  g_mutex_lock(&o->lock);
+  for (;;) {
+    while (!o->stop && (o->flushing || g_queue_is_empty(&o->queue))) {
+      g_cond_wait(&o->cond, &o->lock);
+    }
+    if (o->stop) break;
+
+    GstBuffer *buf = NULL;
+    gboolean drop = FALSE;
+    if (o->policy.policy == SPLASH_BACKPRESSURE_BLOCK) {
+      gint64 t0 = g_get_monotonic_time();
+      if (!wait_for_room_locked(o)) continue;
+      gint64 waited = g_get_monotonic_time() - t0;
+      o->ctr.stall_us += waited;
+      if (waited > o->ctr.stall_max_us) o->ctr.stall_max_us = waited;
+      buf = g_queue_pop_head(&o->queue);
+    } else {
+      buf = g_queue_pop_head(&o->queue);
+      // appsrc without leaky-type: drop incoming frames at the limit
+      drop = !o->native_leak && appsrc_full(o);
+    }
+    g_cond_broadcast(&o->cond); // room in our queue for a blocked producer
+    GstClockTime pts = GST_BUFFER_PTS(buf);
+    gsize size = gst_buffer_get_size(buf);
+    if (drop) {
+      o->ctr.frames_dropped++;
+      gst_buffer_unref(buf);
+      continue;
+    }
+    g_mutex_unlock(&o->lock);
+
+    GstFlowReturn fr = gst_app_src_push_buffer(GST_APP_SRC(o->appsrc), buf);
+
+    g_mutex_lock(&o->lock);
+    if (fr == GST_FLOW_OK) {
+      gint64 now = g_get_monotonic_time();
+      if (!o->ctr.first_push_us) o->ctr.first_push_us = now;
+      o->ctr.last_push_us = now;
+      o->ctr.frames_pushed++;
+      o->ctr.bytes_pushed += size;
+      count_bitrate_locked(o, pts, size);
+      o->delivered_pts = pts;
+      if (GST_CLOCK_TIME_IS_VALID(o->queued_pts) && o->queued_pts >= pts) {
+        gint64 lag = (gint64)((o->queued_pts - pts) / GST_USECOND);
+        if (lag > o->ctr.lag_max_us) o->ctr.lag_max_us = lag;
+      }
+    } else if (fr != GST_FLOW_FLUSHING) {
+      o->last_flow = fr;
+    }
+  }
+  g_mutex_unlock(&o->lock);
+  return NULL;
+}
+
+SplashOutput* splash_output_new(const char *name, GstElement *appsrc,
+                                const SplashOutputPolicy *policy,
+                                SplashOutputThreadInit thread_init, gpointer user){
+  if (!appsrc || !policy) return NULL;
+  SplashOutput *o = g_new0(SplashOutput, 1);
+  o->name = g_strdup(name);
+  o->appsrc = gst_object_ref(appsrc);
+  o->policy = *policy;
+  o->native_leak = has_property(appsrc, "leaky-type");
+  o->has_level_time = has_property(appsrc, "current-level-time");
+  o->cap = policy->queue_frames > 0 ? policy->queue_frames : DEFAULT_QUEUE_FRAMES;
+  o->last_flow = GST_FLOW_OK;
+  o->queued_pts = GST_CLOCK_TIME_NONE;
+  o->delivered_pts = GST_CLOCK_TIME_NONE;
+  o->bucket_pts = GST_CLOCK_TIME_NONE;
+  o->next_slot = GST_CLOCK_TIME_NONE;
+  o->win_pts = GST_CLOCK_TIME_NONE;
+  o->thread_init = thread_init;
+  o->thread_init_user = user;
+  g_mutex_init(&o->lock);
+  g_cond_init(&o->cond);
+  g_queue_init(&o->queue);
+  configure_appsrc(o);
+  gchar *tname = g_strdup_printf("splash-out-%s", name);
+  o->thread = g_thread_new(tname, output_main, o);
+  g_free(tname);
+  return o;
+}
+
+static void drain_locked(SplashOutput *o){
+  GstBuffer *buf;
+  while ((buf = g_queue_pop_head(&o->queue)) != NULL) gst_buffer_unref(buf);
+}
+
+void splash_output_free(SplashOutput *o){
+  if (!o) return;
+  g_mutex_lock(&o->lock);
+  o->stop = TRUE;
+  g_cond_broadcast(&o->cond);
+  g_mutex_unlock(&o->lock);
+  g_thread_join(o->thread);
+  drain_locked(o);
+  gst_object_unref(o->appsrc);
+  g_cond_clear(&o->cond);
+  g_mutex_clear(&o->lock);
+  g_free(o->name);
+  g_free(o);
+}
+
+GstFlowReturn splash_output_enqueue(SplashOutput *o, GstBuffer *buf){
+  GstClockTime pts = GST_BUFFER_PTS(buf);
+  g_mutex_lock(&o->lock);
+  GstFlowReturn fr = o->last_flow;
+  if (o->flushing || o->stop) {
+    fr = GST_FLOW_FLUSHING;
+    gst_buffer_unref(buf);
+    buf = NULL;
+  } else if (!fps_due_locked(o, buf) || !hold_admit_locked(o, buf) ||
+             !rate_admit_locked(o, buf)) {
+    gst_buffer_unref(buf);
+    buf = NULL;
+  } else {
+    if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_HEADER)) o->ps_owed = FALSE;
+    buf = fps_admitted_locked(o, buf);
+  }
+  while (buf && g_queue_get_length(&o->queue) >= o->cap) {
+    if (o->policy.policy == SPLASH_BACKPRESSURE_LEAK_NEWEST) {
+      gst_buffer_unref(buf);
+      buf = NULL;
+      o->ctr.frames_dropped++;
+    } else if (o->policy.policy == SPLASH_BACKPRESSURE_LEAK_OLDEST) {
+      gst_buffer_unref(g_queue_pop_head(&o->queue));
+      o->ctr.frames_dropped++;
+    } else {
+      g_cond_wait(&o->cond, &o->lock);
+      if (o->flushing || o->stop) {
+        fr = GST_FLOW_FLUSHING;
+        gst_buffer_unref(buf);
+        buf = NULL;
+      }
+    }
+  }
+  if (buf) {
+    g_queue_push_tail(&o->queue, buf);
+    o->queued_pts = pts;
+    g_cond_broadcast(&o->cond);
+  }
+  g_mutex_unlock(&o->lock);
+  return fr;
+}
+
+void splash_output_set_flushing(SplashOutput *o, gboolean flushing){
+  if (!o) return;
+  g_mutex_lock(&o->lock);
+  o->flushing = flushing;
+  if (flushing) drain_locked(o);
+  else o->last_flow = GST_FLOW_OK;
+  g_cond_broadcast(&o->cond);
+  g_mutex_unlock(&o->lock);
+}
+
+void splash_output_get_counters(SplashOutput *o, SplashOutputCounters *out){
+  if (!o || !out) return;
+  g_mutex_lock(&o->lock);
+  *out = o->ctr;
+  out->queue_depth = g_queue_get_length(&o->queue);
+  out->failing = o->last_flow != GST_FLOW_OK;
+  if (GST_CLOCK_TIME_IS_VALID(o->queued_pts) && GST_CLOCK_TIME_IS_VALID(o->delivered_pts) &&
+      o->queued_pts >= o->delivered_pts) {
+    out->lag_us = (gint64)((o->queued_pts - o->delivered_pts) / GST_USECOND);
+  }
+  guint64 base = o->appsrc_dropped_base;
+  g_mutex_unlock(&o->lock);
+  // Frames the appsrc leaked on its own since the last reset
+  guint64 dropped = appsrc_dropped(o);
+  if (dropped > base) out->frames_dropped += dropped - base;
+}
+
+void splash_output_reset_counters(SplashOutput *o){
+  if (!o) return;
+  guint64 dropped = appsrc_dropped(o);
+  g_mutex_lock(&o->lock);
+  memset(&o->ctr, 0, sizeof(o->ctr));
+  o->appsrc_dropped_base = dropped;
+  o->queued_pts = GST_CLOCK_TIME_NONE;
+  o->delivered_pts = GST_CLOCK_TIME_NONE;
+  o->bucket_pts = GST_CLOCK_TIME_NONE;
+  o->win_pts = GST_CLOCK_TIME_NONE;
+  o->win_bytes = 0;
+  o->holding = FALSE;
+  o->ps_owed = FALSE;
+  o->next_slot = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock(&o->lock);
+}
+
+gboolean splash_output_ps_owed(SplashOutput *o){
+  if (!o) return FALSE;
+  g_mutex_lock(&o->lock);
+  gboolean owed = o->ps_owed;
+  g_mutex_unlock(&o->lock);
+  return owed;
+}
@@ -0,0 +1,47 @@
+#ifndef SPLASHOUTPUT_H
+#define SPLASHOUTPUT_H
+
+#include <gst/gst.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Delivery worker for one output appsrc. Frames are queued by reference in
+// a small bounded queue and pushed from the worker's own thread, so a slow or
+// stalled consumer only delays itself. What happens when the queue (or the
+// appsrc behind it) is full is decided by the output's SplashOutputPolicy:
+// BLOCK makes the producer wait for room, the LEAK_* policies drop frames.
+
+typedef struct SplashOutput SplashOutput;
+
+// Called first thing on the worker thread (e.g. to set its scheduling).
+typedef void (*SplashOutputThreadInit)(gpointer user);
+
+// Takes a reference on appsrc and starts the worker thread.
+SplashOutput* splash_output_new(const char *name, GstElement *appsrc,
+                                const SplashOutputPolicy *policy,
+                                SplashOutputThreadInit thread_init, gpointer user);
+// Stops and joins the worker, dropping anything still queued.
+void splash_output_free(SplashOutput *o);
+
+// Queues a timestamped frame (takes ownership). Returns GST_FLOW_FLUSHING
+// while flushing, the worker's last push error if it failed, GST_FLOW_OK
+// otherwise (including when the policy dropped a frame).
+GstFlowReturn splash_output_enqueue(SplashOutput *o, GstBuffer *buf);
+
+// While flushing, enqueue returns immediately and queued frames are dropped.
+void splash_output_set_flushing(SplashOutput *o, gboolean flushing);
+
+// Whether a cap skipped parameter sets this output has not received since;
+// the feeder then adds them to the next IRAP.
+gboolean splash_output_ps_owed(SplashOutput *o);
+
+void splash_output_get_counters(SplashOutput *o, SplashOutputCounters *out);
+void splash_output_reset_counters(SplashOutput *o);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,174 @@
+#include "splashps.h"
+#include "splashscan.h"
+#include <string.h>
+
+struct SplashParamSets {
+  const SplashIndex *idx;
+  guint32 *group_of;   // per-frame group index
+  GPtrArray *groups;   // GstMemory*, concatenated VPS+SPS+PPS
+};
+
+static const guint8 start_code[4] = { 0, 0, 0, 1 };
+
+// NAL payload (header onwards) of a parameter-set entry, skipping its start code.
+static const guint8* ps_payload(const SplashPsEntry *e, const guint8 *data, gsize *n){
+  const guint8 *p = data + e->offset;
+  gsize sz = e->size;
+  while (sz > 0 && *p == 0) { p++; sz--; }
+  if (sz > 0) { p++; sz--; } // the 0x01
+  *n = sz;
+  return p;
+}
+
+// Appends every parameter set of `type` carried by au to out, dropping
+// repeats within the same AU.
+static void collect_type(GByteArray *out, const SplashAuEntry *au, const SplashPsEntry *ps,
+                         const guint8 *data, guint8 type){
+  for (guint i = au->ps_first; i < au->ps_first + au->ps_count; ++i) {
+    if (ps[i].nal_type != type) continue;
+    gsize n;
+    const guint8 *p = ps_payload(&ps[i], data, &n);
+    if (n == 0) continue;
+    gboolean dup = FALSE;
+    for (guint j = au->ps_first; j < i && !dup; ++j) {
+      gsize m;
+      const guint8 *q = ps_payload(&ps[j], data, &m);
+      dup = ps[j].nal_type == type && m == n && memcmp(p, q, n) == 0;
+    }
+    if (dup) continue;
+    g_byte_array_append(out, start_code, sizeof(start_code));
+    g_byte_array_append(out, p, (guint)n);
+  }
+}
+
+SplashParamSets* splash_ps_new(const SplashIndex *idx, const guint8 *data, gsize len){
+  if (!idx || !data || idx->n_ps == 0) return NULL;
+  for (guint i = 0; i < idx->n_ps; ++i) {
+    if (idx->ps[i].offset + idx->ps[i].size > len) return NULL;
+  }
+  SplashParamSets *ps = g_new0(SplashParamSets, 1);
+  ps->idx = idx;
+  ps->group_of = g_new0(guint32, idx->n_aus);
+  ps->groups = g_ptr_array_new_with_free_func((GDestroyNotify)gst_memory_unref);
+
+  static const guint8 types[3] = { SPLASH_NAL_VPS, SPLASH_NAL_SPS, SPLASH_NAL_PPS };
+  GByteArray *cur[3] = { g_byte_array_new(), g_byte_array_new(), g_byte_array_new() };
+  GBytes *last = NULL; // bytes of the newest group
+  for (guint f = 0; f < idx->n_aus; ++f) {
+    const SplashAuEntry *au = &idx->aus[f];
+    if (au->ps_count > 0) {
+      for (int t = 0; t < 3; ++t) {
+        GByteArray *fresh = g_byte_array_new();
+        collect_type(fresh, au, idx->ps, data, types[t]);
+        if (fresh->len > 0) {
+          g_byte_array_unref(cur[t]);
+          cur[t] = fresh;
+        } else {
+          g_byte_array_unref(fresh);
+        }
+      }
+      GByteArray *all = g_byte_array_new();
+      for (int t = 0; t < 3; ++t) g_byte_array_append(all, cur[t]->data, cur[t]->len);
+      GBytes *bytes = g_byte_array_free_to_bytes(all);
+      if (last && g_bytes_equal(last, bytes)) {
+        g_bytes_unref(bytes);
+      } else {
+        if (last) g_bytes_unref(last);
+        last = bytes;
+        gsize n;
+        gpointer blob = (gpointer)g_bytes_get_data(bytes, &n);
+        g_ptr_array_add(ps->groups,
+                        gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, blob, n, 0, n,
+                                               g_bytes_ref(bytes),
+                                               (GDestroyNotify)g_bytes_unref));
+      }
+    }
+    // Frames ahead of the first parameter sets borrow group 0
+    ps->group_of[f] = ps->groups->len > 0 ? ps->groups->len - 1 : 0;
+  }
+  for (int t = 0; t < 3; ++t) g_byte_array_unref(cur[t]);
+  if (last) g_bytes_unref(last);
+  if (ps->groups->len == 0) {
+    splash_ps_free(ps);
+    return NULL;
+  }
+  return ps;
+}
+
+void splash_ps_free(SplashParamSets *ps){
+  if (!ps) return;
+  g_ptr_array_unref(ps->groups);
+  g_free(ps->group_of);
+  g_free(ps);
+}
+
+guint splash_ps_group(const SplashParamSets *ps, guint frame){
+  if (!ps || frame >= ps->idx->n_aus) return 0;
+  return ps->group_of[frame];
+}
+
+guint splash_ps_n_groups(const SplashParamSets *ps){
+  return ps ? ps->groups->len : 0;
+}
+
+// End of the leading AUD NAL (where parameter sets must go), or 0.
+static gsize aud_end(GstBuffer *au){
+  GstMapInfo mi;
+  if (!gst_buffer_map(au, &mi, GST_MAP_READ)) return 0;
+  gsize pos = 0, end = 0;
+  while (pos + 3 < mi.size && mi.data[pos] == 0) pos++;
+  if (pos >= 2 && pos + 1 < mi.size && mi.data[pos] == 1 &&
+      ((mi.data[pos + 1] >> 1) & 0x3f) == SPLASH_NAL_AUD) {
+    gsize i = splash_scan_next(mi.data, pos + 1, mi.size);
+    if (i < mi.size) end = mi.data[i - 1] == 0 ? i - 1 : i;
+  }
+  gst_buffer_unmap(au, &mi);
+  return end;
+}
+
+static void append_region(GstBuffer *out, GstBuffer *au, gsize from, gsize to){
+  if (to > from) gst_buffer_copy_into(out, au, GST_BUFFER_COPY_MEMORY, from, to - from);
+}
+
+GstBuffer* splash_ps_rewrite(const SplashParamSets *ps, guint frame, GstBuffer *au,
+                             gboolean inject, gsize *stripped, gsize *injected){
+  *stripped = 0;
+  *injected = 0;
+  if (!ps || !au || frame >= ps->idx->n_aus) return au;
+  const SplashAuEntry *e = &ps->idx->aus[frame];
+  if (!inject && e->ps_count == 0) return au;
+
+  gsize total = gst_buffer_get_size(au);
+  gsize ins = inject ? aud_end(au) : 0;
+  GstMemory *group = g_ptr_array_index(ps->groups, ps->group_of[frame]);
+  GstBuffer *out = gst_buffer_new();
+  gst_buffer_copy_into(out, au, GST_BUFFER_COPY_METADATA, 0, -1);
+  gsize pos = 0;
+  for (guint i = e->ps_first; i < e->ps_first + e->ps_count; ++i) {
+    const SplashPsEntry *p = &ps->idx->ps[i];
+    gsize a = (gsize)(p->offset - e->offset);
+    gsize b = MIN(a + p->size, total);
+    if (a < pos || a >= total) continue;
+    if (inject && ins <= a) {
+      ins = MAX(ins, pos);
+      append_region(out, au, pos, ins);
+      gst_buffer_append_memory(out, gst_memory_ref(group));
+      *injected = gst_memory_get_sizes(group, NULL, NULL);
+      pos = ins;
+      inject = FALSE;
+    }
+    append_region(out, au, pos, a);
+    *stripped += b - a;
+    pos = b;
+  }
+  if (inject) {
+    ins = MAX(ins, pos);
+    append_region(out, au, pos, ins);
+    gst_buffer_append_memory(out, gst_memory_ref(group));
+    *injected = gst_memory_get_sizes(group, NULL, NULL);
+    pos = ins;
+  }
+  append_region(out, au, pos, total);
+  gst_buffer_unref(au);
+  return out;
+}
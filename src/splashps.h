@@ -0,0 +1,40 @@
+#ifndef SPLASHPS_H
+#define SPLASHPS_H
+
+#include <gst/gst.h>
+#include "splashindex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Out-of-band parameter sets for the native reader.
+//
+// VPS/SPS/PPS NALs are collected once from the frame index into deduplicated
+// groups (one group per distinct decoder configuration, normalised to 4-byte
+// start codes). Frames are then served without their in-band copies and the
+// active group is injected only where a decoder needs it, so neither the
+// reader nor the sender has to run h265parse over every frame.
+
+typedef struct SplashParamSets SplashParamSets;
+
+// Returns NULL when the stream carries no parameter sets. data/len is the
+// indexed Annex-B stream; idx must outlive the returned object.
+SplashParamSets* splash_ps_new(const SplashIndex *idx, const guint8 *data, gsize len);
+void splash_ps_free(SplashParamSets *ps);
+
+// Group in effect for `frame` (the most recent one at or before it).
+guint splash_ps_group(const SplashParamSets *ps, guint frame);
+guint splash_ps_n_groups(const SplashParamSets *ps);
+
+// Takes ownership of au (the whole access unit of `frame`) and returns it
+// without in-band VPS/SPS/PPS. With inject set, the frame's group is inserted
+// after the leading AUD (or at the start). Memory is shared, not copied.
+// *stripped / *injected receive the bytes removed and added.
+GstBuffer* splash_ps_rewrite(const SplashParamSets *ps, guint frame, GstBuffer *au,
+                             gboolean inject, gsize *stripped, gsize *injected);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,49 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "splashrt.h"
+#include <gio/gio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+gboolean splash_rt_apply(const SplashThreadSched *sched, GError **err){
+  if (!sched) return TRUE;
+  if (sched->policy != SPLASH_SCHED_OTHER) {
+    int policy = sched->policy == SPLASH_SCHED_FIFO ? SCHED_FIFO : SCHED_RR;
+    int lo = sched_get_priority_min(policy), hi = sched_get_priority_max(policy);
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = CLAMP(sched->priority > 0 ? sched->priority : lo, lo, hi);
+    int rc = pthread_setschedparam(pthread_self(), policy, &sp);
+    if (rc != 0) {
+      g_set_error(err, G_IO_ERROR, g_io_error_from_errno(rc),
+                  "cannot set %s priority %d: %s",
+                  policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR",
+                  sp.sched_priority, g_strerror(rc));
+      return FALSE;
+    }
+  }
+  if (sched->cpus != 0) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (sched->cpus & (G_GUINT64_CONSTANT(1) << cpu)) CPU_SET(cpu, &set);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+      g_set_error(err, G_IO_ERROR, g_io_error_from_errno(rc),
+                  "cannot set CPU affinity 0x%" G_GINT64_MODIFIER "x: %s",
+                  sched->cpus, g_strerror(rc));
+      return FALSE;
+    }
+#else
+    g_set_error(err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                "CPU affinity is not supported on this platform");
+    return FALSE;
+#endif
+  }
+  return TRUE;
+}
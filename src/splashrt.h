@@ -0,0 +1,20 @@
+#ifndef SPLASHRT_H
+#define SPLASHRT_H
+
+#include <glib.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scheduling class, priority and CPU affinity of the calling thread.
+// SCHED_FIFO/SCHED_RR need CAP_SYS_NICE (or a matching RLIMIT_RTPRIO), and
+// the affinity mask must include CPUs of the process's cpuset. A zeroed
+// SplashThreadSched leaves the thread alone.
+gboolean splash_rt_apply(const SplashThreadSched *sched, GError **err);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,409 @@
+#include "splashrtp.h"
+#include "splashscan.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define RTP_HEADER_BYTES 12
+#define NAL_HEADER_BYTES 2
+#define AP_NALU_BYTES    2  // size field in front of each aggregated NAL unit
+#define FU_HEADER_BYTES  3  // payload header + FU header
+#define NAL_TYPE_AP      48
+#define NAL_TYPE_FU      49
+
+typedef struct {
+  const guint8 *data;
+  gsize size;
+} Nal;
+
+struct SplashRtp {
+  guint mtu;
+  guint8 pt;
+  SplashAggregateMode mode;
+  guint32 ssrc;
+  guint16 seq;
+  guint32 ts_base;
+  GByteArray *pkts;   // packets of the current AU, back to back
+  GArray *lens;       // their sizes (gsize)
+  GArray *ap;         // NAL units of the open aggregation packet (Nal)
+  gsize ap_bytes;     // its size so far, RTP header included
+};
+
+SplashRtp* splash_rtp_new(guint mtu, guint8 payload_type, SplashAggregateMode mode,
+                          guint32 ssrc, guint16 seq, guint32 ts_base){
+  if (mtu < RTP_HEADER_BYTES + FU_HEADER_BYTES + 1) return NULL;
+  SplashRtp *r = g_new0(SplashRtp, 1);
+  r->mtu = mtu;
+  r->pt = payload_type & 0x7f;
+  r->mode = mode;
+  r->ssrc = ssrc;
+  r->seq = seq;
+  r->ts_base = ts_base;
+  r->pkts = g_byte_array_new();
+  r->lens = g_array_new(FALSE, FALSE, sizeof(gsize));
+  r->ap = g_array_new(FALSE, FALSE, sizeof(Nal));
+  return r;
+}
+
+void splash_rtp_free(SplashRtp *r){
+  if (!r) return;
+  g_byte_array_free(r->pkts, TRUE);
+  g_array_free(r->lens, TRUE);
+  g_array_free(r->ap, TRUE);
+  g_free(r);
+}
+
+// Starts a packet with its RTP header; the marker bit is set once the AU's
+// last packet is known.
+static void begin_packet(SplashRtp *r, guint32 ts){
+  guint8 h[RTP_HEADER_BYTES] = {
+    0x80, r->pt, (guint8)(r->seq >> 8), (guint8)r->seq,
+    (guint8)(ts >> 24), (guint8)(ts >> 16), (guint8)(ts >> 8), (guint8)ts,
+    (guint8)(r->ssrc >> 24), (guint8)(r->ssrc >> 16), (guint8)(r->ssrc >> 8), (guint8)r->ssrc,
+  };
+  r->seq++;
+  g_byte_array_append(r->pkts, h, sizeof(h));
+}
+
+static void end_packet(SplashRtp *r, gsize start){
+  gsize len = r->pkts->len - start;
+  g_array_append_val(r->lens, len);
+}
+
+static void single_packet(SplashRtp *r, guint32 ts, const Nal *n){
+  gsize start = r->pkts->len;
+  begin_packet(r, ts);
+  g_byte_array_append(r->pkts, n->data, (guint)n->size);
+  end_packet(r, start);
+}
+
+static void fu_packets(SplashRtp *r, guint32 ts, const Nal *n){
+  guint8 type = (n->data[0] >> 1) & 0x3f;
+  guint8 hdr[FU_HEADER_BYTES] = {
+    (guint8)((n->data[0] & 0x81) | (NAL_TYPE_FU << 1)), n->data[1], 0,
+  };
+  gsize chunk = r->mtu - RTP_HEADER_BYTES - FU_HEADER_BYTES;
+  const guint8 *p = n->data + NAL_HEADER_BYTES;
+  gsize left = n->size - NAL_HEADER_BYTES;
+  gboolean first = TRUE;
+  while (left > 0) {
+    gsize take = MIN(left, chunk);
+    hdr[2] = (guint8)((first ? 0x80 : 0) | (take == left ? 0x40 : 0) | type);
+    gsize start = r->pkts->len;
+    begin_packet(r, ts);
+    g_byte_array_append(r->pkts, hdr, sizeof(hdr));
+    g_byte_array_append(r->pkts, p, (guint)take);
+    end_packet(r, start);
+    p += take;
+    left -= take;
+    first = FALSE;
+  }
+}
+
+// Sends the open aggregation packet: a lone NAL unit goes out as a single
+// NAL unit packet, two or more behind an AP header carrying the highest F
+// bit and the lowest LayerId and TID of its units.
+static void flush_ap(SplashRtp *r, guint32 ts){
+  if (r->ap->len == 1) {
+    single_packet(r, ts, &g_array_index(r->ap, Nal, 0));
+  } else if (r->ap->len > 1) {
+    guint8 f = 0, layer = 0x3f, tid = 7;
+    for (guint i = 0; i < r->ap->len; ++i) {
+      const guint8 *h = g_array_index(r->ap, Nal, i).data;
+      f |= h[0] & 0x80;
+      layer = MIN(layer, (guint8)(((h[0] & 1) << 5) | (h[1] >> 3)));
+      tid = MIN(tid, (guint8)(h[1] & 7));
+    }
+    guint8 ph[NAL_HEADER_BYTES] = {
+      (guint8)(f | (NAL_TYPE_AP << 1) | (layer >> 5)), (guint8)(((layer & 0x1f) << 3) | tid),
+    };
+    gsize start = r->pkts->len;
+    begin_packet(r, ts);
+    g_byte_array_append(r->pkts, ph, sizeof(ph));
+    for (guint i = 0; i < r->ap->len; ++i) {
+      const Nal *n = &g_array_index(r->ap, Nal, i);
+      guint8 sz[AP_NALU_BYTES] = { (guint8)(n->size >> 8), (guint8)n->size };
+      g_byte_array_append(r->pkts, sz, sizeof(sz));
+      g_byte_array_append(r->pkts, n->data, (guint)n->size);
+    }
+    end_packet(r, start);
+  }
+  g_array_set_size(r->ap, 0);
+  r->ap_bytes = 0;
+}
+
+static void add_nal(SplashRtp *r, guint32 ts, const Nal *n){
+  if (n->size + RTP_HEADER_BYTES > r->mtu) {
+    flush_ap(r, ts);
+    fu_packets(r, ts, n);
+    return;
+  }
+  if (r->mode == SPLASH_AGGREGATE_NONE) {
+    single_packet(r, ts, n);
+    return;
+  }
+  gsize need = AP_NALU_BYTES + n->size;
+  if (r->ap_bytes && r->ap_bytes + need > r->mtu) flush_ap(r, ts);
+  if (!r->ap_bytes) r->ap_bytes = RTP_HEADER_BYTES + NAL_HEADER_BYTES;
+  r->ap_bytes += need;
+  g_array_append_val(r->ap, *n);
+  gboolean vcl = ((n->data[0] >> 1) & 0x3f) < 32;
+  if (vcl && r->mode == SPLASH_AGGREGATE_ZERO_LATENCY) flush_ap(r, ts);
+}
+
+guint splash_rtp_packetize(SplashRtp *r, const guint8 *au, gsize len, guint64 pts_ns,
+                           SplashRtpPacketFn fn, gpointer user, guint *nals){
+  if (nals) *nals = 0;
+  if (!r || !au) return 0;
+  // 90 kHz, split so large PTS values cannot overflow
+  guint32 ts = r->ts_base + (guint32)((pts_ns / 100000) * 9 + (pts_ns % 100000) * 9 / 100000);
+  g_byte_array_set_size(r->pkts, 0);
+  g_array_set_size(r->lens, 0);
+
+  gsize sc = splash_scan_next(au, 0, len);
+  while (sc < len) {
+    gsize nal = sc + 3;
+    gsize next = splash_scan_next(au, nal, len);
+    gsize end = next;
+    if (next < len && au[next - 1] == 0) end = next - 1; // 4-byte start code
+    if (end >= nal + NAL_HEADER_BYTES) {
+      Nal n = { au + nal, end - nal };
+      add_nal(r, ts, &n);
+      if (nals) (*nals)++;
+    }
+    sc = next;
+  }
+  flush_ap(r, ts);
+
+  guint count = r->lens->len;
+  if (count == 0) return 0;
+  gsize off = 0;
+  for (guint i = 0; i < count; ++i) {
+    gsize plen = g_array_index(r->lens, gsize, i);
+    if (i + 1 == count) r->pkts->data[off + 1] |= 0x80;
+    if (fn && !fn(r->pkts->data + off, plen, user)) return 0;
+    off += plen;
+  }
+  return count;
+}
+
+// ---- depacketizer ----
+#define NAL_TYPE_PACI    50
+
+gboolean splash_rtp_parse_header(const guint8 *pkt, gsize len, SplashRtpHeader *h){
+  if (!pkt || len < RTP_HEADER_BYTES || (pkt[0] >> 6) != 2) return FALSE;
+  gsize off = RTP_HEADER_BYTES + (gsize)(pkt[0] & 0x0f) * 4;
+  if (pkt[0] & 0x10) {
+    if (off + 4 > len) return FALSE;
+    off += 4 + (gsize)(pkt[off + 2] << 8 | pkt[off + 3]) * 4;
+  }
+  gsize pad = (pkt[0] & 0x20) ? pkt[len - 1] : 0;
+  if (off + pad > len) return FALSE;
+  h->pt = pkt[1] & 0x7f;
+  h->marker = (pkt[1] & 0x80) != 0;
+  h->seq = (guint16)(pkt[2] << 8 | pkt[3]);
+  h->ts = (guint32)pkt[4] << 24 | (guint32)pkt[5] << 16 | (guint32)pkt[6] << 8 | pkt[7];
+  h->ssrc = (guint32)pkt[8] << 24 | (guint32)pkt[9] << 16 | (guint32)pkt[10] << 8 | pkt[11];
+  h->payload = off;
+  h->payload_len = len - off - pad;
+  return TRUE;
+}
+
+struct SplashRtpDepay {
+  SplashRtpAuFn fn;
+  gpointer user;
+  GByteArray *au;
+  gboolean open;       // an AU is being collected
+  guint32 ts;
+  gboolean complete;
+  gboolean in_fu;      // inside a fragmented NAL unit
+  gboolean have_seq;
+  guint16 next_seq;
+};
+
+SplashRtpDepay* splash_rtp_depay_new(SplashRtpAuFn fn, gpointer user){
+  SplashRtpDepay *d = g_new0(SplashRtpDepay, 1);
+  d->fn = fn;
+  d->user = user;
+  d->au = g_byte_array_new();
+  return d;
+}
+
+void splash_rtp_depay_free(SplashRtpDepay *d){
+  if (!d) return;
+  g_byte_array_free(d->au, TRUE);
+  g_free(d);
+}
+
+static void emit_au(SplashRtpDepay *d, gboolean complete){
+  if (d->open && d->au->len > 0 && d->fn) {
+    d->fn(d->au->data, d->au->len, d->ts, complete && d->complete && !d->in_fu, d->user);
+  }
+  g_byte_array_set_size(d->au, 0);
+  d->open = FALSE;
+  d->in_fu = FALSE;
+}
+
+void splash_rtp_depay_flush(SplashRtpDepay *d){
+  if (d) emit_au(d, FALSE);
+}
+
+static void append_nal(SplashRtpDepay *d, const guint8 *nal, gsize len){
+  static const guint8 sc[4] = { 0, 0, 0, 1 };
+  g_byte_array_append(d->au, sc, sizeof(sc));
+  g_byte_array_append(d->au, nal, (guint)len);
+}
+
+gboolean splash_rtp_depay_push(SplashRtpDepay *d, const guint8 *pkt, gsize len){
+  SplashRtpHeader h;
+  if (!d || !splash_rtp_parse_header(pkt, len, &h)) return FALSE;
+  // A gap means lost packets: the AU they belonged to cannot be complete,
+  // and neither can one this packet does not start cleanly.
+  gboolean gap = d->have_seq && h.seq != d->next_seq;
+  d->have_seq = TRUE;
+  d->next_seq = (guint16)(h.seq + 1);
+  if (d->open && h.ts != d->ts) emit_au(d, FALSE);
+  if (gap && d->open) d->complete = FALSE;
+  if (!d->open) {
+    d->open = TRUE;
+    d->ts = h.ts;
+    d->complete = !gap;
+  }
+
+  const guint8 *p = pkt + h.payload;
+  gsize n = h.payload_len;
+  if (n < NAL_HEADER_BYTES) {
+    d->complete = FALSE;
+  } else {
+    guint8 type = (p[0] >> 1) & 0x3f;
+    if (type == NAL_TYPE_AP) {
+      gsize off = NAL_HEADER_BYTES;
+      while (off + AP_NALU_BYTES <= n) {
+        gsize sz = (gsize)(p[off] << 8 | p[off + 1]);
+        off += AP_NALU_BYTES;
+        if (sz < NAL_HEADER_BYTES || off + sz > n) {
+          d->complete = FALSE;
+          break;
+        }
+        append_nal(d, p + off, sz);
+        off += sz;
+      }
+    } else if (type == NAL_TYPE_FU) {
+      if (n < FU_HEADER_BYTES) {
+        d->complete = FALSE;
+      } else {
+        guint8 fu = p[2];
+        if (fu & 0x80) {
+          if (d->in_fu) d->complete = FALSE;  // the previous one never ended
+          guint8 hdr[NAL_HEADER_BYTES] = {
+            (guint8)((p[0] & 0x81) | ((fu & 0x3f) << 1)), p[1],
+          };
+          append_nal(d, hdr, sizeof(hdr));
+          d->in_fu = TRUE;
+        } else if (gap || !d->in_fu) {
+          d->complete = FALSE;  // fragments of this NAL unit were lost
+          d->in_fu = FALSE;
+        }
+        if (d->in_fu) {
+          g_byte_array_append(d->au, p + FU_HEADER_BYTES, (guint)(n - FU_HEADER_BYTES));
+        }
+        if (fu & 0x40) d->in_fu = FALSE;
+      }
+    } else if (type == NAL_TYPE_PACI) {
+      d->complete = FALSE;
+    } else {
+      append_nal(d, p, n);
+    }
+  }
+  if (h.marker) emit_au(d, TRUE);
+  return TRUE;
+}
+
+// ---- pcap ----
+#define PCAP_MAGIC       0xa1b2c3d4u
+#define PCAP_LINKTYPE_RAW 101
+#define IP_HEADER_BYTES  20
+#define UDP_HEADER_BYTES 8
+
+struct SplashPcap {
+  FILE *f;
+  guint8 dst[4];
+  guint16 port;
+  guint16 ip_id;
+  gboolean failed;
+  int err_no;
+};
+
+static gboolean pcap_put(SplashPcap *p, const void *data, gsize len){
+  if (p->failed) return FALSE;
+  if (fwrite(data, 1, len, p->f) != len) {
+    p->failed = TRUE;
+    p->err_no = errno;
+  }
+  return !p->failed;
+}
+
+SplashPcap* splash_pcap_open(const char *path, const char *host, int port, GError **err){
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    int e = errno;
+    g_set_error(err, G_FILE_ERROR, g_file_error_from_errno(e),
+                "cannot create '%s': %s", path, g_strerror(e));
+    return NULL;
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 20);
+  SplashPcap *p = g_new0(SplashPcap, 1);
+  p->f = f;
+  p->port = (guint16)port;
+  static const guint8 loopback[4] = { 127, 0, 0, 1 };
+  if (!host || inet_pton(AF_INET, host, p->dst) != 1) memcpy(p->dst, loopback, 4);
+  guint32 hdr[6] = { PCAP_MAGIC, 2 | (4u << 16), 0, 0, 65535, PCAP_LINKTYPE_RAW };
+  pcap_put(p, hdr, sizeof(hdr));
+  return p;
+}
+
+// Native byte order for the file header fields (the magic tells readers
+// which), network order inside the packets.
+gboolean splash_pcap_write(SplashPcap *p, gint64 ts_us, const guint8 *payload, gsize len){
+  if (!p || len + IP_HEADER_BYTES + UDP_HEADER_BYTES > 65535) return FALSE;
+  guint16 total = (guint16)(len + IP_HEADER_BYTES + UDP_HEADER_BYTES);
+  guint32 rec[4] = { (guint32)(ts_us / G_USEC_PER_SEC), (guint32)(ts_us % G_USEC_PER_SEC),
+                     total, total };
+  guint8 ip[IP_HEADER_BYTES] = {
+    0x45, 0, (guint8)(total >> 8), (guint8)total,
+    (guint8)(p->ip_id >> 8), (guint8)p->ip_id, 0x40, 0,  // DF
+    64, 17, 0, 0,                                        // TTL, UDP, checksum
+    127, 0, 0, 1,
+    p->dst[0], p->dst[1], p->dst[2], p->dst[3],
+  };
+  guint32 sum = 0;
+  for (int i = 0; i < IP_HEADER_BYTES; i += 2) sum += (guint32)(ip[i] << 8 | ip[i + 1]);
+  while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+  ip[10] = (guint8)(~sum >> 8);
+  ip[11] = (guint8)~sum;
+  guint16 ulen = (guint16)(len + UDP_HEADER_BYTES);
+  guint8 udp[UDP_HEADER_BYTES] = {
+    (guint8)(p->port >> 8), (guint8)p->port, (guint8)(p->port >> 8), (guint8)p->port,
+    (guint8)(ulen >> 8), (guint8)ulen, 0, 0,             // no UDP checksum (IPv4)
+  };
+  p->ip_id++;
+  return pcap_put(p, rec, sizeof(rec)) && pcap_put(p, ip, sizeof(ip)) &&
+         pcap_put(p, udp, sizeof(udp)) && pcap_put(p, payload, len);
+}
+
+gboolean splash_pcap_close(SplashPcap *p, GError **err){
+  if (!p) return FALSE;
+  gboolean ok = !p->failed;
+  int e = p->err_no;
+  if (fclose(p->f) != 0 && ok) {
+    ok = FALSE;
+    e = errno;
+  }
+  if (!ok) {
+    g_set_error(err, G_FILE_ERROR, g_file_error_from_errno(e),
+                "writing the capture failed: %s", g_strerror(e));
+  }
+  g_free(p);
+  return ok;
+}
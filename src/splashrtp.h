@@ -0,0 +1,78 @@
+#ifndef SPLASHRTP_H
+#define SPLASHRTP_H
+
+#include <glib.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RTP packetizer for H.265 (RFC 7798) laid out like the UDP sender's
+// rtph265pay: single NAL unit packets, aggregation packets (AP) as the
+// SplashAggregateMode allows, fragmentation units (FU) for NAL units larger
+// than the MTU, and the marker bit on the last packet of every access unit.
+// Used where packets are needed without a pipeline (offline renders,
+// splash_probe).
+
+typedef struct SplashRtp SplashRtp;
+
+// Called once per packet; pkt (RTP header included) is only valid during the call.
+typedef gboolean (*SplashRtpPacketFn)(const guint8 *pkt, gsize len, gpointer user);
+
+// mtu counts the RTP header, like rtph265pay's "mtu" property.
+SplashRtp* splash_rtp_new(guint mtu, guint8 payload_type, SplashAggregateMode mode,
+                          guint32 ssrc, guint16 seq, guint32 ts_base);
+void       splash_rtp_free(SplashRtp *r);
+
+// Packetizes one Annex-B access unit presented at pts_ns (RTP timestamps run
+// at 90 kHz from ts_base). fn may be NULL to only count. Returns the number
+// of packets, 0 if fn failed; *nals (optional) receives the NAL unit count.
+guint splash_rtp_packetize(SplashRtp *r, const guint8 *au, gsize len, guint64 pts_ns,
+                           SplashRtpPacketFn fn, gpointer user, guint *nals);
+
+// Fixed RTP header fields of a received packet.
+typedef struct {
+  guint8   pt;
+  gboolean marker;
+  guint16  seq;
+  guint32  ts;
+  guint32  ssrc;
+  gsize    payload;      // offset of the payload (CSRCs and extension skipped)
+  gsize    payload_len;  // padding excluded
+} SplashRtpHeader;
+
+// FALSE unless pkt is an RTP version 2 packet with a consistent layout.
+gboolean splash_rtp_parse_header(const guint8 *pkt, gsize len, SplashRtpHeader *h);
+
+// Depacketizer for the packetizer's output (and rtph265pay's): single NAL
+// unit packets, APs and FUs without DONL fields. Access units end on the
+// marker bit or a timestamp change and are handed out in Annex-B form.
+typedef struct SplashRtpDepay SplashRtpDepay;
+
+// au is only valid during the call. complete is FALSE when packets of the AU
+// were lost on the way, or when its marker packet was.
+typedef void (*SplashRtpAuFn)(const guint8 *au, gsize len, guint32 rtp_ts,
+                              gboolean complete, gpointer user);
+
+SplashRtpDepay* splash_rtp_depay_new(SplashRtpAuFn fn, gpointer user);
+void            splash_rtp_depay_free(SplashRtpDepay *d);
+// Feeds one packet in arrival order. FALSE if it is not an RTP packet.
+gboolean        splash_rtp_depay_push(SplashRtpDepay *d, const guint8 *pkt, gsize len);
+// Hands out an AU still waiting for its marker packet.
+void            splash_rtp_depay_flush(SplashRtpDepay *d);
+
+// Capture file of RTP packets as IPv4/UDP datagrams to host:port
+// (LINKTYPE_RAW), for Wireshark's RTP analysis or replay tools. Hosts that
+// are not IPv4 literals are recorded as 127.0.0.1.
+typedef struct SplashPcap SplashPcap;
+
+SplashPcap* splash_pcap_open(const char *path, const char *host, int port, GError **err);
+gboolean    splash_pcap_write(SplashPcap *p, gint64 ts_us, const guint8 *payload, gsize len);
+// Flushes and closes; FALSE (with err set) if any write failed.
+gboolean    splash_pcap_close(SplashPcap *p, GError **err);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,177 @@
+#include "splashrtx.h"
+#include "splashrtp.h"
+#include <string.h>
+
+#define MAX_HISTORY      32768
+#define OSN_BYTES        2    // original sequence number in front of the RTX payload
+#define RTCP_PT_RTPFB    205
+#define RTCP_FMT_NACK    1
+#define RTCP_FB_HEADER   12   // common header + sender SSRC + media SSRC
+#define NACK_FCI_BYTES   4    // PID + BLP
+
+typedef struct {
+  guint8 *data;
+  gsize len;
+  gsize alloc;
+  guint16 seq;
+  gboolean used;
+  gint64 sent_us;
+} Slot;
+
+struct SplashRtx {
+  gint refs;          // atomic
+  GMutex lock;
+  Slot *slots;
+  guint cap;          // power of two, so slots follow seq across its wrap
+  guint8 pt;
+  guint32 ssrc;
+  guint16 seq;
+  guint32 media_ssrc; // SSRC of the stored packets
+  gboolean have_media;
+  GByteArray *pkt;    // retransmission being built
+  SplashRtxStats st;
+  gint64 repair_sum_us;
+};
+
+static guint32 be32(const guint8 *p){
+  return (guint32)p[0] << 24 | (guint32)p[1] << 16 | (guint32)p[2] << 8 | p[3];
+}
+
+SplashRtx* splash_rtx_new(guint history, guint8 rtx_payload_type, guint32 rtx_ssrc,
+                          guint16 rtx_seq){
+  if (history == 0) return NULL;
+  SplashRtx *r = g_new0(SplashRtx, 1);
+  r->refs = 1;
+  r->cap = 1;
+  while (r->cap < history && r->cap < MAX_HISTORY) r->cap <<= 1;
+  r->slots = g_new0(Slot, r->cap);
+  r->pt = rtx_payload_type & 0x7f;
+  r->ssrc = rtx_ssrc;
+  r->seq = rtx_seq;
+  r->pkt = g_byte_array_new();
+  g_mutex_init(&r->lock);
+  return r;
+}
+
+SplashRtx* splash_rtx_ref(SplashRtx *r){
+  if (r) g_atomic_int_inc(&r->refs);
+  return r;
+}
+
+void splash_rtx_unref(SplashRtx *r){
+  if (!r || !g_atomic_int_dec_and_test(&r->refs)) return;
+  for (guint i = 0; i < r->cap; ++i) g_free(r->slots[i].data);
+  g_free(r->slots);
+  g_byte_array_free(r->pkt, TRUE);
+  g_mutex_clear(&r->lock);
+  g_free(r);
+}
+
+void splash_rtx_store(SplashRtx *r, const guint8 *pkt, gsize len, gint64 now_us){
+  SplashRtpHeader h;
+  if (!r || !splash_rtp_parse_header(pkt, len, &h)) return;
+  g_mutex_lock(&r->lock);
+  if (!r->have_media || h.ssrc != r->media_ssrc) {
+    // New stream: what is stored belongs to the old one
+    for (guint i = 0; i < r->cap; ++i) r->slots[i].used = FALSE;
+    r->media_ssrc = h.ssrc;
+    r->have_media = TRUE;
+  }
+  Slot *sl = &r->slots[h.seq & (r->cap - 1)];
+  if (sl->alloc < len) {
+    sl->data = g_realloc(sl->data, len);
+    sl->alloc = len;
+  }
+  memcpy(sl->data, pkt, len);
+  sl->len = len;
+  sl->seq = h.seq;
+  sl->used = TRUE;
+  sl->sent_us = now_us;
+  g_mutex_unlock(&r->lock);
+}
+
+// Builds the RTX packet for a stored one: its header with the RTX payload
+// type, SSRC and sequence number (marker, timestamp, CSRCs and extension
+// kept), then the original sequence number and payload. Caller holds r->lock.
+static void build_rtx_locked(SplashRtx *r, const Slot *sl){
+  SplashRtpHeader h;
+  g_byte_array_set_size(r->pkt, 0);
+  if (!splash_rtp_parse_header(sl->data, sl->len, &h)) return;
+  g_byte_array_append(r->pkt, sl->data, (guint)h.payload);
+  guint8 *p = r->pkt->data;
+  p[0] &= ~0x20;  // no padding
+  p[1] = (guint8)((p[1] & 0x80) | r->pt);
+  p[2] = (guint8)(r->seq >> 8);
+  p[3] = (guint8)r->seq;
+  p[8] = (guint8)(r->ssrc >> 24);
+  p[9] = (guint8)(r->ssrc >> 16);
+  p[10] = (guint8)(r->ssrc >> 8);
+  p[11] = (guint8)r->ssrc;
+  guint8 osn[OSN_BYTES] = { (guint8)(sl->seq >> 8), (guint8)sl->seq };
+  g_byte_array_append(r->pkt, osn, sizeof(osn));
+  g_byte_array_append(r->pkt, sl->data + h.payload, (guint)h.payload_len);
+  r->seq++;
+}
+
+// Retransmits one requested packet. Caller holds r->lock.
+static gboolean resend_locked(SplashRtx *r, guint16 seq, gint64 now_us,
+                              SplashRtxSendFn fn, gpointer user){
+  r->st.requested++;
+  const Slot *sl = &r->slots[seq & (r->cap - 1)];
+  if (!sl->used || sl->seq != seq) {
+    r->st.missed++;
+    return FALSE;
+  }
+  build_rtx_locked(r, sl);
+  if (r->pkt->len == 0 || (fn && !fn(r->pkt->data, r->pkt->len, user))) return FALSE;
+  gint64 repair = now_us - sl->sent_us;
+  r->st.sent++;
+  r->repair_sum_us += repair;
+  r->st.repair_us = r->repair_sum_us / (gint64)r->st.sent;
+  if (repair > r->st.repair_max_us) r->st.repair_max_us = repair;
+  return TRUE;
+}
+
+guint splash_rtx_handle_rtcp(SplashRtx *r, const guint8 *rtcp, gsize len, gint64 now_us,
+                             SplashRtxSendFn fn, gpointer user){
+  if (!r || !rtcp) return 0;
+  guint sent = 0;
+  g_mutex_lock(&r->lock);
+  gsize off = 0;
+  while (off + 4 <= len && (rtcp[off] >> 6) == 2) {
+    gsize plen = ((gsize)(rtcp[off + 2] << 8 | rtcp[off + 3]) + 1) * 4;
+    if (off + plen > len) break;
+    if (rtcp[off + 1] == RTCP_PT_RTPFB && (rtcp[off] & 0x1f) == RTCP_FMT_NACK &&
+        plen >= RTCP_FB_HEADER && r->have_media && be32(rtcp + off + 8) == r->media_ssrc) {
+      for (gsize f = off + RTCP_FB_HEADER; f + NACK_FCI_BYTES <= off + plen; f += NACK_FCI_BYTES) {
+        guint16 pid = (guint16)(rtcp[f] << 8 | rtcp[f + 1]);
+        guint16 blp = (guint16)(rtcp[f + 2] << 8 | rtcp[f + 3]);
+        r->st.nacks++;
+        if (resend_locked(r, pid, now_us, fn, user)) sent++;
+        for (int b = 0; b < 16; ++b) {
+          if ((blp >> b) & 1) {
+            if (resend_locked(r, (guint16)(pid + b + 1), now_us, fn, user)) sent++;
+          }
+        }
+      }
+    }
+    off += plen;
+  }
+  g_mutex_unlock(&r->lock);
+  return sent;
+}
+
+void splash_rtx_get_stats(SplashRtx *r, SplashRtxStats *out){
+  if (!r || !out) return;
+  g_mutex_lock(&r->lock);
+  *out = r->st;
+  g_mutex_unlock(&r->lock);
+}
+
+void splash_rtx_reset_stats(SplashRtx *r){
+  if (!r) return;
+  g_mutex_lock(&r->lock);
+  memset(&r->st, 0, sizeof(r->st));
+  r->repair_sum_us = 0;
+  g_mutex_unlock(&r->lock);
+}
@@ -0,0 +1,45 @@
+#ifndef SPLASHRTX_H
+#define SPLASHRTX_H
+
+#include <glib.h>
+#include "splashlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RTP retransmission (RFC 4588) for the UDP sender: a ring of the packets
+// sent most recently and the handling of RTCP generic NACKs (RFC 4585
+// 6.2.1) asking for them. Retransmissions are SSRC-multiplexed: their own
+// SSRC, sequence numbers and payload type, with the original sequence
+// number in front of the original payload.
+
+typedef struct SplashRtx SplashRtx;
+
+// Called once per retransmission; pkt is only valid during the call.
+typedef gboolean (*SplashRtxSendFn)(const guint8 *pkt, gsize len, gpointer user);
+
+// history is rounded up to a power of two (at most 32768 packets). The
+// result holds one reference; sender pipelines hold their own while they
+// may still store packets.
+SplashRtx* splash_rtx_new(guint history, guint8 rtx_payload_type, guint32 rtx_ssrc,
+                          guint16 rtx_seq);
+SplashRtx* splash_rtx_ref(SplashRtx *r);
+void       splash_rtx_unref(SplashRtx *r);
+
+// Remembers a packet the sender just sent. Thread-safe.
+void  splash_rtx_store(SplashRtx *r, const guint8 *pkt, gsize len, gint64 now_us);
+
+// Handles one RTCP (compound) packet: every packet a generic NACK for the
+// stored stream asks for is retransmitted through fn if still in the
+// history. Returns the number of retransmissions. Thread-safe.
+guint splash_rtx_handle_rtcp(SplashRtx *r, const guint8 *rtcp, gsize len, gint64 now_us,
+                             SplashRtxSendFn fn, gpointer user);
+
+void splash_rtx_get_stats(SplashRtx *r, SplashRtxStats *out);
+void splash_rtx_reset_stats(SplashRtx *r);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
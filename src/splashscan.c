@@ -0,0 +1,215 @@
+#include "splashscan.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCAN_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Inputs below this size, and per-thread chunks, are never split further:
+// thread startup would cost more than scanning.
+#define SCAN_MIN_CHUNK (4u << 20)
+
+typedef gsize (*ScanFn)(const guint8 *p, gsize pos, gsize len);
+
+// A start code needs p[pos + 2] == 1, so any byte above 1 there lets the
+// scan skip three positions at once.
+static gsize scan_scalar(const guint8 *p, gsize pos, gsize len){
+  while (pos + 3 <= len) {
+    if (p[pos + 2] > 1) { pos += 3; continue; }
+    if (p[pos] == 0 && p[pos + 1] == 0 && p[pos + 2] == 1) return pos;
+    pos++;
+  }
+  return len;
+}
+
+// The vector versions test 16/32 candidate positions per step by comparing
+// three overlapping loads (bytes +0, +1, +2) and finish the tail in scalar.
+#ifdef SCAN_X86
+static gsize scan_sse2(const guint8 *p, gsize pos, gsize len){
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  while (pos + 16 + 2 <= len) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(const void*)(p + pos));
+    __m128i b = _mm_loadu_si128((const __m128i*)(const void*)(p + pos + 1));
+    __m128i c = _mm_loadu_si128((const __m128i*)(const void*)(p + pos + 2));
+    __m128i m = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)),
+                              _mm_cmpeq_epi8(c, one));
+    int bits = _mm_movemask_epi8(m);
+    if (bits) return pos + (gsize)__builtin_ctz((unsigned)bits);
+    pos += 16;
+  }
+  return scan_scalar(p, pos, len);
+}
+
+__attribute__((target("avx2")))
+static gsize scan_avx2(const guint8 *p, gsize pos, gsize len){
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1);
+  while (pos + 32 + 2 <= len) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(const void*)(p + pos));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(const void*)(p + pos + 1));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(const void*)(p + pos + 2));
+    __m256i m = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(a, zero),
+                                                  _mm256_cmpeq_epi8(b, zero)),
+                                 _mm256_cmpeq_epi8(c, one));
+    unsigned bits = (unsigned)_mm256_movemask_epi8(m);
+    if (bits) return pos + (gsize)__builtin_ctz(bits);
+    pos += 32;
+  }
+  return scan_sse2(p, pos, len);
+}
+#endif
+
+#ifdef SCAN_NEON
+static gsize scan_neon(const guint8 *p, gsize pos, gsize len){
+  const uint8x16_t zero = vdupq_n_u8(0);
+  const uint8x16_t one = vdupq_n_u8(1);
+  while (pos + 16 + 2 <= len) {
+    uint8x16_t a = vld1q_u8(p + pos);
+    uint8x16_t b = vld1q_u8(p + pos + 1);
+    uint8x16_t c = vld1q_u8(p + pos + 2);
+    uint8x16_t m = vandq_u8(vandq_u8(vceqq_u8(a, zero), vceqq_u8(b, zero)), vceqq_u8(c, one));
+    uint64x2_t w = vreinterpretq_u64_u8(m);
+    guint64 lo = vgetq_lane_u64(w, 0), hi = vgetq_lane_u64(w, 1);
+    if (lo) return pos + (gsize)__builtin_ctzll(lo) / 8;
+    if (hi) return pos + 8 + (gsize)__builtin_ctzll(hi) / 8;
+    pos += 16;
+  }
+  return scan_scalar(p, pos, len);
+}
+#endif
+
+static gboolean impl_supported(SplashScanImpl impl){
+  switch (impl) {
+    case SPLASH_SCAN_SCALAR: return TRUE;
+#ifdef SCAN_X86
+    case SPLASH_SCAN_SSE2:   return TRUE;
+    case SPLASH_SCAN_AVX2:   return __builtin_cpu_supports("avx2");
+#endif
+#ifdef SCAN_NEON
+    case SPLASH_SCAN_NEON:   return TRUE;
+#endif
+    default:                 return FALSE;
+  }
+}
+
+static ScanFn impl_fn(SplashScanImpl impl){
+  switch (impl) {
+#ifdef SCAN_X86
+    case SPLASH_SCAN_SSE2: return scan_sse2;
+    case SPLASH_SCAN_AVX2: return scan_avx2;
+#endif
+#ifdef SCAN_NEON
+    case SPLASH_SCAN_NEON: return scan_neon;
+#endif
+    default:               return scan_scalar;
+  }
+}
+
+static SplashScanImpl best_impl(void){
+  static const SplashScanImpl order[] = { SPLASH_SCAN_AVX2, SPLASH_SCAN_SSE2, SPLASH_SCAN_NEON };
+  for (gsize i = 0; i < G_N_ELEMENTS(order); ++i) {
+    if (impl_supported(order[i])) return order[i];
+  }
+  return SPLASH_SCAN_SCALAR;
+}
+
+static gint cur_impl = -1; // SplashScanImpl, -1 until first use
+
+static SplashScanImpl current_impl(void){
+  gint impl = g_atomic_int_get(&cur_impl);
+  if (impl < 0) {
+    impl = (gint)best_impl();
+    g_atomic_int_set(&cur_impl, impl);
+  }
+  return (SplashScanImpl)impl;
+}
+
+gboolean splash_scan_set_impl(SplashScanImpl impl){
+  if (impl == SPLASH_SCAN_AUTO) impl = best_impl();
+  if (!impl_supported(impl)) return FALSE;
+  g_atomic_int_set(&cur_impl, (gint)impl);
+  return TRUE;
+}
+
+SplashScanImpl splash_scan_get_impl(void){
+  return current_impl();
+}
+
+const char* splash_scan_impl_name(SplashScanImpl impl){
+  switch (impl) {
+    case SPLASH_SCAN_AUTO:   return "auto";
+    case SPLASH_SCAN_SCALAR: return "scalar";
+    case SPLASH_SCAN_SSE2:   return "sse2";
+    case SPLASH_SCAN_AVX2:   return "avx2";
+    case SPLASH_SCAN_NEON:   return "neon";
+  }
+  return "?";
+}
+
+gsize splash_scan_next(const guint8 *data, gsize pos, gsize len){
+  if (!data || pos >= len) return len;
+  return impl_fn(current_impl())(data, pos, len);
+}
+
+typedef struct {
+  const guint8 *data;
+  gsize begin, end, len;
+  ScanFn fn;
+  GArray *hits;
+} Chunk;
+
+// Collects start codes beginning in [begin, end); reads up to two bytes past
+// end so codes straddling the chunk border are found exactly once.
+static gpointer scan_chunk(gpointer user){
+  Chunk *c = (Chunk*)user;
+  gsize limit = MIN(c->end + 2, c->len);
+  gsize pos = c->begin;
+  for (;;) {
+    gsize sc = c->fn(c->data, pos, limit);
+    if (sc >= limit) break;
+    guint64 off = sc;
+    g_array_append_val(c->hits, off);
+    pos = sc + 3;
+  }
+  return NULL;
+}
+
+guint splash_scan_all(const guint8 *data, gsize len, guint max_threads, GArray *out){
+  if (!data || !out || len < 3) return 1;
+  guint threads = max_threads ? max_threads : g_get_num_processors();
+  threads = (guint)CLAMP((gsize)threads, 1, MAX(len / SCAN_MIN_CHUNK, 1));
+  ScanFn fn = impl_fn(current_impl());
+
+  if (threads == 1) {
+    Chunk c = { data, 0, len, len, fn, out };
+    scan_chunk(&c);
+    return 1;
+  }
+
+  Chunk *chunks = g_new0(Chunk, threads);
+  GThread **workers = g_new0(GThread*, threads);
+  gsize step = len / threads;
+  for (guint i = 0; i < threads; ++i) {
+    chunks[i].data = data;
+    chunks[i].begin = i * step;
+    chunks[i].end = (i + 1 == threads) ? len : (i + 1) * step;
+    chunks[i].len = len;
+    chunks[i].fn = fn;
+    chunks[i].hits = i == 0 ? out : g_array_new(FALSE, FALSE, sizeof(guint64));
+    if (i > 0) workers[i] = g_thread_new("splash-scan", scan_chunk, &chunks[i]);
+  }
+  scan_chunk(&chunks[0]);
+  for (guint i = 1; i < threads; ++i) {
+    g_thread_join(workers[i]);
+    g_array_append_vals(out, chunks[i].hits->data, chunks[i].hits->len);
+    g_array_free(chunks[i].hits, TRUE);
+  }
+  g_free(workers);
+  g_free(chunks);
+  return threads;
+}
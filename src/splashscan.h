@@ -0,0 +1,40 @@
+#ifndef SPLASHSCAN_H
+#define SPLASHSCAN_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Annex-B start-code scanner. Finds 00 00 01 sequences with SSE2/AVX2 on
+// x86-64 and NEON on ARM (picked at runtime where the CPU may lack them),
+// falling back to a scalar loop elsewhere. splash_scan_all() splits large
+// buffers across threads.
+
+typedef enum {
+  SPLASH_SCAN_AUTO = 0, // best implementation the CPU supports
+  SPLASH_SCAN_SCALAR,
+  SPLASH_SCAN_SSE2,
+  SPLASH_SCAN_AVX2,
+  SPLASH_SCAN_NEON,
+} SplashScanImpl;
+
+// Forces an implementation (for benchmarks). Returns FALSE, leaving the
+// current one in place, when this build or CPU does not support it.
+gboolean splash_scan_set_impl(SplashScanImpl impl);
+SplashScanImpl splash_scan_get_impl(void);
+const char* splash_scan_impl_name(SplashScanImpl impl);
+
+// Offset of the first 00 00 01 at or after pos, or len if there is none.
+gsize splash_scan_next(const guint8 *data, gsize pos, gsize len);
+
+// Appends the offsets (guint64) of every 00 00 01 in data to out, in order,
+// using up to max_threads workers (0 = one per CPU; small inputs always use
+// one). Returns the number of threads used.
+guint splash_scan_all(const guint8 *data, gsize len, guint max_threads, GArray *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
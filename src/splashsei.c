@@ -0,0 +1,149 @@
+#include "splashsei.h"
+#include "splashscan.h"
+#include <string.h>
+
+#define NAL_TYPE_PREFIX_SEI   39
+#define NAL_TYPE_VCL_LIMIT    32
+#define SEI_USER_DATA_UNREG   5
+#define PROBE_VERSION         1
+#define PROBE_FIELD_BYTES     32  // version, seq, reserved, switches, frame, send_us, pts
+#define PROBE_PAYLOAD_BYTES   (sizeof(probe_uuid) + PROBE_FIELD_BYTES)
+
+// uuid_iso_iec_11578 identifying splash latency probes
+static const guint8 probe_uuid[16] = {
+  0x5f, 0x3a, 0x9c, 0x1e, 0x7b, 0x2d, 0x4c, 0x8e,
+  0x9a, 0x61, 0x0d, 0x4e, 0x8b, 0x7f, 0x2c, 0x35,
+};
+
+static void put_be(guint8 *p, guint64 v, int bytes){
+  for (int i = bytes - 1; i >= 0; --i) { p[i] = (guint8)v; v >>= 8; }
+}
+
+static guint64 get_be(const guint8 *p, int bytes){
+  guint64 v = 0;
+  for (int i = 0; i < bytes; ++i) v = (v << 8) | p[i];
+  return v;
+}
+
+// Start code, NAL header and RBSP with emulation prevention bytes.
+static GstMemory* build_sei(const SplashLatencyProbe *p, const guint8 *vcl_header){
+  guint8 rbsp[2 + PROBE_PAYLOAD_BYTES + 1];
+  guint8 *q = rbsp;
+  *q++ = SEI_USER_DATA_UNREG;
+  *q++ = (guint8)PROBE_PAYLOAD_BYTES;
+  memcpy(q, probe_uuid, sizeof(probe_uuid));
+  q += sizeof(probe_uuid);
+  q[0] = PROBE_VERSION;
+  q[1] = p->seq;
+  put_be(q + 2, 0, 2);
+  put_be(q + 4, p->switches, 4);
+  put_be(q + 8, p->frame, 8);
+  put_be(q + 16, (guint64)p->send_us, 8);
+  put_be(q + 24, p->pts, 8);
+  q += PROBE_FIELD_BYTES;
+  *q++ = 0x80; // rbsp_trailing_bits
+
+  gsize cap = 3 + 2 + sizeof(rbsp) * 3 / 2 + 1;
+  guint8 *out = g_malloc(cap);
+  gsize n = 0;
+  out[n++] = 0; out[n++] = 0; out[n++] = 1;
+  // Same layer and temporal sub-layer as the picture it precedes
+  out[n++] = (guint8)((NAL_TYPE_PREFIX_SEI << 1) | (vcl_header[0] & 1));
+  out[n++] = vcl_header[1];
+  int zeros = 0;
+  for (gsize i = 0; i < sizeof(rbsp); ++i) {
+    if (zeros >= 2 && rbsp[i] <= 3) {
+      out[n++] = 3;
+      zeros = 0;
+    }
+    out[n++] = rbsp[i];
+    zeros = rbsp[i] == 0 ? zeros + 1 : 0;
+  }
+  return gst_memory_new_wrapped(0, out, cap, 0, n, out, g_free);
+}
+
+GstBuffer* splash_sei_insert_probe(GstBuffer *buf, const SplashLatencyProbe *p){
+  GstMapInfo map;
+  if (!buf || !p || !gst_buffer_map(buf, &map, GST_MAP_READ)) return buf;
+  gsize at = map.size;
+  guint8 vcl_header[2] = { 0, 0 };
+  gsize sc = splash_scan_next(map.data, 0, map.size);
+  while (sc < map.size) {
+    gsize nal = sc + 3;
+    if (nal + 2 <= map.size && ((map.data[nal] >> 1) & 0x3f) < NAL_TYPE_VCL_LIMIT) {
+      at = sc > 0 && map.data[sc - 1] == 0 ? sc - 1 : sc; // 4-byte start code
+      memcpy(vcl_header, map.data + nal, 2);
+      break;
+    }
+    sc = splash_scan_next(map.data, nal, map.size);
+  }
+  gsize size = map.size;
+  gst_buffer_unmap(buf, &map);
+  if (at == size) return buf;
+
+  GstBuffer *out = gst_buffer_new();
+  gst_buffer_copy_into(out, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  if (at > 0) gst_buffer_copy_into(out, buf, GST_BUFFER_COPY_MEMORY, 0, at);
+  gst_buffer_append_memory(out, build_sei(p, vcl_header));
+  gst_buffer_copy_into(out, buf, GST_BUFFER_COPY_MEMORY, at, size - at);
+  gst_buffer_unref(buf);
+  return out;
+}
+
+// Walks the SEI messages of one prefix SEI NAL unit (header excluded).
+static gboolean parse_sei(const guint8 *data, gsize len, SplashLatencyProbe *out){
+  guint8 *rbsp = g_malloc(len);
+  gsize n = 0;
+  int zeros = 0;
+  for (gsize i = 0; i < len; ++i) {
+    if (zeros >= 2 && data[i] == 3) {
+      zeros = 0;
+      continue;
+    }
+    rbsp[n++] = data[i];
+    zeros = data[i] == 0 ? zeros + 1 : 0;
+  }
+  gboolean found = FALSE;
+  gsize pos = 0;
+  while (!found && pos < n && rbsp[pos] != 0x80) {
+    guint type = 0, size = 0;
+    while (pos < n && rbsp[pos] == 0xff) { type += 255; pos++; }
+    if (pos >= n) break;
+    type += rbsp[pos++];
+    while (pos < n && rbsp[pos] == 0xff) { size += 255; pos++; }
+    if (pos >= n) break;
+    size += rbsp[pos++];
+    if (size > n - pos) break;
+    const guint8 *q = rbsp + pos;
+    if (type == SEI_USER_DATA_UNREG && size >= PROBE_PAYLOAD_BYTES &&
+        !memcmp(q, probe_uuid, sizeof(probe_uuid)) && q[sizeof(probe_uuid)] == PROBE_VERSION) {
+      q += sizeof(probe_uuid);
+      out->seq = q[1];
+      out->switches = (guint32)get_be(q + 4, 4);
+      out->frame = get_be(q + 8, 8);
+      out->send_us = (gint64)get_be(q + 16, 8);
+      out->pts = get_be(q + 24, 8);
+      found = TRUE;
+    }
+    pos += size;
+  }
+  g_free(rbsp);
+  return found;
+}
+
+gboolean splash_sei_find_probe(const guint8 *au, gsize len, SplashLatencyProbe *out){
+  if (!au || !out) return FALSE;
+  gsize sc = splash_scan_next(au, 0, len);
+  while (sc < len) {
+    gsize nal = sc + 3;
+    gsize next = splash_scan_next(au, nal, len);
+    gsize end = next;
+    while (end > nal && au[end - 1] == 0) end--; // zero_byte / trailing_zero_8bits
+    if (end >= nal + 2 && ((au[nal] >> 1) & 0x3f) == NAL_TYPE_PREFIX_SEI &&
+        parse_sei(au + nal + 2, end - nal - 2, out)) {
+      return TRUE;
+    }
+    sc = next;
+  }
+  return FALSE;
+}
@@ -0,0 +1,34 @@
+#ifndef SPLASHSEI_H
+#define SPLASHSEI_H
+
+#include <gst/gst.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Latency probes: a prefix SEI NAL unit (user_data_unregistered, payload
+// type 5) added to each access unit just before its first VCL NAL unit. It
+// carries the send time and a frame counter so a receiver (splash_rx) can
+// measure end-to-end latency and spot missing frames. Decoders skip it.
+
+typedef struct {
+  guint64 frame;      // frames sent since splash_start(), from 0
+  gint64  send_us;    // wall-clock send time (g_get_real_time())
+  guint64 pts;        // buffer PTS in ns
+  guint32 switches;   // active sequence changes since splash_start()
+  guint8  seq;        // active sequence index
+} SplashLatencyProbe;
+
+// Returns buf (consumed) with the probe SEI inserted before its first VCL
+// NAL unit; the payload memory is shared, only the SEI is new. AUs without
+// VCL NAL units are returned unchanged.
+GstBuffer* splash_sei_insert_probe(GstBuffer *buf, const SplashLatencyProbe *p);
+
+// Looks for a probe SEI in an Annex-B access unit.
+gboolean splash_sei_find_probe(const guint8 *au, gsize len, SplashLatencyProbe *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
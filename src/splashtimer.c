@@ -0,0 +1,103 @@
+#include "splashtimer.h"
+
+struct SplashTimerHeap {
+  GArray *items;    // SplashTimer, heap-ordered
+  guint next_id;
+};
+
+#define AT(h, i) g_array_index((h)->items, SplashTimer, (i))
+
+// Earlier due time first; ties keep insertion order (ids increase).
+static gboolean before(const SplashTimer *a, const SplashTimer *b){
+  return a->due_us < b->due_us || (a->due_us == b->due_us && a->id < b->id);
+}
+
+static void swap(SplashTimerHeap *h, guint i, guint j){
+  SplashTimer t = AT(h, i);
+  AT(h, i) = AT(h, j);
+  AT(h, j) = t;
+}
+
+static void sift_up(SplashTimerHeap *h, guint i){
+  while (i > 0) {
+    guint parent = (i - 1) / 2;
+    if (!before(&AT(h, i), &AT(h, parent))) break;
+    swap(h, i, parent);
+    i = parent;
+  }
+}
+
+static void sift_down(SplashTimerHeap *h, guint i){
+  guint n = h->items->len;
+  for (;;) {
+    guint l = 2 * i + 1, r = l + 1, m = i;
+    if (l < n && before(&AT(h, l), &AT(h, m))) m = l;
+    if (r < n && before(&AT(h, r), &AT(h, m))) m = r;
+    if (m == i) break;
+    swap(h, i, m);
+    i = m;
+  }
+}
+
+static void remove_at(SplashTimerHeap *h, guint i){
+  guint last = h->items->len - 1;
+  if (i != last) {
+    AT(h, i) = AT(h, last);
+    g_array_set_size(h->items, last);
+    sift_down(h, i);
+    sift_up(h, i);
+  } else {
+    g_array_set_size(h->items, last);
+  }
+}
+
+SplashTimerHeap* splash_timers_new(void){
+  SplashTimerHeap *h = g_new0(SplashTimerHeap, 1);
+  h->items = g_array_new(FALSE, FALSE, sizeof(SplashTimer));
+  h->next_id = 1;
+  return h;
+}
+
+void splash_timers_free(SplashTimerHeap *h){
+  if (!h) return;
+  g_array_free(h->items, TRUE);
+  g_free(h);
+}
+
+guint splash_timers_add(SplashTimerHeap *h, gint64 due_us, int seq){
+  SplashTimer t = { due_us, h->next_id++, seq };
+  if (h->next_id == 0) h->next_id = 1;
+  g_array_append_val(h->items, t);
+  sift_up(h, h->items->len - 1);
+  return t.id;
+}
+
+gboolean splash_timers_peek(const SplashTimerHeap *h, SplashTimer *out){
+  if (!h || h->items->len == 0) return FALSE;
+  *out = AT(h, 0);
+  return TRUE;
+}
+
+gboolean splash_timers_pop(SplashTimerHeap *h, SplashTimer *out){
+  if (!splash_timers_peek(h, out)) return FALSE;
+  remove_at(h, 0);
+  return TRUE;
+}
+
+gboolean splash_timers_cancel(SplashTimerHeap *h, guint id){
+  for (guint i = 0; i < h->items->len; ++i) {
+    if (AT(h, i).id == id) {
+      remove_at(h, i);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+void splash_timers_clear(SplashTimerHeap *h){
+  g_array_set_size(h->items, 0);
+}
+
+guint splash_timers_count(const SplashTimerHeap *h){
+  return h ? h->items->len : 0;
+}
@@ -0,0 +1,35 @@
+#ifndef SPLASHTIMER_H
+#define SPLASHTIMER_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pending scheduled switches, ordered by due time in a binary min-heap:
+// O(log n) insert and pop, O(1) peek, O(n) cancel by id. Not thread-safe;
+// the engine guards it with its lock.
+
+typedef struct {
+  gint64 due_us;    // g_get_monotonic_time() base
+  guint  id;
+  int    seq;       // sequence index to switch to
+} SplashTimer;
+
+typedef struct SplashTimerHeap SplashTimerHeap;
+
+SplashTimerHeap* splash_timers_new(void);
+void     splash_timers_free(SplashTimerHeap *h);
+// Returns the new timer's id (never 0).
+guint    splash_timers_add(SplashTimerHeap *h, gint64 due_us, int seq);
+gboolean splash_timers_peek(const SplashTimerHeap *h, SplashTimer *out);
+gboolean splash_timers_pop(SplashTimerHeap *h, SplashTimer *out);
+gboolean splash_timers_cancel(SplashTimerHeap *h, guint id);
+void     splash_timers_clear(SplashTimerHeap *h);
+guint    splash_timers_count(const SplashTimerHeap *h);
+
+#ifdef __cplusplus
+}
+#endif
+#endif